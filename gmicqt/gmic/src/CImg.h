@@ -170,6 +170,7 @@
 #include <sys/types.h>
 #include <sys/time.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <dirent.h>
@@ -7564,6 +7565,12 @@ namespace cimg_library {
     // Get/set path to the \c wget binary.
     inline const char *wget_path(const char *const user_path=0, const bool reinit_path=false);
 
+    // Set/get out-of-core storage mode for large image buffers.
+    inline void mmap_mode(const cimg_ulong threshold, const char *const path=0);
+    inline cimg_ulong mmap_threshold();
+    inline void *_mmap_alloc(const cimg_ulong size);
+    inline bool _mmap_free(void *const ptr);
+
 #if cimg_OS==2
     // Get/set path to the \c powershell binary.
     inline const char *powershell_path(const char *const user_path=0, const bool reinit_path=false);
@@ -11967,7 +11974,20 @@ namespace cimg_library {
          (to a deallocated buffer).
     **/
     ~CImg() {
-      if (!_is_shared) delete[] _data;
+      if (!_is_shared) _delete_data(_data);
+    }
+
+    // Allocate/deallocate pixel buffer (possibly stored out-of-core, see cimg::mmap_mode()).
+    static T *_new_data(const size_t siz) {
+      if (cimg::mmap_threshold() && std::strncmp(cimg::type<T>::string(),"unknown",7)) {
+        void *const ptr = cimg::_mmap_alloc((cimg_ulong)siz*sizeof(T));
+        if (ptr) return (T*)ptr;
+      }
+      return new T[siz];
+    }
+
+    static void _delete_data(T *const data) {
+      if (!cimg::_mmap_free(data)) delete[] data;
     }
 
     //! Construct empty image.
@@ -12018,7 +12038,7 @@ namespace cimg_library {
       const size_t siz = safe_size(size_x,size_y,size_z,size_c);
       if (siz) {
         _width = size_x; _height = size_y; _depth = size_z; _spectrum = size_c;
-        try { _data = new T[siz]; } catch (...) {
+        try { _data = _new_data(siz); } catch (...) {
           _width = _height = _depth = _spectrum = 0; _data = 0;
           throw CImgInstanceException(_cimg_instance
                                       "CImg(): Failed to allocate memory (%s) for image (%u,%u,%u,%u).",
@@ -12050,7 +12070,7 @@ namespace cimg_library {
       const size_t siz = safe_size(size_x,size_y,size_z,size_c);
       if (siz) {
         _width = size_x; _height = size_y; _depth = size_z; _spectrum = size_c;
-        try { _data = new T[siz]; } catch (...) {
+        try { _data = _new_data(siz); } catch (...) {
           _width = _height = _depth = _spectrum = 0; _data = 0;
           throw CImgInstanceException(_cimg_instance
                                       "CImg(): Failed to allocate memory (%s) for image (%u,%u,%u,%u).",
@@ -12275,7 +12295,7 @@ namespace cimg_library {
       const size_t siz = safe_size(size_x,size_y,size_z,size_c);
       if (siz) {
         _width = size_x; _height = size_y; _depth = size_z; _spectrum = size_c;
-        try { _data = new T[siz]; } catch (...) {
+        try { _data = _new_data(siz); } catch (...) {
           _width = _height = _depth = _spectrum = 0; _data = 0;
           throw CImgInstanceException(_cimg_instance
                                       "CImg(): Failed to allocate memory (%s) for image (%u,%u,%u,%u).",
@@ -12331,7 +12351,7 @@ namespace cimg_library {
       const size_t siz = safe_size(size_x,size_y,size_z,size_c);
       if (values && siz) {
         _width = size_x; _height = size_y; _depth = size_z; _spectrum = size_c;
-        try { _data = new T[siz]; } catch (...) {
+        try { _data = _new_data(siz); } catch (...) {
           _width = _height = _depth = _spectrum = 0; _data = 0;
           throw CImgInstanceException(_cimg_instance
                                       "CImg(): Failed to allocate memory (%s) for image (%u,%u,%u,%u).",
@@ -12352,7 +12372,7 @@ namespace cimg_library {
         _width = size_x; _height = size_y; _depth = size_z; _spectrum = size_c; _is_shared = is_shared;
         if (_is_shared) _data = const_cast<T*>(values);
         else {
-          try { _data = new T[siz]; } catch (...) {
+          try { _data = _new_data(siz); } catch (...) {
             _width = _height = _depth = _spectrum = 0; _data = 0;
             throw CImgInstanceException(_cimg_instance
                                         "CImg(): Failed to allocate memory (%s) for image (%u,%u,%u,%u).",
@@ -12468,7 +12488,7 @@ namespace cimg_library {
       const size_t siz = (size_t)img.size();
       if (img._data && siz) {
         _width = img._width; _height = img._height; _depth = img._depth; _spectrum = img._spectrum;
-        try { _data = new T[siz]; } catch (...) {
+        try { _data = _new_data(siz); } catch (...) {
           _width = _height = _depth = _spectrum = 0; _data = 0;
           throw CImgInstanceException(_cimg_instance
                                       "CImg(): Failed to allocate memory (%s) for image (%u,%u,%u,%u).",
@@ -12488,7 +12508,7 @@ namespace cimg_library {
         _is_shared = img._is_shared;
         if (_is_shared) _data = const_cast<T*>(img._data);
         else {
-          try { _data = new T[siz]; } catch (...) {
+          try { _data = _new_data(siz); } catch (...) {
             _width = _height = _depth = _spectrum = 0; _data = 0;
             throw CImgInstanceException(_cimg_instance
                                         "CImg(): Failed to allocate memory (%s) for image (%u,%u,%u,%u).",
@@ -12530,7 +12550,7 @@ namespace cimg_library {
       const size_t siz = (size_t)img.size();
       if (img._data && siz) {
         _width = img._width; _height = img._height; _depth = img._depth; _spectrum = img._spectrum;
-        try { _data = new T[siz]; } catch (...) {
+        try { _data = _new_data(siz); } catch (...) {
           _width = _height = _depth = _spectrum = 0; _data = 0;
           throw CImgInstanceException(_cimg_instance
                                       "CImg(): Failed to allocate memory (%s) for image (%u,%u,%u,%u).",
@@ -12550,7 +12570,7 @@ namespace cimg_library {
         _is_shared = is_shared;
         if (_is_shared) _data = const_cast<T*>(img._data);
         else {
-          try { _data = new T[siz]; } catch (...) {
+          try { _data = _new_data(siz); } catch (...) {
             _width = _height = _depth = _spectrum = 0; _data = 0;
             throw CImgInstanceException(_cimg_instance
                                         "CImg(): Failed to allocate memory (%s) for image (%u,%u,%u,%u).",
@@ -12637,7 +12657,7 @@ namespace cimg_library {
        In-place version of the default constructor CImg(). It simply resets the instance to an empty image.
     **/
     CImg<T>& assign() {
-      if (!_is_shared) delete[] _data;
+      if (!_is_shared) _delete_data(_data);
       _width = _height = _depth = _spectrum = 0; _is_shared = false; _data = 0;
       return *this;
     }
@@ -12659,8 +12679,8 @@ namespace cimg_library {
                                       cimg_instance,
                                       size_x,size_y,size_z,size_c);
         else {
-          delete[] _data;
-          try { _data = new T[siz]; } catch (...) {
+          _delete_data(_data);
+          try { _data = _new_data(siz); } catch (...) {
             _width = _height = _depth = _spectrum = 0; _data = 0;
             throw CImgInstanceException(_cimg_instance
                                         "assign(): Failed to allocate memory (%s) for image (%u,%u,%u,%u).",
@@ -12744,7 +12764,7 @@ namespace cimg_library {
         else std::memcpy((void*)_data,(void*)values,siz*sizeof(T));
       } else {
         T *new_data = 0;
-        try { new_data = new T[siz]; } catch (...) {
+        try { new_data = _new_data(siz); } catch (...) {
           _width = _height = _depth = _spectrum = 0; _data = 0;
           throw CImgInstanceException(_cimg_instance
                                       "assign(): Failed to allocate memory (%s) for image (%u,%u,%u,%u).",
@@ -12753,7 +12773,7 @@ namespace cimg_library {
                                       size_x,size_y,size_z,size_c);
         }
         std::memcpy((void*)new_data,(void*)values,siz*sizeof(T));
-        delete[] _data; _data = new_data; _width = size_x; _height = size_y; _depth = size_z; _spectrum = size_c;
+        _delete_data(_data); _data = new_data; _width = size_x; _height = size_y; _depth = size_z; _spectrum = size_c;
       }
       return *this;
     }
@@ -16969,6 +16989,19 @@ namespace cimg_library {
     //-------------------------------------
 
     // Define the math formula parser/compiler and expression evaluator.
+    // Maximal number of compiled math expressions kept in cache (set to '0' to disable cache).
+#ifndef cimg_mp_cache_size
+#define cimg_mp_cache_size 64
+#endif
+    // Enable peephole optimization of compiled math expressions (set to '0' to disable).
+#ifndef cimg_mp_optimize
+#define cimg_mp_optimize 1
+#endif
+    // Print opcode counts and evaluation timings of math expressions used in 'fill()' (set to '1' to enable).
+#ifndef cimg_mp_profile
+#define cimg_mp_profile 0
+#endif
+
     struct _cimg_math_parser {
       CImg<doubleT> mem;
       CImg<intT> memtype, memmerge;
@@ -16993,10 +17026,14 @@ namespace cimg_library {
 
       unsigned int mempos, mem_img_median, mem_img_norm, mem_img_index, debug_indent,
         result_dim, result_end_dim, break_type, constcache_size;
-      bool is_parallelizable, is_noncritical_run, is_end_code, is_fill, need_input_copy, return_comp;
+      bool is_parallelizable, is_noncritical_run, is_end_code, is_fill, need_input_copy, return_comp, is_cacheable;
       double *result, *result_end;
       cimg_uint64 rng;
       const char *const calling_function, *s_op, *ss_op;
+      CImg<ulongT> batch_code;
+      CImg<uintT> batch_inputs, batch_outputs;
+      CImg<doubleT> batch_mem;
+      int batch_state;
       typedef double (*mp_func)(_cimg_math_parser&);
 
 #define _cimg_mp_calling_function s_calling_function()._data
@@ -17049,8 +17086,8 @@ namespace cimg_library {
         img_stats(_img_stats),list_stats(_list_stats),list_median(_list_median),list_norm(_list_norm),user_macro(0),
         mem_img_median(~0U),mem_img_norm(~0U),mem_img_index(~0U),debug_indent(0),result_dim(0),result_end_dim(0),
         break_type(0),constcache_size(0),is_parallelizable(true),is_noncritical_run(false),is_fill(_is_fill),
-        need_input_copy(false),result_end(0),rng((cimg::_rand(),cimg::rng())),
-        calling_function(funcname?funcname:"cimg_math_parser") {
+        need_input_copy(false),is_cacheable(true),result_end(0),rng((cimg::_rand(),cimg::rng())),
+        calling_function(funcname?funcname:"cimg_math_parser"),batch_state(-1) {
 
 #if cimg_use_openmp!=0
         rng+=omp_get_thread_num();
@@ -17066,17 +17103,6 @@ namespace cimg_library {
         while (ps>expr._data && (cimg::is_blank(*ps) || *ps==';')) --ps;
         *(++ps) = 0; expr._width = (unsigned int)(ps - expr._data + 1);
 
-        // Ease the retrieval of previous non-space characters afterwards.
-        pexpr.assign(expr._width);
-        char c, *pe = pexpr._data;
-        for (ps = expr._data, c = ' '; *ps; ++ps) {
-          if (!cimg::is_blank(*ps)) c = *ps; else *ps = ' ';
-          *(pe++) = c;
-        }
-        *pe = 0;
-        level = get_level(expr);
-
-        // Init constant values.
 #define _cimg_mp_interpolation (reserved_label[31]!=~0U?reserved_label[31]:0)
 #define _cimg_mp_boundary (reserved_label[32]!=~0U?reserved_label[32]:0)
 #define _cimg_mp_slot_t 17
@@ -17086,53 +17112,77 @@ namespace cimg_library {
 #define _cimg_mp_slot_z 33
 #define _cimg_mp_slot_c 34
 
-        mem.assign(96);
-        for (unsigned int i = 0; i<=10; ++i) mem[i] = (double)i; // mem[0-10] = 0...10
-        for (unsigned int i = 1; i<=5; ++i) mem[i + 10] = -(double)i; // mem[11-15] = -1...-5
-        mem[16] = 0.5;
-        mem[_cimg_mp_slot_t] = 0; // thread_id
-        mem[18] = (double)imgin._width; // w
-        mem[19] = (double)imgin._height; // h
-        mem[20] = (double)imgin._depth; // d
-        mem[21] = (double)imgin._spectrum; // s
-        mem[22] = (double)imgin._is_shared; // r
-        mem[23] = (double)imgin._width*imgin._height; // wh
-        mem[24] = (double)imgin._width*imgin._height*imgin._depth; // whd
-        mem[25] = (double)imgin._width*imgin._height*imgin._depth*imgin._spectrum; // whds
-        mem[26] = (double)imglist._width; // l
-        mem[27] = std::exp(1.); // e
-        mem[28] = cimg::PI; // pi
-        mem[29] = DBL_EPSILON; // eps
-        mem[_cimg_mp_slot_nan] = cimg::type<double>::nan(); // nan
-
-        // Type property for each value in memory :
-        // { -1 = reserved (e.g. variable) | 0 = computation scalar |
-        //    1 = compile-time constant | N>1 = start of a vector(#N-1) }.
-        memtype.assign(mem._width,1,1,1,0);
-        for (unsigned int i = 0; i<_cimg_mp_slot_x; ++i) memtype[i] = 1;
-        memtype[_cimg_mp_slot_t] = memtype[_cimg_mp_slot_x] = memtype[_cimg_mp_slot_y] =
-          memtype[_cimg_mp_slot_z] = memtype[_cimg_mp_slot_c] = -1;
-        mempos = _cimg_mp_slot_c + 1;
-        variable_pos.assign(8);
-
-        reserved_label.assign(128,1,1,1,~0U);
-        // reserved_label[0-32] are used to store the memory index of these variables:
-        // [0] = wh, [1] = whd, [2] = whds, [3] = pi, [4] = im, [5] = iM, [6] = ia, [7] = iv, [8] = id,
-        // [9] = is, [10] = ip, [11] = ic, [12] = in, [13] = xm, [14] = ym, [15] = zm, [16] = cm, [17] = xM,
-        // [18] = yM, [19] = zM, [20] = cM, [21] = i0...[30] = i9, [31] = interpolation, [32] = boundary, [33] = eps
-
-        // Compile expression into a sequence of opcodes.
-        s_op = ""; ss_op = expr._data;
-        const unsigned int ind_result = compile(expr._data,expr._data + expr._width - 1,0,0,0);
-        if (!is_const_scalar(ind_result)) {
-          if (is_vector(ind_result))
-            CImg<doubleT>(&mem[ind_result] + 1,size(ind_result),1,1,1,true).
-              fill(cimg::type<double>::nan());
-          else if (ind_result!=_cimg_mp_slot_t) mem[ind_result] = cimg::type<double>::nan();
-        }
-        if (mem._width>=256 && mem._width - mempos>=mem._width/2) mem.resize(mempos,1,1,1,-1);
-        result_dim = size(ind_result);
-        result = mem._data + ind_result;
+        // Retrieve compiled program from cache if available, otherwise compile expression.
+        cimg_uint64 hash = 0;
+        const CImg<charT> key = program_key(hash);
+        if (!load_program(key,hash)) {
+          // Ease the retrieval of previous non-space characters afterwards.
+          pexpr.assign(expr._width);
+          char c, *pe = pexpr._data;
+          for (ps = expr._data, c = ' '; *ps; ++ps) {
+            if (!cimg::is_blank(*ps)) c = *ps; else *ps = ' ';
+            *(pe++) = c;
+          }
+          *pe = 0;
+          level = get_level(expr);
+
+          // Init constant values.
+          mem.assign(96);
+          for (unsigned int i = 0; i<=10; ++i) mem[i] = (double)i; // mem[0-10] = 0...10
+          for (unsigned int i = 1; i<=5; ++i) mem[i + 10] = -(double)i; // mem[11-15] = -1...-5
+          mem[16] = 0.5;
+          mem[_cimg_mp_slot_t] = 0; // thread_id
+          mem[18] = (double)imgin._width; // w
+          mem[19] = (double)imgin._height; // h
+          mem[20] = (double)imgin._depth; // d
+          mem[21] = (double)imgin._spectrum; // s
+          mem[22] = (double)imgin._is_shared; // r
+          mem[23] = (double)imgin._width*imgin._height; // wh
+          mem[24] = (double)imgin._width*imgin._height*imgin._depth; // whd
+          mem[25] = (double)imgin._width*imgin._height*imgin._depth*imgin._spectrum; // whds
+          mem[26] = (double)imglist._width; // l
+          mem[27] = std::exp(1.); // e
+          mem[28] = cimg::PI; // pi
+          mem[29] = DBL_EPSILON; // eps
+          mem[_cimg_mp_slot_nan] = cimg::type<double>::nan(); // nan
+
+          // Type property for each value in memory :
+          // { -1 = reserved (e.g. variable) | 0 = computation scalar |
+          //    1 = compile-time constant | N>1 = start of a vector(#N-1) }.
+          memtype.assign(mem._width,1,1,1,0);
+          for (unsigned int i = 0; i<_cimg_mp_slot_x; ++i) memtype[i] = 1;
+          memtype[_cimg_mp_slot_t] = memtype[_cimg_mp_slot_x] = memtype[_cimg_mp_slot_y] =
+            memtype[_cimg_mp_slot_z] = memtype[_cimg_mp_slot_c] = -1;
+          mempos = _cimg_mp_slot_c + 1;
+          variable_pos.assign(8);
+
+          reserved_label.assign(128,1,1,1,~0U);
+          // reserved_label[0-32] are used to store the memory index of these variables:
+          // [0] = wh, [1] = whd, [2] = whds, [3] = pi, [4] = im, [5] = iM, [6] = ia, [7] = iv, [8] = id,
+          // [9] = is, [10] = ip, [11] = ic, [12] = in, [13] = xm, [14] = ym, [15] = zm, [16] = cm, [17] = xM,
+          // [18] = yM, [19] = zM, [20] = cM, [21] = i0...[30] = i9, [31] = interpolation, [32] = boundary, [33] = eps
+
+          // Compile expression into a sequence of opcodes.
+          s_op = ""; ss_op = expr._data;
+          const unsigned int ind_result = compile(expr._data,expr._data + expr._width - 1,0,0,0);
+          if (!is_const_scalar(ind_result)) {
+            if (is_vector(ind_result))
+              CImg<doubleT>(&mem[ind_result] + 1,size(ind_result),1,1,1,true).
+                fill(cimg::type<double>::nan());
+            else if (ind_result!=_cimg_mp_slot_t) mem[ind_result] = cimg::type<double>::nan();
+          }
+#if cimg_mp_optimize!=0
+          optimize(ind_result);
+#endif
+          if (mem._width>=256 && mem._width - mempos>=mem._width/2) { // Keep 'result_end' valid after resize
+            const ulongT off_result_end = result_end?(ulongT)(result_end - mem._data):0;
+            mem.resize(mempos,1,1,1,-1);
+            if (result_end) result_end = mem._data + off_result_end;
+          }
+          result_dim = size(ind_result);
+          result = mem._data + ind_result;
+          if (is_cacheable) save_program(key,hash);
+        }
 
         // Free resources used for compiling expression and prepare evaluation.
         memtype.assign();
@@ -17165,8 +17215,8 @@ namespace cimg_library {
         imgin(CImg<T>::const_empty()),imgout(CImg<T>::empty()),imglist(CImgList<T>::empty()),
         img_stats(_img_stats),list_stats(_list_stats),list_median(_list_median),list_norm(_list_norm),debug_indent(0),
         result_dim(0),result_end_dim(0),break_type(0),constcache_size(0),is_parallelizable(true),
-        is_noncritical_run(false),is_fill(false),need_input_copy(false),
-        result_end(0),rng(0),calling_function(0) {
+        is_noncritical_run(false),is_fill(false),need_input_copy(false),is_cacheable(false),
+        result_end(0),rng(0),calling_function(0),batch_state(0) {
         mem.assign(1 + _cimg_mp_slot_c,1,1,1,0); // Allow to skip 'is_empty?' test in operator()()
         result = mem._data;
       }
@@ -17178,10 +17228,12 @@ namespace cimg_library {
         img_stats(mp.img_stats),list_stats(mp.list_stats),list_median(mp.list_median),list_norm(mp.list_norm),
         debug_indent(0),result_dim(mp.result_dim),result_end_dim(mp.result_end_dim),break_type(0),constcache_size(0),
         is_parallelizable(mp.is_parallelizable),is_noncritical_run(mp.is_noncritical_run),is_fill(mp.is_fill),
-        need_input_copy(mp.need_input_copy),
+        need_input_copy(mp.need_input_copy),is_cacheable(false),
         result(mem._data + (mp.result - mp.mem._data)),
         result_end(mp.result_end?mem._data + (mp.result_end - mp.mem._data):0),
-        rng((cimg::_rand(),cimg::rng())),calling_function(0) {
+        rng((cimg::_rand(),cimg::rng())),calling_function(0),
+        batch_code(mp.batch_code),batch_inputs(mp.batch_inputs),batch_outputs(mp.batch_outputs),
+        batch_state(mp.batch_state) {
 
 #if cimg_use_openmp!=0
         mem[_cimg_mp_slot_t] = (double)omp_get_thread_num();
@@ -17191,6 +17243,114 @@ namespace cimg_library {
         opcode._is_shared = true;
       }
 
+      // Cache of compiled programs (shared by all math parsers of a same pixel type).
+      // A compiled program only depends on the expression and on the dimensions of the attached images,
+      // unless image values, a specific image of the list or an external variable are read at compile time
+      // (then 'is_cacheable' is set to 'false').
+      struct _cimg_mp_program {
+        CImg<charT> key;
+        cimg_uint64 hash, last_use;
+        CImg<doubleT> mem;
+        CImg<intT> memmerge;
+        CImgList<ulongT> code, code_begin, code_end, code_begin_t, code_end_t;
+        unsigned int result_dim, result_end_dim;
+        ulongT off_result, off_result_end;
+        bool is_parallelizable, need_input_copy;
+        _cimg_mp_program():hash(0),last_use(0) {}
+      };
+
+      static _cimg_mp_program *programs() { // Must be called with 'cimg::mutex(16)' locked
+        static _cimg_mp_program _programs[cimg_mp_cache_size?cimg_mp_cache_size:1];
+        return _programs;
+      }
+
+      static cimg_uint64& programs_clock() { // Must be called with 'cimg::mutex(16)' locked
+        static cimg_uint64 clock = 0;
+        return clock;
+      }
+
+      // Return key of current expression for cache lookup.
+      CImg<charT> program_key(cimg_uint64 &hash) const {
+        CImg<charT> key(expr._width + 128);
+        const int l = cimg_snprintf(key,128,"%u,%u,%u,%u,%d,%d,%u:",
+                                    imgin._width,imgin._height,imgin._depth,imgin._spectrum,
+                                    (int)imgin._is_shared,(int)imgout.is_empty(),imglist._width);
+        std::memcpy(key._data + l,expr._data,expr._width);
+        key._width = l + expr._width;
+        hash = 14695981039346656037ULL; // FNV-1a
+        cimg_for(key,ptrs,charT) { hash^=(unsigned char)*ptrs; hash*=1099511628211ULL; }
+        return key;
+      }
+
+      // Retrieve compiled program from cache.
+      bool load_program(const CImg<charT>& key, const cimg_uint64 hash) {
+        if (!cimg_mp_cache_size) return false;
+        bool is_found = false;
+        cimg::mutex(16);
+        _cimg_mp_program *const _programs = programs();
+        for (unsigned int k = 0; k<cimg_mp_cache_size; ++k) {
+          _cimg_mp_program &program = _programs[k];
+          if (program.hash==hash && program.key._width==key._width &&
+              !std::memcmp(program.key._data,key._data,key._width)) {
+            program.last_use = ++programs_clock();
+            mem.assign(program.mem);
+            memmerge.assign(program.memmerge);
+            _code.assign(program.code);
+            code_begin.assign(program.code_begin);
+            code_end.assign(program.code_end);
+            _code_begin_t.assign(program.code_begin_t);
+            _code_end_t.assign(program.code_end_t);
+            result_dim = program.result_dim;
+            result_end_dim = program.result_end_dim;
+            result = mem._data + program.off_result;
+            result_end = program.off_result_end!=~(ulongT)0?mem._data + program.off_result_end:0;
+            is_parallelizable = program.is_parallelizable;
+            need_input_copy = program.need_input_copy;
+            is_found = true;
+            break;
+          }
+        }
+        cimg::mutex(16,0);
+        return is_found;
+      }
+
+      // Insert compiled program in cache (replace least recently used one).
+      void save_program(const CImg<charT>& key, const cimg_uint64 hash) const {
+        if (!cimg_mp_cache_size) return;
+        cimg_uint64 siz = mem._width + memmerge.size();
+        cimglist_for(code,l) siz+=code[l].size();
+        if (siz>262144) return; // Do not cache very large programs
+        cimg::mutex(16);
+        _cimg_mp_program *const _programs = programs();
+        unsigned int ind = 0;
+        for (unsigned int k = 1; k<cimg_mp_cache_size; ++k)
+          if (_programs[k].last_use<_programs[ind].last_use) ind = k;
+        _cimg_mp_program &program = _programs[ind];
+        program.key.assign(key);
+        program.hash = hash;
+        program.last_use = ++programs_clock();
+        program.mem.assign(mem);
+        program.memmerge.assign(memmerge);
+        program.code.assign(code);
+        program.code_begin.assign(code_begin);
+        program.code_end.assign(code_end);
+        program.code_begin_t.assign(code_begin_t);
+        program.code_end_t.assign(code_end_t);
+        program.result_dim = result_dim;
+        program.result_end_dim = result_end_dim;
+        program.off_result = (ulongT)(result - mem._data);
+        program.off_result_end = result_end?(ulongT)(result_end - mem._data):~(ulongT)0;
+        program.is_parallelizable = is_parallelizable;
+        program.need_input_copy = need_input_copy;
+        cimg::mutex(16,0);
+      }
+
+      // Return image of the list, at compile time.
+      const CImg<T>& list_image(const unsigned int ind) {
+        is_cacheable = false; // Compiled code depends on properties of a specific image
+        return imglist[ind];
+      }
+
       // Compilation procedure.
       unsigned int compile(char *ss, char *se, const unsigned int depth, unsigned int *const p_ref,
                            unsigned char block_flags) {
@@ -17380,6 +17540,7 @@ namespace cimg_library {
             case 'a' : arg1 = 6; arg2 = 2; break; // ia
             case 'c' : // ic
               if (reserved_label[11]!=~0U) _cimg_mp_return(reserved_label[11]);
+              is_cacheable = false; // Depends on image values
               if (mem_img_median==~0U) mem_img_median = imgin?const_scalar(imgin.median()):0;
               _cimg_mp_return(mem_img_median);
               break;
@@ -17388,6 +17549,7 @@ namespace cimg_library {
             case 'M' : arg1 = 5; arg2 = 1; break; // iM
             case 'n' : // in
               if (reserved_label[12]!=~0U) _cimg_mp_return(reserved_label[12]);
+              is_cacheable = false; // Depends on image values
               if (mem_img_norm==~0U) mem_img_norm = imgin?const_scalar(imgin.magnitude(2)):0;
               _cimg_mp_return(mem_img_norm);
               break;
@@ -17410,6 +17572,7 @@ namespace cimg_library {
             }
           if (arg1!=~0U) {
             if (reserved_label[arg1]!=~0U) _cimg_mp_return(reserved_label[arg1]);
+            is_cacheable = false; // Depends on image values
             if (!img_stats) {
               img_stats.assign(1,14,1,1,0).fill(imgin.get_stats(),false);
               mem_img_stats.assign(1,14,1,1,~0U);
@@ -17480,7 +17643,7 @@ namespace cimg_library {
                   if (p1!=~0U) {
                     _cimg_mp_check_const_index(p1);
                     p3 = (unsigned int)cimg::mod((int)mem[p1],imglist.width());
-                    p2 = imglist[p3]._spectrum;
+                    p2 = list_image(p3)._spectrum;
                   } else p2 = imgin._spectrum;
                   if (!p2) _cimg_mp_return(0);
                   _cimg_mp_check_type(arg2,2,2,p2);
@@ -17565,7 +17728,7 @@ namespace cimg_library {
                   if (p1!=~0U) {
                     _cimg_mp_check_const_index(p1);
                     p3 = (unsigned int)cimg::mod((int)mem[p1],imglist.width());
-                    p2 = imglist[p3]._spectrum;
+                    p2 = list_image(p3)._spectrum;
                   } else p2 = imgin._spectrum;
                   if (!p2) _cimg_mp_return(0);
                   _cimg_mp_check_type(arg5,2,2,p2);
@@ -18898,7 +19061,7 @@ namespace cimg_library {
             if (p1==~0U) p2 = imgin._spectrum;
             else {
               p3 = (unsigned int)cimg::mod((int)mem[p1],imglist.width());
-              p2 = imglist[p3]._spectrum;
+              p2 = list_image(p3)._spectrum;
             }
             if (!p2) _cimg_mp_return(0);
             pos = vector(p2);
@@ -19067,7 +19230,7 @@ namespace cimg_library {
             if (p1==~0U) p2 = imgin._spectrum;
             else if (is_const_scalar(p1)) {
               p3 = (unsigned int)cimg::mod((int)mem[p1],imglist.width());
-              p2 = imglist[p3]._spectrum;
+              p2 = list_image(p3)._spectrum;
             }
             if (!p2) _cimg_mp_return(0);
             pos = vector(p2);
@@ -19725,7 +19888,7 @@ namespace cimg_library {
                     _cimg_mp_check_const_scalar(p1,1,1);
                     p2 = (unsigned int)cimg::mod((int)mem[p1],imglist.width());
                   }
-                  const CImg<T> &img = p1!=~0U?imglist[p2]:imgin;
+                  const CImg<T> &img = p1!=~0U?list_image(p2):imgin;
                   if (!img) {
                     _cimg_mp_strerr;
                     throw CImgArgumentException("[" cimg_appname "_math_parser] "
@@ -20082,7 +20245,7 @@ namespace cimg_library {
               _cimg_mp_check_list();
               _cimg_mp_check_const_scalar(p1,1,1);
               p3 = (unsigned int)cimg::mod((int)mem[p1],imglist.width());
-              p2 = imglist[p3]._spectrum;
+              p2 = list_image(p3)._spectrum;
               if (p2>1) pos = vector(p2); else pos = scalar(); // Return vector or scalar result
               CImg<ulongT>::vector((ulongT)mp_da_back_or_pop,pos,p2,p1,is_pop_heap?2:is_pop?1:0).move_to(code);
               return_comp = true;
@@ -23464,30 +23627,30 @@ namespace cimg_library {
           switch (*ss) {
           case 'w' : // w#ind
             if (!imglist) _cimg_mp_return(0);
-            if (p1!=~0U) _cimg_mp_const_scalar(imglist[p1]._width);
+            if (p1!=~0U) _cimg_mp_const_scalar(list_image(p1)._width);
             _cimg_mp_scalar1(mp_list_width,arg1);
           case 'h' : // h#ind
             if (!imglist) _cimg_mp_return(0);
-            if (p1!=~0U) _cimg_mp_const_scalar(imglist[p1]._height);
+            if (p1!=~0U) _cimg_mp_const_scalar(list_image(p1)._height);
             _cimg_mp_scalar1(mp_list_height,arg1);
           case 'd' : // d#ind
             if (!imglist) _cimg_mp_return(0);
-            if (p1!=~0U) _cimg_mp_const_scalar(imglist[p1]._depth);
+            if (p1!=~0U) _cimg_mp_const_scalar(list_image(p1)._depth);
             _cimg_mp_scalar1(mp_list_depth,arg1);
           case 'r' : // r#ind
             if (!imglist) _cimg_mp_return(0);
-            if (p1!=~0U) _cimg_mp_const_scalar(imglist[p1]._is_shared);
+            if (p1!=~0U) _cimg_mp_const_scalar(list_image(p1)._is_shared);
             _cimg_mp_scalar1(mp_list_is_shared,arg1);
           case 's' : // s#ind
             if (!imglist) _cimg_mp_return(0);
-            if (p1!=~0U) _cimg_mp_const_scalar(imglist[p1]._spectrum);
+            if (p1!=~0U) _cimg_mp_const_scalar(list_image(p1)._spectrum);
             _cimg_mp_scalar1(mp_list_spectrum,arg1);
           case 'i' : // i#ind
             if (!imglist) _cimg_mp_return(0);
             _cimg_mp_scalar7(mp_list_ixyzc,arg1,_cimg_mp_slot_x,_cimg_mp_slot_y,_cimg_mp_slot_z,_cimg_mp_slot_c,
                              0,_cimg_mp_boundary);
           case 'I' : // I#ind
-            p2 = p1!=~0U?imglist[p1]._spectrum:imglist._width?~0U:0;
+            p2 = p1!=~0U?list_image(p1)._spectrum:imglist._width?~0U:0;
             if (!p2) _cimg_mp_return(0);
             pos = vector(p2);
             CImg<ulongT>::vector((ulongT)mp_list_Joff,pos,p1,0,0,p2).move_to(code);
@@ -23519,7 +23682,7 @@ namespace cimg_library {
                               cimg::mod((int)mem[arg1],imglist.width()):~0U);
           if (*ss=='w' && *ss1=='h') { // wh#ind
             if (!imglist) _cimg_mp_return(0);
-            if (p1!=~0U) _cimg_mp_const_scalar(imglist[p1]._width*imglist[p1]._height);
+            if (p1!=~0U) _cimg_mp_const_scalar(list_image(p1)._width*list_image(p1)._height);
             _cimg_mp_scalar1(mp_list_wh,arg1);
           }
           arg2 = ~0U;
@@ -23535,7 +23698,7 @@ namespace cimg_library {
               if (!imglist) _cimg_mp_return(0);
               if (is_const_scalar(arg1)) {
                 if (!list_median) list_median.assign(imglist._width);
-                if (!list_median[p1]) CImg<doubleT>::vector(imglist[p1].median()).move_to(list_median[p1]);
+                if (!list_median[p1]) CImg<doubleT>::vector(list_image(p1).median()).move_to(list_median[p1]);
                 _cimg_mp_const_scalar(*list_median[p1]);
               }
               _cimg_mp_scalar1(mp_list_id,arg1);
@@ -23545,7 +23708,7 @@ namespace cimg_library {
               if (!imglist) _cimg_mp_return(0);
               if (is_const_scalar(arg1)) {
                 if (!list_stats) list_stats.assign(imglist._width);
-                if (!list_stats[p1]) list_stats[p1].assign(1,14,1,1,0).fill(imglist[p1].get_stats(),false);
+                if (!list_stats[p1]) list_stats[p1].assign(1,14,1,1,0).fill(list_image(p1).get_stats(),false);
                 _cimg_mp_const_scalar(std::sqrt(list_stats(p1,3)));
               }
               _cimg_mp_scalar1(mp_list_id,arg1);
@@ -23555,7 +23718,7 @@ namespace cimg_library {
               if (!imglist) _cimg_mp_return(0);
               if (is_const_scalar(arg1)) {
                 if (!list_norm) list_norm.assign(imglist._width);
-                if (!list_norm[p1]) CImg<doubleT>::vector(imglist[p1].magnitude(2)).move_to(list_norm[p1]);
+                if (!list_norm[p1]) CImg<doubleT>::vector(list_image(p1).magnitude(2)).move_to(list_norm[p1]);
                 _cimg_mp_const_scalar(*list_norm[p1]);
               }
               _cimg_mp_scalar1(mp_list_norm,arg1);
@@ -23584,7 +23747,7 @@ namespace cimg_library {
             if (!imglist) _cimg_mp_return(0);
             if (is_const_scalar(arg1)) {
               if (!list_stats) list_stats.assign(imglist._width);
-              if (!list_stats[p1]) list_stats[p1].assign(1,14,1,1,0).fill(imglist[p1].get_stats(),false);
+              if (!list_stats[p1]) list_stats[p1].assign(1,14,1,1,0).fill(list_image(p1).get_stats(),false);
               _cimg_mp_const_scalar(list_stats(p1,arg2));
             }
             _cimg_mp_scalar2(mp_list_stats,arg1,arg2);
@@ -23596,7 +23759,7 @@ namespace cimg_library {
           _cimg_mp_check_notnan_index(arg1);
           if (!imglist) _cimg_mp_return(0);
           p1 = (unsigned int)(is_const_scalar(arg1)?cimg::mod((int)mem[arg1],imglist.width()):~0U);
-          if (p1!=~0U) _cimg_mp_const_scalar(imglist[p1]._width*imglist[p1]._height*imglist[p1]._depth);
+          if (p1!=~0U) _cimg_mp_const_scalar(list_image(p1)._width*list_image(p1)._height*list_image(p1)._depth);
           _cimg_mp_scalar1(mp_list_whd,arg1);
         }
         if (*ss=='w' && *ss1=='h' && *ss2=='d' && *ss3=='s' && *ss4=='#' && ss5<se) { // whds#ind
@@ -23605,7 +23768,7 @@ namespace cimg_library {
           if (!imglist) _cimg_mp_return(0);
           p1 = (unsigned int)(is_const_scalar(arg1)?cimg::mod((int)mem[arg1],imglist.width()):~0U);
           if (p1!=~0U)
-            _cimg_mp_const_scalar(imglist[p1]._width*imglist[p1]._height*imglist[p1]._depth*imglist[p1]._spectrum);
+            _cimg_mp_const_scalar(list_image(p1)._width*list_image(p1)._height*list_image(p1)._depth*list_image(p1)._spectrum);
           _cimg_mp_scalar1(mp_list_whds,arg1);
         }
 
@@ -23615,8 +23778,10 @@ namespace cimg_library {
         variable_name.assign(ss,(unsigned int)(se + 1 - ss)).back() = 0;
 
 #ifdef cimg_mp_operator_dollar
-        if (*ss=='$' && ss1<se) // External variable '$varname'.
+        if (*ss=='$' && ss1<se) { // External variable '$varname'.
+          is_cacheable = false; // Depends on external variable value
           _cimg_mp_const_scalar(cimg_mp_operator_dollar(variable_name._data + 1));
+        }
 #endif
 
         // No known item found, assuming this is an already initialized variable.
@@ -23670,6 +23835,492 @@ namespace cimg_library {
         } else *output = (t)*result;
       }
 
+      // Peephole optimization of compiled code.
+      // Applied once after compilation, on the main code of programs without control flow (whose opcodes
+      // store relative code offsets). Rewrites are restricted to side-effect free scalar operators that store
+      // their result in 'opcode[1]': constant folding and copy propagation, elimination of common
+      // subexpressions (including repeated image reads), fusion of pairs of operators into a single one
+      // (e.g. 'a*b + c' -> 'linear_add', 'min(max(a,b),c)' -> 'min_max') and removal of dead temporaries.
+      // Other operators are considered as reading and writing every memory slot they refer to.
+
+      // Return number of memory slots read by side-effect free scalar operator 'op', or -1 if 'op' is not
+      // such an operator. Positions of the read slots in 'op' are stored in 'pos'.
+      static int opt_arguments(const CImg<ulongT>& op, unsigned int *const pos, bool &is_img) {
+        is_img = false;
+        if (op._height<2) return -1;
+        const mp_func f = (mp_func)*op;
+        int n = -1;
+        if (f==mp_copy || f==mp_increment || f==mp_decrement || f==mp_minus || f==mp_abs || f==mp_sqr ||
+            f==mp_sqrt || f==mp_cbrt || f==mp_pow3 || f==mp_pow4 || f==mp_exp || f==mp_log || f==mp_log2 ||
+            f==mp_log10 || f==mp_cos || f==mp_sin || f==mp_tan || f==mp_acos || f==mp_asin || f==mp_atan ||
+            f==mp_cosh || f==mp_sinh || f==mp_tanh || f==mp_floor || f==mp_ceil || f==mp_int || f==mp_sign ||
+            f==mp_logical_not) n = 1;
+        else if (f==mp_add || f==mp_sub || f==mp_mul || f==mp_div || f==mp_pow || f==mp_atan2 ||
+                 f==mp_modulo || f==mp_lt || f==mp_lte || f==mp_gt || f==mp_gte || f==mp_eq || f==mp_neq) n = 2;
+        else if (f==mp_mul2 || f==mp_linear_add || f==mp_linear_sub_left || f==mp_linear_sub_right ||
+                 f==mp_cut || f==mp_min_max || f==mp_max_min) n = 3;
+        else if (f==mp_i) { n = 0; is_img = true; }
+        else if (f==mp_ioff || f==mp_joff) { n = 2; is_img = true; }
+        else if (f==mp_ixyzc || f==mp_jxyzc) { n = 6; is_img = true; }
+        else if ((f==mp_min || f==mp_max) && op._height==7 && op[2]==7 && op[4]==1 && op[6]==1) {
+          pos[0] = 3; pos[1] = 5; return 2; // Two scalar arguments
+        }
+        if (n<0 || op._height!=2U + n) return -1;
+        for (int k = 0; k<n; ++k) pos[k] = 2 + k;
+        return n;
+      }
+
+      // Return true if slot 'k' is slot 'p', or one of the components of the vector stored at 'p'.
+      // Operators referring to a vector only refer to its first slot, but may access all its components.
+      bool opt_overlaps(const ulongT p, const ulongT k) const {
+        return p==k || (p<memtype._width && memtype[p]>1 && k>p && k<p + memtype[p]);
+      }
+
+      // Return true if instruction 'l' reads (or may read) memory slot 'k'.
+      // 'info' stores for each instruction its number of read slots (-1: unknown operator, -2: removed),
+      // a flag telling if it reads the image, then the positions of its read slots.
+      bool opt_reads(const CImg<intT>& info, const unsigned int l, const ulongT k) const {
+        const CImg<ulongT> &op = code[l];
+        const int n = info(0,l);
+        if (n==-2) return false;
+        if (n==-1) {
+          for (unsigned int i = 1; i<op._height; ++i) if (opt_overlaps(op[i],k)) return true;
+          return false;
+        }
+        for (int i = 0; i<n; ++i) if (op[info(2 + i,l)]==k) return true;
+        return false;
+      }
+
+      // Return true if instruction 'l' writes (or may write) memory slot 'k'.
+      bool opt_writes(const CImg<intT>& info, const unsigned int l, const ulongT k) const {
+        const int n = info(0,l);
+        if (n==-2) return false;
+        if (n==-1) return opt_reads(info,l,k);
+        return code[l][1]==k;
+      }
+
+      // Replace the following reads of the value stored in slot 'k' by instruction 'l' with reads of slot 'nk'
+      // (or only check that this value is never read, if 'nk==~0U').
+      // Return false if this is not possible.
+      bool opt_rename(const CImg<intT>& info, const CImg<ucharT>& is_pinned,
+                      const unsigned int l, const ulongT k, const ulongT nk, const bool is_apply) {
+        bool is_clobbered = false;
+        for (unsigned int m = l + 1; m<code._width; ++m) {
+          if (opt_reads(info,m,k)) {
+            const int n = info(0,m);
+            if (n<0 || nk==~0U || is_clobbered) return false;
+            if (is_apply) for (int i = 0; i<n; ++i) if (code[m][info(2 + i,m)]==k) code[m][info(2 + i,m)] = nk;
+          }
+          if (opt_writes(info,m,k)) return true; // Value is overwritten
+          if (nk!=~0U && opt_writes(info,m,nk)) is_clobbered = true;
+        }
+
+        // Value reaches the end of the code: it must not be read by another block, nor at the next evaluation.
+        if (k>=is_pinned._width || is_pinned[k]) return false;
+        for (unsigned int m = 0; m<=l; ++m) {
+          if (opt_reads(info,m,k)) return false;
+          if (opt_writes(info,m,k)) return true;
+        }
+        return true;
+      }
+
+      // Optimize compiled code.
+      void optimize(const unsigned int ind_result) {
+        const unsigned int siz = code._width;
+        unsigned int nb_folded = 0, nb_shared = 0, nb_fused = 0, nb_removed = 0;
+        bool is_optimizable = siz && siz<=4096;
+        CImg<intT> info(10,siz);
+        for (unsigned int l = 0; l<siz && is_optimizable; ++l) {
+          const CImg<ulongT> &op = code[l];
+          const mp_func f = op._height<2?0:(mp_func)*op;
+          if (!f || f==mp_if || f==mp_do || f==mp_while || f==mp_for || f==mp_repeat || f==mp_break ||
+              f==mp_continue || f==mp_logical_and || f==mp_logical_or || f==mp_debug || f==mp_critical ||
+              f==mp_breakpoint || f==mp_fill) is_optimizable = false; // Control flow
+          else {
+            unsigned int pos[8] = { 0 };
+            bool is_img;
+            const int n = opt_arguments(op,pos,is_img);
+            info(0,l) = n; info(1,l) = is_img?1:0;
+            for (int k = 0; k<n; ++k) info(2 + k,l) = (int)pos[k];
+          }
+        }
+
+        if (is_optimizable) {
+
+          // Pin memory slots whose value must be preserved at the end of the code: result, merged variables and
+          // slots used by other blocks (set to 1), and vector components, never considered as temporaries (set to 2).
+          // Other non-constant scalars (computed values and variables) can be renamed.
+          CImg<ucharT> is_pinned(mem._width,1,1,1,0);
+          for (unsigned int k = 0; k<is_pinned._width; ++k)
+            if (memtype[k]>1) for (int i = 0; i<memtype[k] && k + i<is_pinned._width; ++i) is_pinned[k + i] = 2;
+          if (!is_pinned[ind_result]) is_pinned[ind_result] = 1;
+          const CImgList<ulongT> *const blocks[] = { &code_begin, &code_end, &code_begin_t, &code_end_t };
+          for (unsigned int b = 0; b<4; ++b) cimglist_for(*blocks[b],l) {
+            const CImg<ulongT> &op = (*blocks[b])[l];
+            for (unsigned int i = 1; i<op._height; ++i)
+              if (op[i]<is_pinned._width && !is_pinned[op[i]]) is_pinned[op[i]] = 1;
+          }
+          cimg_forY(memmerge,k) for (int i = 0; i<=memmerge(1,k); ++i)
+            if (memmerge(0,k) + i<(int)is_pinned._width && !is_pinned[memmerge(0,k) + i])
+              is_pinned[memmerge(0,k) + i] = 1;
+#define _cimg_mp_is_temp(k) ((k)>_cimg_mp_slot_c && (k)<is_pinned._width && is_pinned[k]!=2 && memtype[k]<=0)
+
+          // Value numbers: slots holding the same value number are known to store the same value.
+          CImg<ulongT> vn_slots(is_pinned._width);
+          cimg_forX(vn_slots,k) vn_slots[k] = (ulongT)k;
+          ulongT vn_next = ~0U/2, img_state = 0;
+          CImgList<ulongT> keys;
+#define _cimg_mp_vn(k) ((k)<vn_slots._width?vn_slots[k]:(ulongT)(k))
+
+          for (unsigned int l = 0; l<siz; ++l) {
+            const int n = info(0,l);
+            if (n==-1) { // Unknown operator: all referred slots, vector components (and image) may be modified
+              const CImg<ulongT> &op = code[l];
+              for (unsigned int i = 1; i<op._height; ++i) {
+                const ulongT p = op[i];
+                if (p>=vn_slots._width) continue;
+                const ulongT p_end = memtype[p]>1?std::min(p + memtype[p],(ulongT)vn_slots._width):p + 1;
+                for (ulongT k = p; k<p_end; ++k) vn_slots[k] = vn_next++;
+              }
+              ++img_state;
+            }
+            if (n<0) continue;
+            CImg<ulongT> &op = code[l];
+            const mp_func f = (mp_func)*op;
+            const ulongT target = op[1];
+
+            // Constant folding and copy propagation.
+            if (_cimg_mp_is_temp(target)) {
+              ulongT nk = ~0U;
+              if (f==mp_copy) nk = op[2]!=target?op[2]:~0U;
+              else if (n && !info(1,l)) {
+                bool is_const = true;
+                for (int i = 0; i<n && is_const; ++i) is_const = is_const_scalar((unsigned int)op[info(2 + i,l)]);
+                if (is_const) {
+                  opcode.assign(op,true);
+                  nk = const_scalar(_cimg_mp_defunc(*this));
+                  opcode.assign();
+                }
+              }
+              if (nk!=~0U && opt_rename(info,is_pinned,l,target,nk,false)) {
+                opt_rename(info,is_pinned,l,target,nk,true);
+                info(0,l) = -2; ++nb_folded;
+                continue;
+              }
+            }
+
+            // Common subexpression elimination (by value numbering).
+            CImg<ulongT> key(1,op._height + 7,1,1,0); // Ends with value number and holder slot
+            for (unsigned int i = 0; i<op._height; ++i) key[i] = op[i];
+            key[1] = 0;
+            for (int i = 0; i<n; ++i) key[info(2 + i,l)] = _cimg_mp_vn(op[info(2 + i,l)]);
+            if (info(1,l)) { // Image reads also depend on current coordinates and image modifications
+              for (unsigned int i = 0; i<4; ++i) key[op._height + i] = _cimg_mp_vn(_cimg_mp_slot_x + i);
+              key[op._height + 4] = img_state;
+            }
+            int ind_key = -1;
+            for (int m = (int)keys._width - 1, m_end = std::max(0,(int)keys._width - 256);
+                 m>=m_end && ind_key<0; --m)
+              if (keys[m]._height==key._height &&
+                  !std::memcmp(keys[m]._data,key._data,(key._height - 2)*sizeof(ulongT))) ind_key = m;
+            if (ind_key>=0) {
+              CImg<ulongT> &pkey = keys[ind_key];
+              const ulongT vn = pkey[key._height - 2];
+              ulongT holder = pkey[key._height - 1];
+              if (_cimg_mp_vn(holder)!=vn) { // Look for another slot holding the same value
+                holder = ~0U;
+                cimg_forX(vn_slots,k) if (vn_slots[k]==vn) { holder = (ulongT)k; break; }
+              }
+              if (holder!=~0U) {
+                bool is_shared = holder==target;
+                if (!is_shared && _cimg_mp_is_temp(target) && opt_rename(info,is_pinned,l,target,holder,false)) {
+                  opt_rename(info,is_pinned,l,target,holder,true);
+                  is_shared = true;
+                }
+                if (is_shared) { info(0,l) = -2; ++nb_shared; continue; }
+              }
+              vn_slots[target] = vn; pkey[key._height - 1] = target;
+            } else {
+              key[key._height - 2] = vn_slots[target] = vn_next++;
+              key[key._height - 1] = target;
+              key.move_to(keys);
+            }
+
+            // Fusion with the operator that computes one of the arguments.
+            if (n==2 && (f==mp_add || f==mp_sub || f==mp_mul || f==mp_min || f==mp_max))
+              for (int i = 0; i<2; ++i) {
+                const ulongT k = op[info(2 + i,l)], other = op[info(3 - i,l)];
+                if (k==other || !_cimg_mp_is_temp(k)) continue;
+                int m = (int)l - 1;
+                while (m>=0 && !opt_reads(info,m,k) && !opt_writes(info,m,k)) --m;
+                if (m<0 || info(0,m)!=2 || code[m][1]!=k) continue;
+                const CImg<ulongT> &pop = code[m];
+                const mp_func pf = (mp_func)*pop;
+                const ulongT a = pop[info(2,m)], b = pop[info(3,m)];
+                mp_func ff = 0;
+                if (pf==mp_mul) ff = f==mp_add?mp_linear_add:f==mp_mul?mp_mul2:
+                                  f==mp_sub?(i?mp_linear_sub_right:mp_linear_sub_left):0;
+                else if (pf==mp_max && f==mp_min) ff = mp_min_max;
+                else if (pf==mp_min && f==mp_max) ff = mp_max_min;
+                if (!ff || a==k || b==k) continue;
+                bool is_valid = true;
+                for (unsigned int p = m + 1; p<l && is_valid; ++p)
+                  if (opt_writes(info,p,a) || opt_writes(info,p,b)) is_valid = false;
+                if (!is_valid || (target!=k && !opt_rename(info,is_pinned,l,k,~0U,false))) continue;
+                CImg<ulongT>::vector((ulongT)ff,target,a,b,other).move_to(op);
+                info(0,l) = 3; info(1,l) = 0; info(2,l) = 2; info(3,l) = 3; info(4,l) = 4;
+                info(0,m) = -2; ++nb_fused;
+                vn_slots[k] = vn_next++; // Value of 'k' is not computed anymore
+                break;
+              }
+          }
+
+          // Dead code elimination.
+          for (unsigned int l = siz; l-->0; ) {
+            if (info(0,l)<0) continue;
+            const ulongT target = code[l][1];
+            if (_cimg_mp_is_temp(target) && opt_rename(info,is_pinned,l,target,~0U,false)) {
+              info(0,l) = -2; ++nb_removed;
+            }
+          }
+
+          if (nb_folded + nb_shared + nb_fused + nb_removed) {
+            CImgList<ulongT> ncode;
+            cimglist_for(code,l) if (info(0,l)!=-2) code[l].move_to(ncode);
+            code.swap(ncode);
+          }
+        }
+
+#if cimg_mp_profile!=0
+        CImg<charT> _expr(expr);
+        cimg::strellipsize(_expr,64);
+        std::fprintf(cimg::output(),
+                     "\n[" cimg_appname "_math_parser] Optimize '%s': %u -> %u opcodes "
+                     "(%u folded, %u shared, %u fused, %u removed)%s.",
+                     _expr._data,siz,code._width,nb_folded,nb_shared,nb_fused,nb_removed,
+                     is_optimizable?"":", control flow not optimized");
+        std::fflush(cimg::output());
+#endif
+      }
+
+      // Batched evaluation of pure scalar programs.
+      // A program made only of side-effect free scalar operators is evaluated on spans of consecutive pixels
+      // along the X-axis, one operator at a time ('batch_code'), with each memory slot stored as a row of
+      // 'batch_mem' (SoA layout). This avoids one function call per operator and per pixel, and lets the
+      // compiler vectorize the inner loops. Other programs are evaluated pixel by pixel with 'operator()'.
+#define _cimg_mp_batch_size 64
+      enum { _mpb_copy, _mpb_add, _mpb_sub, _mpb_mul, _mpb_mul2, _mpb_div, _mpb_linear_add, _mpb_linear_sub_left,
+             _mpb_linear_sub_right, _mpb_increment, _mpb_decrement, _mpb_minus, _mpb_abs, _mpb_sqr, _mpb_sqrt,
+             _mpb_cbrt, _mpb_pow, _mpb_pow3, _mpb_pow4, _mpb_exp, _mpb_log, _mpb_log2, _mpb_log10, _mpb_cos,
+             _mpb_sin, _mpb_tan, _mpb_acos, _mpb_asin, _mpb_atan, _mpb_atan2, _mpb_cosh, _mpb_sinh, _mpb_tanh,
+             _mpb_floor, _mpb_ceil, _mpb_int, _mpb_sign, _mpb_modulo, _mpb_cut, _mpb_min_max, _mpb_max_min,
+             _mpb_lt, _mpb_lte, _mpb_gt, _mpb_gte, _mpb_eq, _mpb_neq, _mpb_logical_not, _mpb_self_add,
+             _mpb_self_sub, _mpb_self_mul, _mpb_self_div, _mpb_i };
+
+      // Return 'true' if compiled program can be evaluated in batch mode.
+      bool is_batchable() {
+        if (batch_state>=0) return batch_state==1;
+        batch_state = 0;
+        if (result_dim || !code || mem._width>4096) return false;
+        CImg<ucharT> is_written(mem._width,1,1,1,0), is_defined(mem._width,1,1,1,0), is_input(mem._width,1,1,1,0);
+        cimglist_for(code,l) if (code[l].size()<2 || code[l][1]>=mem._width) return false; else is_written[code[l][1]] = 1;
+        if (is_written[_cimg_mp_slot_x] || is_written[_cimg_mp_slot_y] ||
+            is_written[_cimg_mp_slot_z] || is_written[_cimg_mp_slot_c]) return false;
+        CImg<ulongT> bcode(5,code._width,1,1,0);
+        cimglist_for(code,l) {
+          const CImg<ulongT> &op = code[l];
+          const mp_func f = (mp_func)*op;
+          int id = -1;
+          unsigned int nb_args = 1;
+          if (f==mp_copy) id = _mpb_copy;
+          else if (f==mp_add) { id = _mpb_add; nb_args = 2; }
+          else if (f==mp_sub) { id = _mpb_sub; nb_args = 2; }
+          else if (f==mp_mul) { id = _mpb_mul; nb_args = 2; }
+          else if (f==mp_mul2) { id = _mpb_mul2; nb_args = 3; }
+          else if (f==mp_div) { id = _mpb_div; nb_args = 2; }
+          else if (f==mp_linear_add) { id = _mpb_linear_add; nb_args = 3; }
+          else if (f==mp_linear_sub_left) { id = _mpb_linear_sub_left; nb_args = 3; }
+          else if (f==mp_linear_sub_right) { id = _mpb_linear_sub_right; nb_args = 3; }
+          else if (f==mp_increment) id = _mpb_increment;
+          else if (f==mp_decrement) id = _mpb_decrement;
+          else if (f==mp_minus) id = _mpb_minus;
+          else if (f==mp_abs) id = _mpb_abs;
+          else if (f==mp_sqr) id = _mpb_sqr;
+          else if (f==mp_sqrt) id = _mpb_sqrt;
+          else if (f==mp_cbrt) id = _mpb_cbrt;
+          else if (f==mp_pow) { id = _mpb_pow; nb_args = 2; }
+          else if (f==mp_pow3) id = _mpb_pow3;
+          else if (f==mp_pow4) id = _mpb_pow4;
+          else if (f==mp_exp) id = _mpb_exp;
+          else if (f==mp_log) id = _mpb_log;
+          else if (f==mp_log2) id = _mpb_log2;
+          else if (f==mp_log10) id = _mpb_log10;
+          else if (f==mp_cos) id = _mpb_cos;
+          else if (f==mp_sin) id = _mpb_sin;
+          else if (f==mp_tan) id = _mpb_tan;
+          else if (f==mp_acos) id = _mpb_acos;
+          else if (f==mp_asin) id = _mpb_asin;
+          else if (f==mp_atan) id = _mpb_atan;
+          else if (f==mp_atan2) { id = _mpb_atan2; nb_args = 2; }
+          else if (f==mp_cosh) id = _mpb_cosh;
+          else if (f==mp_sinh) id = _mpb_sinh;
+          else if (f==mp_tanh) id = _mpb_tanh;
+          else if (f==mp_floor) id = _mpb_floor;
+          else if (f==mp_ceil) id = _mpb_ceil;
+          else if (f==mp_int) id = _mpb_int;
+          else if (f==mp_sign) id = _mpb_sign;
+          else if (f==mp_modulo) { id = _mpb_modulo; nb_args = 2; }
+          else if (f==mp_cut) { id = _mpb_cut; nb_args = 3; }
+          else if (f==mp_min_max) { id = _mpb_min_max; nb_args = 3; }
+          else if (f==mp_max_min) { id = _mpb_max_min; nb_args = 3; }
+          else if (f==mp_lt) { id = _mpb_lt; nb_args = 2; }
+          else if (f==mp_lte) { id = _mpb_lte; nb_args = 2; }
+          else if (f==mp_gt) { id = _mpb_gt; nb_args = 2; }
+          else if (f==mp_gte) { id = _mpb_gte; nb_args = 2; }
+          else if (f==mp_eq) { id = _mpb_eq; nb_args = 2; }
+          else if (f==mp_neq) { id = _mpb_neq; nb_args = 2; }
+          else if (f==mp_logical_not) id = _mpb_logical_not;
+          else if (f==mp_self_add) id = _mpb_self_add;
+          else if (f==mp_self_sub) id = _mpb_self_sub;
+          else if (f==mp_self_mul) id = _mpb_self_mul;
+          else if (f==mp_self_div) id = _mpb_self_div;
+          else if (f==mp_i) { id = _mpb_i; nb_args = 0; }
+          if (id<0 || op.size()<2 + nb_args) return false; // Operator with side effects or control flow
+          const ulongT target = op[1];
+          if (id>=_mpb_self_add && id<=_mpb_self_div && !is_defined[target])
+            return false; // Accumulation over pixels
+          bcode(0,l) = (ulongT)id; bcode(1,l) = target;
+          for (unsigned int k = 0; k<nb_args; ++k) {
+            const ulongT arg = op[2 + k];
+            if (arg>=mem._width || (is_written[arg] && !is_defined[arg]))
+              return false; // Value computed for a previous pixel
+            if (!is_written[arg]) is_input[arg] = 1;
+            bcode(2 + k,l) = arg;
+          }
+          is_defined[target] = 1;
+        }
+        const unsigned int ind_result = (unsigned int)(result - mem._data);
+        if (!is_written[ind_result]) is_input[ind_result] = 1;
+        is_input[_cimg_mp_slot_x] = 0; // Lanes of 'x' are set for each span
+        bcode.move_to(batch_code);
+        batch_inputs.assign(is_input.sum()?(unsigned int)is_input.sum():1,1,1,1,~0U);
+        batch_outputs.assign(is_written.sum()?(unsigned int)is_written.sum():1,1,1,1,~0U);
+        unsigned int *ptr_in = batch_inputs._data, *ptr_out = batch_outputs._data;
+        cimg_forX(is_input,k) {
+          if (is_input[k]) *(ptr_in++) = (unsigned int)k;
+          if (is_written[k]) *(ptr_out++) = (unsigned int)k;
+        }
+        batch_state = 1;
+        return true;
+      }
+
+      // Evaluate a batchable program on row (y,z,c) of 'width' pixels, and store results in 'ptrd'.
+      template<typename t>
+      void eval_row(const int y, const int z, const int c, const int width, t *ptrd) {
+        if (!batch_mem) batch_mem.assign(_cimg_mp_batch_size,mem._width);
+        const unsigned int ind_result = (unsigned int)(result - mem._data);
+        mem[_cimg_mp_slot_y] = y; mem[_cimg_mp_slot_z] = z; mem[_cimg_mp_slot_c] = c;
+        cimg_forX(batch_inputs,k) if (batch_inputs[k]!=~0U) // Broadcast values that do not depend on x
+          batch_mem.get_shared_row(batch_inputs[k]).fill(mem[batch_inputs[k]]);
+        for (int x0 = 0; x0<width; x0+=_cimg_mp_batch_size) {
+          const int N = std::min(width - x0,_cimg_mp_batch_size);
+          double *const px = batch_mem.data(0,_cimg_mp_slot_x);
+          for (int n = 0; n<N; ++n) px[n] = (double)(x0 + n);
+          cimg_forY(batch_code,l) {
+            const ulongT *const op = batch_code.data(0,l);
+            double
+              *const pd = batch_mem.data(0,op[1]),
+              *const pa = batch_mem.data(0,op[2]),
+              *const pb = batch_mem.data(0,op[3]),
+              *const pc = batch_mem.data(0,op[4]);
+            int n;
+            switch (op[0]) {
+            case _mpb_copy : for (n = 0; n<N; ++n) pd[n] = pa[n]; break;
+            case _mpb_add : for (n = 0; n<N; ++n) pd[n] = pa[n] + pb[n]; break;
+            case _mpb_sub : for (n = 0; n<N; ++n) pd[n] = pa[n] - pb[n]; break;
+            case _mpb_mul : for (n = 0; n<N; ++n) pd[n] = pa[n]*pb[n]; break;
+            case _mpb_mul2 : for (n = 0; n<N; ++n) pd[n] = pa[n]*pb[n]*pc[n]; break;
+            case _mpb_div : for (n = 0; n<N; ++n) pd[n] = pa[n]/pb[n]; break;
+            case _mpb_linear_add : for (n = 0; n<N; ++n) pd[n] = pa[n]*pb[n] + pc[n]; break;
+            case _mpb_linear_sub_left : for (n = 0; n<N; ++n) pd[n] = pa[n]*pb[n] - pc[n]; break;
+            case _mpb_linear_sub_right : for (n = 0; n<N; ++n) pd[n] = pc[n] - pa[n]*pb[n]; break;
+            case _mpb_increment : for (n = 0; n<N; ++n) pd[n] = pa[n] + 1; break;
+            case _mpb_decrement : for (n = 0; n<N; ++n) pd[n] = pa[n] - 1; break;
+            case _mpb_minus : for (n = 0; n<N; ++n) pd[n] = -pa[n]; break;
+            case _mpb_abs : for (n = 0; n<N; ++n) pd[n] = cimg::abs(pa[n]); break;
+            case _mpb_sqr : for (n = 0; n<N; ++n) pd[n] = cimg::sqr(pa[n]); break;
+            case _mpb_sqrt : for (n = 0; n<N; ++n) pd[n] = std::sqrt(pa[n]); break;
+            case _mpb_cbrt : for (n = 0; n<N; ++n) pd[n] = cimg::cbrt(pa[n]); break;
+            case _mpb_pow : for (n = 0; n<N; ++n) pd[n] = std::pow(pa[n],pb[n]); break;
+            case _mpb_pow3 : for (n = 0; n<N; ++n) pd[n] = pa[n]*pa[n]*pa[n]; break;
+            case _mpb_pow4 : for (n = 0; n<N; ++n) pd[n] = pa[n]*pa[n]*pa[n]*pa[n]; break;
+            case _mpb_exp : for (n = 0; n<N; ++n) pd[n] = std::exp(pa[n]); break;
+            case _mpb_log : for (n = 0; n<N; ++n) pd[n] = std::log(pa[n]); break;
+            case _mpb_log2 : for (n = 0; n<N; ++n) pd[n] = cimg::log2(pa[n]); break;
+            case _mpb_log10 : for (n = 0; n<N; ++n) pd[n] = std::log10(pa[n]); break;
+            case _mpb_cos : for (n = 0; n<N; ++n) pd[n] = std::cos(pa[n]); break;
+            case _mpb_sin : for (n = 0; n<N; ++n) pd[n] = std::sin(pa[n]); break;
+            case _mpb_tan : for (n = 0; n<N; ++n) pd[n] = std::tan(pa[n]); break;
+            case _mpb_acos : for (n = 0; n<N; ++n) pd[n] = std::acos(pa[n]); break;
+            case _mpb_asin : for (n = 0; n<N; ++n) pd[n] = std::asin(pa[n]); break;
+            case _mpb_atan : for (n = 0; n<N; ++n) pd[n] = std::atan(pa[n]); break;
+            case _mpb_atan2 : for (n = 0; n<N; ++n) pd[n] = std::atan2(pa[n],pb[n]); break;
+            case _mpb_cosh : for (n = 0; n<N; ++n) pd[n] = std::cosh(pa[n]); break;
+            case _mpb_sinh : for (n = 0; n<N; ++n) pd[n] = std::sinh(pa[n]); break;
+            case _mpb_tanh : for (n = 0; n<N; ++n) pd[n] = std::tanh(pa[n]); break;
+            case _mpb_floor : for (n = 0; n<N; ++n) pd[n] = std::floor(pa[n]); break;
+            case _mpb_ceil : for (n = 0; n<N; ++n) pd[n] = std::ceil(pa[n]); break;
+            case _mpb_int : for (n = 0; n<N; ++n) pd[n] = (double)(longT)pa[n]; break;
+            case _mpb_sign : for (n = 0; n<N; ++n) pd[n] = cimg::sign(pa[n]); break;
+            case _mpb_modulo : for (n = 0; n<N; ++n) pd[n] = cimg::mod(pa[n],pb[n]); break;
+            case _mpb_cut :
+              for (n = 0; n<N; ++n) pd[n] = pa[n]<pb[n]?pb[n]:pa[n]>pc[n]?pc[n]:pa[n];
+              break;
+            case _mpb_min_max : for (n = 0; n<N; ++n) {
+                double valmax = -cimg::type<double>::inf(), valmin = cimg::type<double>::inf();
+                if (pa[n]>valmax) valmax = pa[n];
+                if (pb[n]>valmax) valmax = pb[n];
+                if (valmax<valmin) valmin = valmax;
+                if (pc[n]<valmin) valmin = pc[n];
+                pd[n] = valmin;
+              } break;
+            case _mpb_max_min : for (n = 0; n<N; ++n) {
+                double valmin = cimg::type<double>::inf(), valmax = -cimg::type<double>::inf();
+                if (pa[n]<valmin) valmin = pa[n];
+                if (pb[n]<valmin) valmin = pb[n];
+                if (valmin>valmax) valmax = valmin;
+                if (pc[n]>valmax) valmax = pc[n];
+                pd[n] = valmax;
+              } break;
+            case _mpb_lt : for (n = 0; n<N; ++n) pd[n] = (double)(pa[n]<pb[n]); break;
+            case _mpb_lte : for (n = 0; n<N; ++n) pd[n] = (double)(pa[n]<=pb[n]); break;
+            case _mpb_gt : for (n = 0; n<N; ++n) pd[n] = (double)(pa[n]>pb[n]); break;
+            case _mpb_gte : for (n = 0; n<N; ++n) pd[n] = (double)(pa[n]>=pb[n]); break;
+            case _mpb_eq : for (n = 0; n<N; ++n) pd[n] = (double)(pa[n]==pb[n]); break;
+            case _mpb_neq : for (n = 0; n<N; ++n) pd[n] = (double)(pa[n]!=pb[n]); break;
+            case _mpb_logical_not : for (n = 0; n<N; ++n) pd[n] = (double)!pa[n]; break;
+            case _mpb_self_add : for (n = 0; n<N; ++n) pd[n]+=pa[n]; break;
+            case _mpb_self_sub : for (n = 0; n<N; ++n) pd[n]-=pa[n]; break;
+            case _mpb_self_mul : for (n = 0; n<N; ++n) pd[n]*=pa[n]; break;
+            case _mpb_self_div : for (n = 0; n<N; ++n) pd[n]/=pa[n]; break;
+            case _mpb_i :
+              if (imgin) {
+                const T *const ps = imgin.data(x0,y,z,c);
+                for (n = 0; n<N; ++n) pd[n] = (double)ps[n];
+              } else for (n = 0; n<N; ++n) pd[n] = 0;
+              break;
+            }
+          }
+          const double *const pr = batch_mem.data(0,ind_result);
+          for (int n = 0; n<N; ++n) *(ptrd++) = (t)pr[n];
+          if (x0 + N>=width) { // Keep memory state of the last evaluated pixel
+            cimg_forX(batch_outputs,k) if (batch_outputs[k]!=~0U)
+              mem[batch_outputs[k]] = batch_mem(N - 1,batch_outputs[k]);
+            mem[_cimg_mp_slot_x] = x0 + N - 1;
+          }
+        }
+      }
+
       // Evaluation procedure for begin_t() bloc.
       void begin_t() {
         if (!code_begin_t) return;
@@ -23909,6 +24560,7 @@ namespace cimg_library {
 
       // Find and return index of current image 'imgin' within image list 'imglist'.
       unsigned int get_mem_img_index() {
+        is_cacheable = false; // Depends on position of 'imgout' in 'imglist'
         if (mem_img_index==~0U) {
           if (&imgout>imglist.data() && &imgout<imglist.end())
             mem_img_index = const_scalar((double)(&imgout - imglist.data()));
@@ -27544,6 +28196,16 @@ namespace cimg_library {
         return valmax;
       }
 
+      static double mp_max_min(_cimg_math_parser& mp) { // Fused 'max(min(a,b),c)'
+        const double a = _mp_arg(2), b = _mp_arg(3), c = _mp_arg(4);
+        double valmin = cimg::type<double>::inf(), valmax = -cimg::type<double>::inf();
+        if (a<valmin) valmin = a;
+        if (b<valmin) valmin = b;
+        if (valmin>valmax) valmax = valmin;
+        if (c>valmax) valmax = c;
+        return valmax;
+      }
+
       static double mp_maxabs(_cimg_math_parser& mp) {
         const unsigned int i_end = (unsigned int)mp.opcode[2];
         double val, abs_val, valmaxabs = 0, abs_valmaxabs = 0;
@@ -27688,6 +28350,16 @@ namespace cimg_library {
         return valmin;
       }
 
+      static double mp_min_max(_cimg_math_parser& mp) { // Fused 'min(max(a,b),c)'
+        const double a = _mp_arg(2), b = _mp_arg(3), c = _mp_arg(4);
+        double valmax = -cimg::type<double>::inf(), valmin = cimg::type<double>::inf();
+        if (a>valmax) valmax = a;
+        if (b>valmax) valmax = b;
+        if (valmax<valmin) valmin = valmax;
+        if (c<valmin) valmin = c;
+        return valmin;
+      }
+
       static double mp_minabs(_cimg_math_parser& mp) {
         const unsigned int i_end = (unsigned int)mp.opcode[2];
         double val, abs_val, valminabs = cimg::type<double>::inf(), abs_valminabs = cimg::type<double>::inf();
@@ -33706,10 +34378,16 @@ namespace cimg_library {
       if (mode&2 && !is_value_sequence) {
         _cimg_abort_init_openmp;
         try {
+#if cimg_mp_profile!=0
+          const cimg_uint64 profile_t0 = cimg::time();
+#endif
           CImg<T> base = provides_copy?provides_copy->get_shared():get_shared();
           _cimg_math_parser mp(expression + (*expression=='>' || *expression=='<' || *expression=='+' ||
                                              *expression=='*' || *expression==':'),
                                calling_function,base,this,list_images,true);
+#if cimg_mp_profile!=0
+          const cimg_uint64 profile_t1 = cimg::time();
+#endif
           if (!provides_copy && expression &&
               *expression!='>' && *expression!='<' && *expression!=':' &&
               mp.need_input_copy)
@@ -33819,12 +34497,16 @@ namespace cimg_library {
             } else if (*expression=='>' || *expression=='+' || !is_parallelizable) {
               mp.begin_t();
               if (mode&4) cimg_forYZC(*this,y,z,c) { cimg_abort_test; cimg_forX(*this,x) mp(x,y,z,c); }
+              else if (mp.is_batchable()) cimg_forYZC(*this,y,z,c) { // Batched evaluation
+                  cimg_abort_test; mp.eval_row(y,z,c,width(),ptrd); ptrd+=_width;
+                }
               else cimg_forYZC(*this,y,z,c) { cimg_abort_test; cimg_forX(*this,x) *(ptrd++) = (T)mp(x,y,z,c); }
               mp.end_t();
 
             } else {
 
 #if cimg_use_openmp!=0
+              const bool is_batch = !(mode&4) && mp.is_batchable(); // Must be known before copying 'mp'
               cimg_pragma_openmp(parallel)
                 {
                   _cimg_math_parser
@@ -33846,7 +34528,14 @@ namespace cimg_library {
     } \
   } _cimg_abort_catch_openmp _cimg_abort_catch_fill_openmp
 
-                  if (M2==_width) { _cimg_fill_openmp_scalar(YZC,y,z,c,X,x,0,y,z,c,1) }
+                  if (is_batch) { // Batched evaluation, rows are distributed among threads
+                    cimg_pragma_openmp(for cimg_openmp_collapse(3))
+                    cimg_forYZC(*this,y,z,c) _cimg_abort_try_openmp {
+                      cimg_abort_test;
+                      lmp.eval_row(y,z,c,width(),data(0,y,z,c));
+                    } _cimg_abort_catch_openmp _cimg_abort_catch_fill_openmp
+                  }
+                  else if (M2==_width) { _cimg_fill_openmp_scalar(YZC,y,z,c,X,x,0,y,z,c,1) }
                   else if (M2==_height) { _cimg_fill_openmp_scalar(XZC,x,z,c,Y,y,x,0,z,c,_width) }
                   else if (M2==_depth) { _cimg_fill_openmp_scalar(XYC,x,y,c,Z,z,x,y,0,c,_width*_height) }
                   else { _cimg_fill_openmp_scalar(XYZ,x,y,z,C,c,x,y,z,0,_width*_height*_depth) }
@@ -33860,6 +34549,22 @@ namespace cimg_library {
           }
           mp.end();
 
+#if cimg_mp_profile!=0
+          {
+            const cimg_uint64 profile_t2 = cimg::time();
+            CImg<charT> _expr = CImg<charT>::string(expression);
+            cimg::strellipsize(_expr,64);
+            std::fprintf(cimg::output(),
+                         "\n[" cimg_appname "_math_parser] Fill '%s': %u opcodes, %lu evaluations%s, "
+                         "compile %lu ms, eval %lu ms.",
+                         _expr._data,mp.code._width,
+                         (unsigned long)(mp.result_dim?(ulongT)_width*_height*_depth:size()),
+                         mp.batch_state==1?" (batched)":"",
+                         (unsigned long)(profile_t1 - profile_t0),(unsigned long)(profile_t2 - profile_t1));
+            std::fflush(cimg::output());
+          }
+#endif
+
           if (result_end && mp.result_end) // Transfer result of the end() block if requested.
             result_end->assign(mp.result_end + (mp.result_end_dim?1:0),std::max(1U,mp.result_end_dim));
 
@@ -68027,6 +68732,176 @@ namespace cimg_library {
       return s_path;
     }
 
+    // State of the out-of-core storage (must be modified with 'cimg::mutex(17)' locked, 'threshold' and 'count'
+    // being also read atomically without it).
+    // Mapped buffers are stored in a hash table with linear probing, kept at most half full ('capacity' is 0
+    // or a power of 2, empty slots have a null pointer).
+    struct _cimg_mmap_storage {
+      cimg_ulong threshold;
+      char path[1024];
+      unsigned int count, capacity;
+      void **ptrs;
+      cimg_ulong *sizes;
+    };
+
+    inline _cimg_mmap_storage& _mmap_storage() {
+      static _cimg_mmap_storage storage = { 0, { 0 }, 0, 0, 0, 0 };
+      return storage;
+    }
+
+    // Return first slot to look at for a mapped buffer (page-aligned) in a hash table of the out-of-core storage.
+    inline unsigned int _mmap_hash(const void *const ptr, const unsigned int capacity) {
+      return (unsigned int)(((size_t)ptr>>12)*2654435761U)&(capacity - 1);
+    }
+
+    // Return slot of a mapped buffer in a hash table of the out-of-core storage (or empty slot where to insert it).
+    inline unsigned int _mmap_slot(void *const *const ptrs, const unsigned int capacity, const void *const ptr) {
+      unsigned int k = _mmap_hash(ptr,capacity);
+      while (ptrs[k] && ptrs[k]!=ptr) k = (k + 1)&(capacity - 1);
+      return k;
+    }
+
+    //! Set out-of-core storage mode.
+    /**
+       Image buffers larger than a threshold are allocated in memory-mapped temporary files, so that the system can
+       page them out instead of swapping (or running out of memory).
+       \param threshold Minimal size (in bytes) of the buffers stored out-of-core, or \c 0 to disable (default).
+       \param path Directory where temporary files are created, or \c 0 to use cimg::temporary_path().
+       \note
+       - Only buffers of basic pixel types, allocated after the call, are concerned.
+       - Such buffers must be deallocated by \CImg: do not enable this mode when image buffers are released
+         by code using the light public 'gmic_image' API.
+       - A buffer which cannot be mapped is allocated in memory, with a warning.
+       - Not available on Windows (the mode is ignored).
+    **/
+    inline void mmap_mode(const cimg_ulong threshold, const char *const path) {
+#if cimg_OS==1
+      _cimg_mmap_storage &storage = _mmap_storage();
+      cimg::mutex(17);
+      __atomic_store_n(&storage.threshold,threshold,__ATOMIC_RELAXED);
+      if (path) std::strncpy(storage.path,path,sizeof(storage.path) - 1);
+      else *storage.path = 0;
+      cimg::mutex(17,0);
+#else
+      cimg::unused(threshold,path);
+#endif
+    }
+
+    //! Return minimal size (in bytes) of image buffers stored out-of-core (\c 0 if disabled).
+    inline cimg_ulong mmap_threshold() {
+#if cimg_OS==1
+      return __atomic_load_n(&_mmap_storage().threshold,__ATOMIC_RELAXED);
+#else
+      return 0;
+#endif
+    }
+
+    // Allocate a buffer in a memory-mapped temporary file (return 0 if not stored out-of-core).
+    inline void *_mmap_alloc(const cimg_ulong size) {
+#if cimg_OS==1
+      _cimg_mmap_storage &storage = _mmap_storage();
+      const cimg_ulong threshold = mmap_threshold();
+      if (!threshold || size<threshold) return 0;
+      char storage_path[sizeof(storage.path)];
+      cimg::mutex(17);
+      std::memcpy(storage_path,storage.path,sizeof(storage_path));
+      cimg::mutex(17,0);
+      const char *const path = *storage_path?storage_path:cimg::temporary_path();
+
+      // Filename buffer is not a 'CImg<char>', as its allocation could be stored out-of-core too.
+      const size_t siz_filename = std::strlen(path) + 64;
+      char *const filename = new char[siz_filename];
+      const char *error = 0;
+      void *ptr = 0;
+      cimg::mutex(17);
+      if (2*(storage.count + 1)>storage.capacity) { // Grow hash table of mapped buffers
+        const unsigned int capacity = storage.capacity?2*storage.capacity:512;
+        void **const ptrs = (void**)std::calloc(capacity,sizeof(void*));
+        cimg_ulong *const sizes = ptrs?(cimg_ulong*)std::malloc(capacity*sizeof(cimg_ulong)):0;
+        if (sizes) {
+          for (unsigned int k = 0; k<storage.capacity; ++k) if (storage.ptrs[k]) {
+              const unsigned int l = _mmap_slot(ptrs,capacity,storage.ptrs[k]);
+              ptrs[l] = storage.ptrs[k];
+              sizes[l] = storage.sizes[k];
+            }
+          std::free(storage.ptrs);
+          std::free(storage.sizes);
+          storage.ptrs = ptrs;
+          storage.sizes = sizes;
+          storage.capacity = capacity;
+        } else std::free(ptrs);
+      }
+      if (2*(storage.count + 1)>storage.capacity) error = "cannot extend list of mapped buffers";
+      else {
+        cimg_snprintf(filename,siz_filename,"%s%c%s_%u.cimg_mmap",
+                      path,cimg_file_separator,cimg::filenamerand(),storage.count);
+        const int fd = ::open(filename,O_RDWR | O_CREAT | O_EXCL,0600);
+        if (fd>=0) {
+          ::unlink(filename); // File is removed by the system once unmapped
+          if (!::ftruncate(fd,(off_t)size)) {
+            ptr = ::mmap(0,(size_t)size,PROT_READ | PROT_WRITE,MAP_SHARED,fd,0);
+            if (ptr==MAP_FAILED) { ptr = 0; error = "cannot map temporary file"; }
+          } else error = "cannot resize temporary file";
+          ::close(fd);
+        } else error = "cannot create temporary file";
+        if (ptr) {
+          const unsigned int k = _mmap_slot(storage.ptrs,storage.capacity,ptr);
+          storage.ptrs[k] = ptr;
+          storage.sizes[k] = size;
+          __atomic_store_n(&storage.count,storage.count + 1,__ATOMIC_RELAXED);
+        }
+      }
+      cimg::mutex(17,0);
+      if (error)
+        cimg::warn("cimg::mmap_mode(): Failed to store buffer of %lu bytes out-of-core in '%s' (%s), "
+                   "allocating it in memory.",
+                   (unsigned long)size,path,error);
+      delete[] filename;
+      return ptr;
+#else
+      cimg::unused(size);
+      return 0;
+#endif
+    }
+
+    // Deallocate a buffer stored out-of-core (return false if 'ptr' has not been allocated by '_mmap_alloc()').
+    inline bool _mmap_free(void *const ptr) {
+#if cimg_OS==1
+      _cimg_mmap_storage &storage = _mmap_storage();
+
+      // Mapped buffers are page-aligned: other buffers are released without locking, in most cases.
+      if (!ptr || ((size_t)ptr&4095) || !__atomic_load_n(&storage.count,__ATOMIC_RELAXED)) return false;
+      cimg_ulong size = 0;
+      cimg::mutex(17);
+      if (storage.capacity) {
+        const unsigned int mask = storage.capacity - 1;
+        unsigned int k = _mmap_slot(storage.ptrs,storage.capacity,ptr);
+        if (storage.ptrs[k]) {
+          size = storage.sizes[k];
+          storage.ptrs[k] = 0;
+          __atomic_store_n(&storage.count,storage.count - 1,__ATOMIC_RELAXED);
+          for (unsigned int l = (k + 1)&mask; storage.ptrs[l]; l = (l + 1)&mask) {
+            // Move back next buffers of the cluster that can be stored in the freed slot.
+            const unsigned int h = _mmap_hash(storage.ptrs[l],storage.capacity);
+            if (((l - h)&mask)>=((l - k)&mask)) {
+              storage.ptrs[k] = storage.ptrs[l];
+              storage.sizes[k] = storage.sizes[l];
+              storage.ptrs[l] = 0;
+              k = l;
+            }
+          }
+        }
+      }
+      cimg::mutex(17,0);
+      if (!size) return false;
+      ::munmap(ptr,(size_t)size);
+      return true;
+#else
+      cimg::unused(ptr);
+      return false;
+#endif
+    }
+
     //! Get/set path to the \c wget binary.
     /**
        \param user_path Specified path, or \c 0 to get the path currently used.
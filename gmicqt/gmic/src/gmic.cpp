@@ -1785,6 +1785,13 @@ static CImg<T> copy_rounded(const CImg<T>& list) {
 
 #include "gmic.h"
 #include "gmic_stdlib_community.h"
+#if cimg_OS==1
+#include <sys/mman.h>
+#endif
+#if cimg_use_cpp11==1
+#include <atomic>
+#include <mutex>
+#endif
 using namespace gmic_library;
 
 // Define convenience macros, variables and functions.
@@ -1952,6 +1959,183 @@ inline char *_gmic_argument_text(const char *const argument, char *const argumen
    continue; \
  }
 
+// Fusion of consecutive pointwise commands (e.g. '+ 10 * 1.2 cut 0,255 round') into a single pass.
+// Each fused operation casts its result to the pixel type, exactly as the corresponding command does,
+// so fused and non-fused pipelines give bit-identical results.
+enum {
+  gmic_pointwise_add, gmic_pointwise_sub, gmic_pointwise_mul, gmic_pointwise_div, gmic_pointwise_pow,
+  gmic_pointwise_mod, gmic_pointwise_min, gmic_pointwise_max, gmic_pointwise_cut, gmic_pointwise_round,
+  gmic_pointwise_abs, gmic_pointwise_sign, gmic_pointwise_sqr, gmic_pointwise_sqrt, gmic_pointwise_exp,
+  gmic_pointwise_log, gmic_pointwise_log2, gmic_pointwise_log10, gmic_pointwise_cos, gmic_pointwise_sin,
+  gmic_pointwise_tan
+};
+#define gmic_pointwise_block 4096
+
+// Split a raw command item into its pointwise opcode and selection suffix (return -1 if not fusable).
+static int gmic_pointwise_opcode(const char *item, const char* &selection) {
+  static const char *const names[] = {
+    "add","sub","mul","div","pow","mod","min","max","cut","round",
+    "abs","sign","sqr","sqrt","exp","log","log2","log10","cos","sin","tan" };
+  int opcode = -1;
+  switch (*item) {
+  case '+' : opcode = gmic_pointwise_add; break;
+  case '-' : opcode = gmic_pointwise_sub; break;
+  case '*' : opcode = gmic_pointwise_mul; break;
+  case '/' : opcode = gmic_pointwise_div; break;
+  case '^' : opcode = gmic_pointwise_pow; break;
+  case '%' : opcode = gmic_pointwise_mod; break;
+  }
+  if (opcode>=0) selection = item + 1;
+  else {
+    if (*item=='-') ++item;
+    const char *ps = item;
+    while ((*ps>='a' && *ps<='z') || (*ps>='0' && *ps<='9')) ++ps;
+    if (ps==item) return -1;
+    const unsigned int l = (unsigned int)(ps - item);
+    if (l==1 && *item=='c') opcode = gmic_pointwise_cut;
+    else for (unsigned int k = 0; k<sizeof(names)/sizeof(char*); ++k)
+           if (!std::strncmp(item,names[k],l) && !names[k][l]) { opcode = (int)k; break; }
+    selection = ps;
+  }
+  if (opcode>=0 && *selection) { // Only accept '[selection]' and '.', '..' or '...' shortcuts
+    const unsigned int l = (unsigned int)std::strlen(selection);
+    if (*selection=='[') { if (selection[l - 1]!=']' || std::strcspn(selection + 1,"[]")!=l - 2) opcode = -1; }
+    else if (l>3 || std::strspn(selection,".")!=l) opcode = -1;
+  }
+  return opcode;
+}
+
+// Parse the longest run of fusable pointwise commands starting at 'position', all with the same selection
+// and with numeric, non-substituted arguments.
+// Return the number of parsed commands, 'ops' being filled with one '[opcode,arg0,arg1]' row per command,
+// and 'position' being set to the first non-parsed item.
+static unsigned int gmic_pointwise_commands(const CImgList<char>& commands_line, unsigned int& position,
+                                            CImg<double>& ops) {
+  CImg<char> argx(256), argy(256);
+  const char *selection0 = 0, *selection = 0;
+  unsigned int p = position, nb_ops = 0;
+  double value, value0, value1;
+  int rounding_type;
+  char end;
+  ops.assign(3,16);
+  while (p<commands_line.size()) {
+    const CImg<char>& item = commands_line[p];
+    if (*item==1 || item.back()) break; // Debug info or substituted item
+    const int opcode = gmic_pointwise_opcode(item,selection);
+    if (opcode<0 || (selection0 && std::strcmp(selection,selection0))) break;
+    const CImg<char> *const argument = p + 1<commands_line.size()?&commands_line[p + 1]:0;
+    const bool is_argument = argument && **argument!=1 && !argument->back();
+    value0 = value1 = 0;
+    unsigned int nb_items = 1;
+    if (opcode<=gmic_pointwise_max) {
+      if (!is_argument || cimg_sscanf(*argument,"%lf%c",&value0,&end)!=1) break;
+      nb_items = 2;
+    } else if (opcode==gmic_pointwise_cut) {
+      if (!is_argument ||
+          cimg_sscanf(*argument,"%255[][a-zA-Z0-9_.eE%+-],%255[][a-zA-Z0-9_.eE%+-]%c",
+                      argx.data(),argy.data(),&end)!=2 ||
+          cimg_sscanf(argx,"%lf%c",&value0,&end)!=1 ||
+          cimg_sscanf(argy,"%lf%c",&value1,&end)!=1) break;
+      nb_items = 2;
+    } else if (opcode==gmic_pointwise_round) {
+      if (argument && !is_argument) break; // Unknown argument: cannot decide if it belongs to 'round'
+      value0 = 1; rounding_type = 0;
+      if (argument &&
+          (cimg_sscanf(*argument,"%lf%c",&value,&end)==1 ||
+           cimg_sscanf(*argument,"%lf,%d%c",&value,&rounding_type,&end)==2) &&
+          value>=0 && rounding_type>=-1 && rounding_type<=1) {
+        value0 = value; value1 = rounding_type; nb_items = 2;
+      } else rounding_type = 0;
+    }
+    if (nb_ops>=ops._height) ops.resize(3,2*ops._height,1,1,0);
+    ops(0,nb_ops) = opcode; ops(1,nb_ops) = value0; ops(2,nb_ops) = value1;
+    ++nb_ops;
+    selection0 = selection;
+    p+=nb_items;
+  }
+  position = p;
+  ops.resize(3,nb_ops,1,1,0);
+  return nb_ops;
+}
+
+// Apply a run of fused pointwise operations (as parsed by 'gmic_pointwise_commands()') on an image.
+// Operations are applied block by block, so the image is traversed only once.
+template<typename T>
+static void gmic_pointwise(CImg<T>& img, const CImg<double>& ops) {
+  typedef typename CImg<T>::Tfloat Tfloat;
+  const cimg_long siz = (cimg_long)img.size();
+  cimg_pragma_openmp(parallel for cimg_openmp_if_size(siz,16384))
+  for (cimg_long off = 0; off<siz; off+=gmic_pointwise_block) {
+    T *const ptrb = img._data + off, *const ptre = ptrb + std::min((cimg_long)gmic_pointwise_block,siz - off);
+    cimg_forY(ops,k) {
+      const double arg0 = ops(1,k), arg1 = ops(2,k);
+      switch ((int)ops(0,k)) {
+      case gmic_pointwise_add : {
+        const Tfloat val = (Tfloat)arg0;
+        for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)(*ptr + val);
+      } break;
+      case gmic_pointwise_sub : {
+        const Tfloat val = (Tfloat)arg0;
+        for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)(*ptr - val);
+      } break;
+      case gmic_pointwise_mul : {
+        const Tfloat val = (Tfloat)arg0;
+        for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)(*ptr * val);
+      } break;
+      case gmic_pointwise_div : {
+        const Tfloat val = (Tfloat)arg0;
+        for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)(*ptr / val);
+      } break;
+      case gmic_pointwise_pow : { // Same special cases as 'CImg<T>::pow(double)'
+        const double p = (double)(Tfloat)arg0;
+        if (p==-4) for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)(1/(Tfloat)cimg::pow4(*ptr));
+        else if (p==-3) for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)(1/(Tfloat)cimg::pow3(*ptr));
+        else if (p==-2) for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)(1/(Tfloat)cimg::sqr(*ptr));
+        else if (p==-1) for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)(1/(Tfloat)*ptr);
+        else if (p==-0.5) for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)(1/std::sqrt((Tfloat)*ptr));
+        else if (p==0) for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)1;
+        else if (p==0.5) for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)std::sqrt((Tfloat)*ptr);
+        else if (p==2) for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)cimg::sqr((Tfloat)*ptr);
+        else if (p==3) for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)cimg::pow3(*ptr);
+        else if (p==4) for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)cimg::pow4(*ptr);
+        else if (p!=1) for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)std::pow((Tfloat)*ptr,(Tfloat)p);
+      } break;
+      case gmic_pointwise_mod : {
+        const T val = (T)arg0;
+        for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)cimg::mod(*ptr,val);
+      } break;
+      case gmic_pointwise_min : {
+        const T val = (T)arg0;
+        for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = std::min(*ptr,val);
+      } break;
+      case gmic_pointwise_max : {
+        const T val = (T)arg0;
+        for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = std::max(*ptr,val);
+      } break;
+      case gmic_pointwise_cut : {
+        const T val0 = (T)arg0, val1 = (T)arg1, a = val0<val1?val0:val1, b = val0<val1?val1:val0;
+        for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)cimg::cut(*ptr,a,b);
+      } break;
+      case gmic_pointwise_round : if (arg0>0) {
+          const int rounding_type = (int)arg1;
+          for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)cimg::round(*ptr,arg0,rounding_type);
+        } break;
+      case gmic_pointwise_abs : for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)cimg::abs((Tfloat)*ptr); break;
+      case gmic_pointwise_sign : for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)cimg::sign((Tfloat)*ptr); break;
+      case gmic_pointwise_sqr : for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)cimg::sqr((Tfloat)*ptr); break;
+      case gmic_pointwise_sqrt : for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)std::sqrt((Tfloat)*ptr); break;
+      case gmic_pointwise_exp : for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)std::exp((Tfloat)*ptr); break;
+      case gmic_pointwise_log : for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)std::log((Tfloat)*ptr); break;
+      case gmic_pointwise_log2 : for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)cimg::log2((Tfloat)*ptr); break;
+      case gmic_pointwise_log10 : for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)std::log10((Tfloat)*ptr); break;
+      case gmic_pointwise_cos : for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)std::cos((Tfloat)*ptr); break;
+      case gmic_pointwise_sin : for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)std::sin((Tfloat)*ptr); break;
+      case gmic_pointwise_tan : for (T *ptr = ptrb; ptr<ptre; ++ptr) *ptr = (T)std::tan((Tfloat)*ptr); break;
+      }
+    }
+  }
+}
+
 // Return true if specified character is considered as 'blank'.
 inline bool is_blank(const char x) {
   return (x>1 && x<gmic_dollar) || (x>gmic_store && x<=' ');
@@ -2490,6 +2674,22 @@ const char *gmic::builtin_commands_names[] = {
 
 CImg<int> gmic::builtin_commands_inds = CImg<int>::empty();
 
+// Lock/unlock the command tables of an interpreter instance.
+// Command tables are owned by each instance, so independent interpreters use different lock stripes
+// and can import their commands concurrently (instead of being serialized on a global mutex).
+#if cimg_use_cpp11==1
+static std::mutex& gmic_commands_mutex(const void *const p_instance) {
+  static std::mutex mutexes[16];
+  return mutexes[((cimg_ulong)p_instance/sizeof(void*))%16];
+}
+#define gmic_lock_commands(p_instance) gmic_commands_mutex(p_instance).lock()
+#define gmic_unlock_commands(p_instance) gmic_commands_mutex(p_instance).unlock()
+static std::atomic<bool> is_builtin_commands_inds_ready(false), is_stdlib_ready(false);
+#else
+#define gmic_lock_commands(p_instance) cimg::mutex(23)
+#define gmic_unlock_commands(p_instance) cimg::mutex(23,0)
+#endif
+
 // Perform a dichotomic search in a lexicographic ordered 'CImgList<char>' or 'char**'.
 // Return false or true if search succeeded.
 template<typename T>
@@ -2635,13 +2835,13 @@ gmic &gmic::assign(const gmic &gmic_instance) {
   CImgList<gmic_pixel_type> images;
   CImgList<char> images_names;
   _gmic(0,images,images_names,0,false,0,0);
-  cimg::mutex(23);
+  gmic_lock_commands(&gmic_instance);
   for (unsigned int i = 0; i<gmic_comslots; ++i) {
     commands[i].assign(gmic_instance.commands[i],true);
     commands_names[i].assign(gmic_instance.commands_names[i],true);
     commands_has_arguments[i].assign(gmic_instance.commands_has_arguments[i],true);
   }
-  cimg::mutex(23,0);
+  gmic_unlock_commands(&gmic_instance);
   cimg::mutex(30);
   for (unsigned int i = 0; i<gmic_varslots; ++i) {
     if (i>=6*gmic_varslots/7) { // Share inter-thread global variables
@@ -2672,7 +2872,9 @@ gmic &gmic::assign(const gmic &gmic_instance) {
   _progress = 0;
   progress = &_progress;
   is_change = gmic_instance.is_change;
+  is_commands_changed = true;
   is_debug = gmic_instance.is_debug;
+  allow_fusion = gmic_instance.allow_fusion;
   is_start = false;
   is_quit = false;
   is_return = false;
@@ -2686,6 +2888,64 @@ gmic &gmic::assign(const gmic &gmic_instance) {
   return *this;
 }
 
+// Reset interpreter state from a reference instance.
+// Unlike 'assign(const gmic&)', command definitions are copied (not shared) so that commands
+// redefined during a run cannot alter the reference, and inter-thread variables stay private.
+// The reference is only read (it must not run or import commands meanwhile), so that several
+// instances can be reset concurrently from the same reference without locking its command tables.
+// With 'is_keep_commands', the caller guarantees that the last reset was from the same reference: command tables
+// are then only copied if they have been modified since.
+gmic &gmic::reset(const gmic &gmic_instance, float *const p_progress, bool *const p_is_abort,
+                  const bool is_keep_commands) {
+  if (&gmic_instance==this) return *this;
+  if (!is_keep_commands || is_commands_changed) {
+    for (unsigned int i = 0; i<gmic_comslots; ++i) {
+      commands[i].assign(gmic_instance.commands[i]);
+      commands_names[i].assign(gmic_instance.commands_names[i]);
+      commands_has_arguments[i].assign(gmic_instance.commands_has_arguments[i]);
+    }
+    commands_files.assign(gmic_instance.commands_files);
+    is_commands_changed = false;
+  }
+  cimg::mutex(30);
+  for (unsigned int i = 0; i<gmic_varslots; ++i) {
+    variables[i] = &_variables[i];
+    variables_names[i] = &_variables_names[i];
+    variables_lengths[i] = &_variables_lengths[i];
+    if (i>=gmic_varslots/2) { // Restore global variables
+      _variables[i].assign(*gmic_instance.variables[i]);
+      _variables_names[i].assign(*gmic_instance.variables_names[i]);
+      _variables_lengths[i].assign(*gmic_instance.variables_lengths[i]);
+    } else {
+      _variables[i].assign();
+      _variables_names[i].assign();
+      _variables_lengths[i].assign();
+    }
+  }
+  cimg::mutex(30,0);
+  callstack.assign();
+  light3d.assign(gmic_instance.light3d);
+  status.assign();
+  dowhiles.assign(); fordones.assign(); foreachdones.assign(); repeatdones.assign();
+  nb_dowhiles = nb_fordones = nb_foreachdones = nb_repeatdones = nb_remaining_fr = 0;
+  debug_filename = ~0U;
+  debug_line = ~0U;
+  light3d_x = gmic_instance.light3d_x;
+  light3d_y = gmic_instance.light3d_y;
+  light3d_z = gmic_instance.light3d_z;
+  progress = p_progress?p_progress:&_progress; *progress = -1;
+  is_abort = p_is_abort?p_is_abort:&_is_abort; *is_abort = false;
+  nb_carriages_default = nb_carriages_stdout = 0;
+  reference_time = (gmic_uint64)-1;
+  network_timeout = gmic_instance.network_timeout;
+  verbosity = gmic_instance.verbosity;
+  allow_main_ = is_debug = is_debug_info = is_running = false;
+  allow_fusion = gmic_instance.allow_fusion;
+  is_change = is_start = is_quit = is_return = is_abort_thread = is_lbrace_command = false;
+  starting_commands_line = 0;
+  return *this;
+}
+
 template<typename T>
 gmic::gmic(const char *const commands_line, const char *const custom_commands,
            const bool include_stdlib, float *const p_progress, bool *const p_is_abort,
@@ -2724,6 +2984,7 @@ gmic::~gmic() {
   delete[] commands;
   delete[] commands_names;
   delete[] commands_has_arguments;
+  release_commands_cache();
   delete[] _variables;
   delete[] _variables_names;
   delete[] _variables_lengths;
@@ -2736,6 +2997,9 @@ gmic::~gmic() {
 // Decompress G'MIC standard library commands.
 //---------------------------------------------
 const CImg<char>& gmic::decompress_stdlib() {
+#if cimg_use_cpp11==1
+  if (is_stdlib_ready.load(std::memory_order_acquire) && stdlib) return stdlib; // Lock-free once decompressed
+#endif
   cimg::mutex(22);
   if (!stdlib) try {
       CImgList<char>::get_unserialize(CImg<unsigned char>(data_gmic,1,size_data_gmic,1,1,true))[0].
@@ -2749,6 +3013,9 @@ const CImg<char>& gmic::decompress_stdlib() {
       cimg::mutex(29,0);
       stdlib.assign(1,1,1,1,0);
     }
+#if cimg_use_cpp11==1
+  is_stdlib_ready.store(true,std::memory_order_release);
+#endif
   cimg::mutex(22,0);
   return stdlib;
 }
@@ -3552,7 +3819,8 @@ const char *gmic::set_variable(const char *const name, const CImg<unsigned char>
 gmic& gmic::add_commands(const char *const data_commands, const char *const commands_file, const bool add_debug_info,
                          unsigned int *count_new, unsigned int *count_replaced, bool *const is_main_) {
   if (!data_commands || !*data_commands) return *this;
-  cimg::mutex(23);
+  gmic_lock_commands(this);
+  is_commands_changed = true;
   CImg<char> s_body(256*1024), s_line(256*1024), s_name(257), debug_info(32);
   unsigned int line_number = 0, pos = 0;
   bool is_last_slash = false, _is_last_slash = false, is_newline = false;
@@ -3636,7 +3904,12 @@ gmic& gmic::add_commands(const char *const data_commands, const char *const comm
         commands[hash].insert(1,pos);
         commands_has_arguments[hash].insert(1,pos);
         if (count_new) ++*count_new;
-      } else if (count_replaced) ++*count_replaced;
+      } else { // Replaced command may share its data with a precompiled command table
+        commands_names[hash][pos].assign();
+        commands[hash][pos].assign();
+        commands_has_arguments[hash][pos].assign();
+        if (count_replaced) ++*count_replaced;
+      }
       CImg<char>::string(s_name).move_to(commands_names[hash][pos]);
       CImg<char>::vector((char)command_has_arguments(body)).
         move_to(commands_has_arguments[hash][pos]);
@@ -3660,7 +3933,7 @@ gmic& gmic::add_commands(const char *const data_commands, const char *const comm
       } else commands[hash][pos].append(body,'x'); // Insert code without debug info
     }
   }
-  cimg::mutex(23,0);
+  gmic_unlock_commands(this);
   return *this;
 }
 
@@ -3692,6 +3965,363 @@ gmic& gmic::add_commands(std::FILE *const file, const char *const commands_file,
   return *this;
 }
 
+// Save/load command definitions as a precompiled table.
+//------------------------------------------------------
+// File layout: a text header 'GMZcmd version comslots nb_entries data_size key\n', followed by
+// 'nb_entries' records of 3 unsigned ints (slot, name size, body size), then for each entry,
+// the 'has_arguments' flag, the name and the body, exactly as stored in the command tables.
+// Entries are written in slot order and in sorted order within each slot, so that loading them
+// does not require any parsing or sorting.
+bool gmic::save_commands_cache(const char *const filename, const char *const key) const {
+  if (!filename || !*filename || !key || !*key) return false;
+  for (const char *s = key; *s; ++s) if (is_blank(*s) || *s=='\n') return false;
+  gmic_lock_commands(this);
+  unsigned int nb_entries = 0;
+  cimg_uint64 data_size = 0;
+  for (unsigned int i = 0; i<gmic_comslots; ++i) {
+    nb_entries+=commands[i].size();
+    cimglist_for(commands[i],l) data_size+=1 + commands_names[i][l].size() + commands[i][l].size();
+  }
+  CImg<unsigned int> records(3,nb_entries);
+  unsigned int *ptrd = records.data();
+  for (unsigned int i = 0; i<gmic_comslots; ++i) cimglist_for(commands[i],l) {
+      *(ptrd++) = i;
+      *(ptrd++) = (unsigned int)commands_names[i][l].size();
+      *(ptrd++) = (unsigned int)commands[i][l].size();
+    }
+  CImg<char> tmp_filename(std::strlen(filename) + 16);
+  cimg_snprintf(tmp_filename,tmp_filename.width(),"%s.%s",filename,cimg::filenamerand());
+  std::FILE *const file = cimg::std_fopen(tmp_filename,"wb");
+  bool is_written = file!=0;
+  if (file) {
+    std::fprintf(file,"GMZcmd %u %u %u " cimg_fuint64 " %s\n",
+                 (unsigned int)gmic_version,(unsigned int)gmic_comslots,nb_entries,data_size,key);
+    if (nb_entries) is_written = std::fwrite(records.data(),sizeof(unsigned int),records.size(),file)==records.size();
+    for (unsigned int i = 0; is_written && i<gmic_comslots; ++i) cimglist_for(commands[i],l) {
+        const char has_arguments = commands_has_arguments[i][l]?*commands_has_arguments[i][l].data():0;
+        is_written&=std::fputc(has_arguments,file)!=EOF;
+        const CImg<char> &name = commands_names[i][l], &body = commands[i][l];
+        if (name) is_written&=std::fwrite(name.data(),1,name.size(),file)==name.size();
+        if (body) is_written&=std::fwrite(body.data(),1,body.size(),file)==body.size();
+      }
+    is_written&=!std::fclose(file);
+  }
+  gmic_unlock_commands(this);
+  if (is_written) { // Replace file only when fully written (a previous version may still be mapped)
+#if cimg_OS==2
+    std::remove(filename);
+#endif
+    is_written = !std::rename(tmp_filename,filename);
+  }
+  if (!is_written) std::remove(tmp_filename);
+  return is_written;
+}
+
+bool gmic::load_commands_cache(const char *const filename, const char *const key) {
+  if (!filename || !*filename || !key || !*key) return false;
+  char *buffer = 0;
+  cimg_uint64 siz = 0;
+#if cimg_OS==1
+  const int fd = open(filename,O_RDONLY);
+  if (fd<0) return false;
+  struct stat st;
+  if (!fstat(fd,&st) && st.st_size>0) {
+    siz = (cimg_uint64)st.st_size;
+    void *const ptr = mmap(0,(size_t)siz,PROT_READ | PROT_WRITE,MAP_PRIVATE,fd,0); // Copy-on-write
+    if (ptr!=MAP_FAILED) buffer = (char*)ptr;
+  }
+  close(fd);
+#else
+  std::FILE *const file = cimg::std_fopen(filename,"rb");
+  if (!file) return false;
+  const cimg_int64 fsiz = cimg::fsize(file);
+  if (fsiz>0) {
+    siz = (cimg_uint64)fsiz;
+    buffer = new char[(size_t)siz];
+    if (std::fread(buffer,1,(size_t)siz,file)!=(size_t)siz) { delete[] buffer; buffer = 0; }
+  }
+  std::fclose(file);
+#endif
+  if (!buffer) return false;
+
+  // Check header.
+  CImg<char> s_key(256);
+  unsigned int version = 0, comslots = 0, nb_entries = 0;
+  cimg_uint64 data_size = 0;
+  int header_size = 0;
+  bool is_valid = siz>6 && !std::strncmp(buffer,"GMZcmd",6);
+  if (is_valid) {
+    const char *const eol = (const char*)std::memchr(buffer,'\n',(size_t)std::min(siz,(cimg_uint64)512));
+    is_valid = eol && std::sscanf(buffer,"GMZcmd %u %u %u " cimg_fuint64 " %255s%n",
+                                  &version,&comslots,&nb_entries,&data_size,s_key.data(),&header_size)==5 &&
+      buffer + header_size==eol && version==gmic_version && comslots==gmic_comslots && !std::strcmp(s_key,key) &&
+      siz==(cimg_uint64)header_size + 1 + 3*sizeof(unsigned int)*(cimg_uint64)nb_entries + data_size;
+  }
+  if (!is_valid) {
+#if cimg_OS==1
+    munmap(buffer,(size_t)siz);
+#else
+    delete[] buffer;
+#endif
+    return false;
+  }
+
+  // Adopt command tables, as images sharing the file buffer.
+  const CImg<unsigned int> records((unsigned int*)(buffer + header_size + 1),3,nb_entries,1,1,false);
+  CImg<unsigned int> counts(gmic_comslots,1,1,1,0);
+  cimg_forY(records,l) if (records(0,l)<gmic_comslots) ++counts[records(0,l)];
+  CImgList<char>
+    *const ncommands = new CImgList<char>[gmic_comslots],
+    *const ncommands_names = new CImgList<char>[gmic_comslots],
+    *const ncommands_has_arguments = new CImgList<char>[gmic_comslots];
+  for (unsigned int i = 0; i<gmic_comslots; ++i) {
+    ncommands[i].assign(counts[i]);
+    ncommands_names[i].assign(counts[i]);
+    ncommands_has_arguments[i].assign(counts[i]);
+  }
+  counts.fill(0);
+  char *ptrs = buffer + header_size + 1 + 3*sizeof(unsigned int)*nb_entries;
+  const char *const ptre = buffer + siz;
+  cimg_forY(records,l) {
+    const unsigned int slot = records(0,l), name_size = records(1,l), body_size = records(2,l);
+    if (slot>=gmic_comslots || ptrs + 1 + (cimg_uint64)name_size + body_size>ptre) { is_valid = false; break; }
+    const unsigned int pos = counts[slot]++;
+    ncommands_has_arguments[slot][pos].assign(ptrs++,1,1,1,1,true);
+    ncommands_names[slot][pos].assign(ptrs,name_size,1,1,1,true); ptrs+=name_size;
+    ncommands[slot][pos].assign(ptrs,body_size,1,1,1,true); ptrs+=body_size;
+  }
+  if (!is_valid) {
+    delete[] ncommands; delete[] ncommands_names; delete[] ncommands_has_arguments;
+#if cimg_OS==1
+    munmap(buffer,(size_t)siz);
+#else
+    delete[] buffer;
+#endif
+    return false;
+  }
+  gmic_lock_commands(this);
+  is_commands_changed = true;
+  delete[] commands; commands = ncommands;
+  delete[] commands_names; commands_names = ncommands_names;
+  delete[] commands_has_arguments; commands_has_arguments = ncommands_has_arguments;
+  gmic_unlock_commands(this);
+  release_commands_cache();
+  commands_cache = buffer;
+  commands_cache_size = (gmic_uint64)siz;
+  return true;
+}
+
+// Release buffer of precompiled command tables (must not be referenced by command tables anymore).
+void gmic::release_commands_cache() {
+  if (!commands_cache) return;
+#if cimg_OS==1
+  munmap(commands_cache,(size_t)commands_cache_size);
+#else
+  delete[] (char*)commands_cache;
+#endif
+  commands_cache = 0;
+  commands_cache_size = 0;
+}
+
+// Substitute '$i', '${i}', '${i=default}', '$*' and '$#' in the body of a custom command (for 'get_halo()').
+// Other '$' expressions are kept as is, so that the corresponding items still require substitution.
+static CImg<char> gmic_substitute_arguments(const char *const body, const CImgList<char>& arguments,
+                                            const char *const argument) {
+  CImgList<char> res;
+  const unsigned int nb_arguments = arguments.size() - 1;
+  CImg<char> str(32);
+  for (const char *s = body; *s; ) {
+    const char *const s0 = s;
+    if (*s!='$') {
+      while (*s && *s!='$') ++s;
+      CImg<char>(s0,(unsigned int)(s - s0)).move_to(res);
+      continue;
+    }
+    if (s[1]=='*') { CImg<char>::string(argument,false).move_to(res); s+=2; continue; }
+    if (s[1]=='#') {
+      cimg_snprintf(str,str.width(),"%u",nb_arguments);
+      CImg<char>::string(str,false).move_to(res); s+=2; continue;
+    }
+    const bool is_braces = s[1]=='{';
+    const char *ps = s + 1 + (is_braces?1:0), *pd = 0, *pde = 0;
+    unsigned int ind = 0;
+    while (*ps>='0' && *ps<='9') ind = 10*ind + *(ps++) - '0';
+    if (ps==s + 1 + (is_braces?1:0) || !ind) { CImg<char>::string("$",false).move_to(res); ++s; continue; }
+    if (is_braces) {
+      if (*ps=='=') { // Default value
+        unsigned int level = 1;
+        for (pd = pde = ps + 1; *pde && (*pde!='}' || --level); ++pde) if (*pde=='{') ++level;
+        if (!*pde) { CImg<char>::string("$",false).move_to(res); ++s; continue; }
+        ps = pde;
+      }
+      if (*ps!='}') { CImg<char>::string("$",false).move_to(res); ++s; continue; }
+      ++ps;
+    }
+    if (ind<=nb_arguments && *arguments[ind]) CImg<char>::string(arguments[ind],false).move_to(res);
+    else if (pd) CImg<char>(pd,(unsigned int)(pde - pd)).move_to(res);
+    else CImg<char>(s,(unsigned int)(ps - s)).move_to(res); // Undefined argument
+    s = ps;
+  }
+  CImg<char>::vector(0).move_to(res);
+  return res>'x';
+}
+
+// Estimate the halo (in pixels) a pipeline needs around an image region, so that running it on the region
+// extended by this halo gives the same values inside the region as running it on the whole image.
+// Only built-in commands known to be local are handled. Custom commands are expanded, with their
+// '$i', '${i}', '${i=default}', '$*' and '$#' arguments substituted.
+// Analysis stops at the first command listed in 'roi_commands' (comma-separated names), which is then
+// expected to crop the region by itself, and 'is_roi_command' is set to true.
+// Return -1 if the halo cannot be determined (non-local or unknown command, item requiring substitution).
+// The estimate is approximate: Gaussian-like filters get a '4*sigma' halo (not an exact bound), and the
+// arguments of custom commands are split at every ',' (quotes, brackets and math expressions are not parsed).
+// Only the command tables and the debug info of the interpreter are accessed.
+int gmic::get_halo(const char *const commands_line, const char *const roi_commands, bool *const is_roi_command) {
+  bool is_roi = false;
+  int res = -1;
+  try { res = _get_halo(commands_line,roi_commands,is_roi,0); } catch (...) { res = -1; is_roi = false; }
+  if (is_roi_command) *is_roi_command = res>=0 && is_roi;
+  return res;
+}
+
+int gmic::_get_halo(const char *const commands_line, const char *const roi_commands, bool& is_roi,
+                    const unsigned int depth) {
+  static const char *const pointwise_commands[] = {
+    "abs","acos","acosh","asin","asinh","atan","atanh","cos","cosh","done","erf","exp","keep","k","l","local",
+    "log","log10","log2","remove","reverse","rm","rv","sign","sin","sinc","sinh","sqr","sqrt","tan","tanh",0 };
+  static const char *const arithmetic_commands[] = {
+    "add","+","sub","-","mul","*","div","/","pow","^","mod","%","min","max","and","&","or","|","xor",
+    "bsl","<<","bsr",">>","rol","ror","eq","==","neq","!=","gt",">","ge",">=","lt","<","le","<=",0 };
+  static const char *const argument_commands[] = { "move","mv","name","nm","=>","status","u","verbose","v",0 };
+  if (!commands_line || depth>16) return -1;
+  const CImgList<char> items = commands_line_to_CImgList(commands_line);
+  CImg<char> name(256), argx(256), argy(256);
+  double halo = 0, value, value0, value1;
+  unsigned int nb_iterations, uind;
+  char end;
+
+  for (unsigned int p = 0; p<items.size(); ++p) {
+    if (*items[p]==1 || (*items[p]==',' && !items(p,1))) continue; // Debug info or separator
+    if (items[p].back()) return -1; // Item requires substitution
+    const char *s = items[p];
+    if ((*s=='-' || *s=='+') && s[1] && s[1]!='[' && s[1]!='.') ++s;
+    const char *se = s;
+    while (*se && *se!='[') ++se;
+    while (se>s + 1 && se[-1]=='.') --se;
+    if (se==s || se - s>=name.width()) return -1;
+    std::memcpy(name,s,se - s); name[se - s] = 0;
+    const CImg<char> *const argument = p + 1<items.size() && *items[p + 1]!=1?&items[p + 1]:0;
+    const bool is_argument = argument && !argument->back();
+
+    if (roi_commands) { // Check for commands cropping the region of interest
+      const unsigned int l = (unsigned int)std::strlen(name);
+      for (const char *r = roi_commands; *r; ) {
+        if (!std::strncmp(r,name,l) && (r[l]==',' || !r[l])) { is_roi = true; return (int)std::ceil(halo); }
+        r = std::strchr(r,',');
+        if (!r) break;
+        ++r;
+      }
+    }
+
+    bool is_found = false;
+    for (unsigned int k = 0; pointwise_commands[k] && !is_found; ++k)
+      is_found = !std::strcmp(name,pointwise_commands[k]);
+    if (is_found) continue;
+
+    for (unsigned int k = 0; arithmetic_commands[k] && !is_found; ++k)
+      is_found = !std::strcmp(name,arithmetic_commands[k]);
+    if (is_found) { // Pointwise with a value or an image, or between images
+      if (!argument) continue;
+      if (!is_argument || **argument=='\'' ||
+          (**argument!='[' && cimg_sscanf(*argument,"%lf%c",&value,&end)==2)) return -1;
+      if (**argument=='[' || cimg_sscanf(*argument,"%lf%c",&value,&end)==1) ++p;
+      continue;
+    }
+
+    for (unsigned int k = 0; argument_commands[k] && !is_found; ++k)
+      is_found = !std::strcmp(name,argument_commands[k]);
+    if (is_found) {
+      if (!is_argument) return -1;
+      ++p;
+      continue;
+    }
+
+    if (!std::strcmp(name,"cut") || !std::strcmp(name,"c")) {
+      if (!is_argument ||
+          cimg_sscanf(*argument,"%255[][a-zA-Z0-9_.eE%+-],%255[][a-zA-Z0-9_.eE%+-]%c",
+                      argx.data(),argy.data(),&end)!=2 ||
+          cimg_sscanf(argx,"%lf%c",&value,&end)!=1 || cimg_sscanf(argy,"%lf%c",&value,&end)!=1) return -1;
+      ++p;
+      continue;
+    }
+    if (!std::strcmp(name,"round")) {
+      if (argument && !is_argument) return -1;
+      if (argument && (cimg_sscanf(*argument,"%lf%c",&value,&end)==1 ||
+                       cimg_sscanf(*argument,"%lf,%lf%c",&value,&value0,&end)==2)) ++p;
+      continue;
+    }
+
+    if (!std::strcmp(name,"blur") || !std::strcmp(name,"b") ||
+        !std::strcmp(name,"deriche") || !std::strcmp(name,"vanvliet") || !std::strcmp(name,"bilateral")) {
+      // Gaussian-like filters: a '4*sigma' halo makes the truncated part of the kernel negligible.
+      const char *arg = is_argument?argument->data():0;
+      if (arg && *name=='b' && name[1]=='i' && *arg=='[') { // Guided bilateral
+        arg = std::strchr(arg,']');
+        if (arg && *(++arg)==',') ++arg; else arg = 0;
+      }
+      if (!arg || (cimg_sscanf(arg,"%lf%c",&value,&end)!=1 && (cimg_sscanf(arg,"%lf%c",&value,&end)!=2 ||
+                                                                end!=',')) ||
+          value<0) return -1;
+      halo+=4*value;
+      ++p;
+      continue;
+    }
+    if (!std::strcmp(name,"erode") || !std::strcmp(name,"dilate") ||
+        !std::strcmp(name,"median") || !std::strcmp(name,"boxfilter")) {
+      value = value0 = value1 = 0; nb_iterations = 1; end = 0;
+      if (!is_argument || **argument=='[' ||
+          cimg_sscanf(*argument,"%lf%c",&value,&end)<1 || value<0 ||
+          (end!=0 && end!=',')) return -1;
+      if (*name=='e' || *name=='d') { // Possibly anisotropic structuring element
+        if (cimg_sscanf(*argument,"%lf,%lf,%lf%c",&value,&value0,&value1,&end)>=2)
+          value = std::max(value,std::max(value0,value1));
+      } else if (*name=='b' && cimg_sscanf(*argument,"%lf,%lf,%lf,%u%c",
+                                           &value,&value0,&value1,&nb_iterations,&end)>=4)
+        value*=nb_iterations;
+      halo+=std::ceil(value/2);
+      ++p;
+      continue;
+    }
+
+    const int
+      _ind0 = builtin_commands_inds[(unsigned int)*name],
+      _ind1 = builtin_commands_inds((unsigned int)*name,1U);
+    if (_ind0>=0 && search_sorted(name.data(),builtin_commands_names + _ind0,_ind1 - _ind0 + 1U,uind))
+      return -1; // Non-local or unsupported built-in command
+
+    // Expand custom command.
+    const unsigned int hash = hashcode(name,false);
+    if (!search_sorted(name.data(),commands_names[hash],commands_names[hash].size(),uind)) return -1;
+    CImgList<char> arguments;
+    CImg<char>::string(name).move_to(arguments);
+    if (commands_has_arguments[hash](uind,0) && argument) {
+      if (!is_argument) return -1;
+      // Naive split, as for arguments without quotes, brackets or math expressions.
+      for (const char *ss = *argument, *_ss = ss; _ss; ss = _ss + 1) {
+        _ss = std::strchr(ss,',');
+        CImg<char>(ss,(unsigned int)(_ss?_ss - ss + 1:std::strlen(ss) + 1)).move_to(arguments).back().back() = 0;
+      }
+      ++p;
+    }
+    const int res = _get_halo(gmic_substitute_arguments(commands[hash][uind],arguments,argument?argument->data():""),
+                              roi_commands,is_roi,depth + 1);
+    if (res<0) return -1;
+    halo+=res;
+    if (is_roi) break;
+  }
+  return (int)std::ceil(halo);
+}
+
 // Return subset indices from a selection string, as a 1-column vector.
 //---------------------------------------------------------------------
 CImg<unsigned int> gmic::selection2cimg(const char *const string, const unsigned int index_end,
@@ -3997,7 +4627,10 @@ gmic& gmic::_gmic(const char *const commands_line,
   cimg_exception_mode = cimg::exception_mode();
   cimg::exception_mode(0);
 
-  // Initialize class attributes.
+  // Initialize class attributes (only once, lock-free afterwards).
+#if cimg_use_cpp11==1
+  if (!is_builtin_commands_inds_ready.load(std::memory_order_acquire)) {
+#endif
   cimg::mutex(22);
   if (!builtin_commands_inds) { // First call
     builtin_commands_inds.assign(128,2,1,1,-1);
@@ -4009,7 +4642,13 @@ gmic& gmic::_gmic(const char *const commands_line,
     try { is_display_available = (bool)CImgDisplay::screen_width(); } catch (CImgDisplayException&) { }
     cimg::srand();
   }
+#if cimg_use_cpp11==1
+  is_builtin_commands_inds_ready.store(true,std::memory_order_release);
+#endif
   cimg::mutex(22,0);
+#if cimg_use_cpp11==1
+  }
+#endif
 
   // Initialize instance attributes.
   setlocale(LC_NUMERIC,"C");
@@ -4020,6 +4659,7 @@ gmic& gmic::_gmic(const char *const commands_line,
   commands_names = new CImgList<char>[gmic_comslots];
   delete[] commands_has_arguments;
   commands_has_arguments = new CImgList<char>[gmic_comslots];
+  release_commands_cache();
   delete[] _variables;
   _variables = new CImgList<char>[gmic_varslots];
   delete[] _variables_names;
@@ -4048,6 +4688,8 @@ gmic& gmic::_gmic(const char *const commands_line,
   network_timeout = 0;
   verbosity = 0;
   allow_main_ = is_debug = is_debug_info = is_running = false;
+  allow_fusion = true;
+  is_commands_changed = true;
   is_abort = p_is_abort?p_is_abort:&_is_abort;
   *is_abort = false;
   starting_commands_line = commands_line;
@@ -5435,6 +6077,30 @@ gmic& gmic::_run(const CImgList<char>& commands_line, unsigned int& position,
       // Begin command interpretation.
       if (is_command) {
 
+        // Fuse runs of pointwise commands on the same selection into a single pass.
+        if (allow_fusion && is_builtin_command && !is_get && !is_subst_item && !is_debug) {
+          CImg<double> ops;
+          unsigned int position_fused = position_item;
+          if (gmic_pointwise_commands(commands_line,position_fused,ops)>1) {
+            if (is_verbose) {
+              CImgList<char> g_list_c;
+              for (unsigned int p = position_item; p<position_fused; ++p) {
+                CImg<char>::string(commands_line[p]).move_to(g_list_c);
+                g_list_c.back().back() = ' ';
+              }
+              (g_list_c>'x').move_to(name);
+              name.back() = 0;
+              print(0,"Apply %u fused pointwise commands '%s' on image%s.",
+                    ops._height,cimg::strellipsize(name,gmic_use_argument_text,80,false),
+                    gmic_selection.data());
+            }
+            cimg_forY(selection,l) gmic_pointwise(gmic_check(images[selection[l]]),ops);
+            position = position_fused;
+            is_change = true;
+            continue;
+          }
+        }
+
         // Convert command shortcuts to full names.
         char command0 = *command;
         const char
@@ -12162,7 +12828,8 @@ gmic& gmic::_run(const CImgList<char>& commands_line, unsigned int& position,
         if (!is_get && !std::strcmp("uncommand",item)) {
           gmic_substitute_args(false);
           if (*argument=='*' && !argument[1]) { // Discard all custom commands
-            cimg::mutex(23);
+            gmic_lock_commands(this);
+            is_commands_changed = true;
             unsigned int nb_commands = 0;
             for (unsigned int i = 0; i<gmic_comslots; ++i) {
               nb_commands+=commands[i].size();
@@ -12172,9 +12839,10 @@ gmic& gmic::_run(const CImgList<char>& commands_line, unsigned int& position,
             }
             print(0,"Discard definitions of all custom commands (%u command%s).",
                   nb_commands,nb_commands>1?"s":"");
-            cimg::mutex(23,0);
+            gmic_unlock_commands(this);
           } else { // Discard one or several custom command
-            cimg::mutex(23);
+            gmic_lock_commands(this);
+            is_commands_changed = true;
             g_list_c = CImg<char>::string(argument).get_split(CImg<char>::vector(','),0,false);
             print(0,"Discard definition%s of custom command%s '%s'",
                   g_list_c.width()>1?"s":"",
@@ -12205,7 +12873,7 @@ gmic& gmic::_run(const CImgList<char>& commands_line, unsigned int& position,
               cimg::mutex(29,0);
             }
             g_list_c.assign();
-            cimg::mutex(23,0);
+            gmic_unlock_commands(this);
           }
           ++position;
           continue;
@@ -282,7 +282,8 @@ inline double gmic_mp_store(const double *const ptrs, const unsigned int siz,
 #include <cstdio>
 #include <cstring>
 #define gmic_new_attr commands(0), commands_names(0), commands_has_arguments(0), \
-    _variables(0), _variables_names(0), variables(0), variables_names(0), _variables_lengths(0), variables_lengths(0)
+    _variables(0), _variables_names(0), variables(0), variables_names(0), _variables_lengths(0), variables_lengths(0), \
+    commands_cache(0), commands_cache_size(0)
 
 using namespace gmic_library;
 
@@ -300,6 +301,11 @@ struct gmic {
   gmic(const gmic& gmic_instance);
   gmic& assign(const gmic& gmic_instance);
 
+  // Reset an already-constructed object to the state of a reference instance (for recycling interpreters).
+  // With 'is_keep_commands', command tables are kept unless they changed since the last reset from this reference.
+  gmic& reset(const gmic& gmic_instance, float *const p_progress=0, bool *const p_is_abort=0,
+              const bool is_keep_commands=false);
+
   template<typename T>
   gmic(const char *const commands_line, const char *const custom_commands=0, const bool include_stdlib=true,
        float *const p_progress=0, bool *const p_is_abort=0, const T& pixel_type=(T)0);
@@ -323,6 +329,9 @@ struct gmic {
   template<typename T>
   gmic& run(const char *const commands_line, gmic_list<T> &images, gmic_list<char> &images_names);
 
+  // Estimate the halo needed around an image region by a pipeline of local commands (-1 if unknown).
+  int get_halo(const char *const commands_line, const char *const roi_commands=0, bool *const is_roi_command=0);
+
   // Bridge for calling gmic with classes compatible with 'gmic_list'.
   template<typename ti, typename tn>
   gmic(const char *const commands_line,
@@ -402,6 +411,9 @@ struct gmic {
                      unsigned int *count_new=0, unsigned int *count_replaced=0, bool *const is_main_=0);
   gmic& add_commands(std::FILE *const file, const char *const filename=0, const bool add_debug_info=false,
                      unsigned int *count_new=0, unsigned int *count_replaced=0, bool *const is_main_=0);
+  bool save_commands_cache(const char *const filename, const char *const key) const;
+  bool load_commands_cache(const char *const filename, const char *const key);
+  void release_commands_cache();
 
   gmic_image<char> callstack2string(const bool _is_debug=false) const;
   gmic_image<char> callstack2string(const gmic_image<unsigned int>& callstack_selection,
@@ -418,6 +430,8 @@ struct gmic {
                                      const unsigned int display_selection, gmic_image<char>& res) const;
 
   gmic_list<char> commands_line_to_CImgList(const char *const commands_line);
+  int _get_halo(const char *const commands_line, const char *const roi_commands, bool& is_roi,
+                const unsigned int depth);
 
   void _gmic_substitute_args(const char *const argument, const char *const argument0, const char *const command,
                              const char *const item);
@@ -484,14 +498,16 @@ struct gmic {
   gmic_image<unsigned char> light3d;
   gmic_image<void*> display_windows;
   gmic_image<char> status;
+  void *commands_cache;
+  gmic_uint64 commands_cache_size;
 
   float light3d_x, light3d_y, light3d_z, _progress, *progress;
   gmic_uint64 reference_time;
   unsigned int nb_dowhiles, nb_fordones, nb_foreachdones, nb_repeatdones, nb_remaining_fr,
     nb_carriages_default, nb_carriages_stdout, debug_filename, debug_line, cimg_exception_mode;
   int verbosity, network_timeout;
-  bool allow_main_, is_change, is_debug, is_running, is_start, is_return, is_quit, is_debug_info,
-    _is_abort, *is_abort, is_abort_thread, is_lbrace_command;
+  bool allow_main_, allow_fusion, is_change, is_debug, is_running, is_start, is_return, is_quit, is_debug_info,
+    _is_abort, *is_abort, is_abort_thread, is_lbrace_command, is_commands_changed;
   const char *starting_commands_line;
 };
 
@@ -114,12 +114,11 @@ int main(int argc, char **argv) {
 
   // Declare main G'MIC instance.
   static bool is_abort;
-  gmic gmic_instance((char*)0,(char*)0,true,(float*)0,&is_abort,(gmic_pixel_type)0);
+  gmic gmic_instance((char*)0,(char*)0,false,(float*)0,&is_abort,(gmic_pixel_type)0);
   gmic_instance.is_debug = is_debug;
   gmic_instance.set_variable("_host",0,"cli");
-  gmic_instance.add_commands("cli_start:");
 
-  // Import update file (from resources directory).
+  // Read update file (from resources directory).
   CImg<char> filename_update, commands_update;
   bool is_invalid_updatefile = false;
   char sep = 0;
@@ -131,11 +130,28 @@ int main(int argc, char **argv) {
     try { commands_update.load_raw(filename_update); }
     catch (...) { }
   }
-  if (commands_update) try {
-      commands_update.unroll('y');
-      commands_update.resize(1,commands_update.height() + 1,1,1,0);
-      gmic_instance.add_commands(commands_update);
-    } catch (...) { is_invalid_updatefile = true; }
+  if (commands_update) {
+    commands_update.unroll('y');
+    commands_update.resize(1,commands_update.height() + 1,1,1,0);
+  }
+
+  // Import stdlib and update file, from precompiled command tables when up-to-date
+  // (the cache is keyed by the version and the content of the update file).
+  CImg<char> filename_cache(1024), cache_key(64);
+  cimg_snprintf(filename_cache,filename_cache.width(),"%scommands%u.cache",
+                gmic::path_rc(),gmic_version);
+  cimg_uint64 hash_update = 14695981039346656037ULL; // FNV-1a
+  cimg_for(commands_update,ptrs,char) { hash_update^=(unsigned char)*ptrs; hash_update*=1099511628211ULL; }
+  cimg_snprintf(cache_key,cache_key.width(),"%u_" cimg_fuint64 "_" cimg_fuint64,
+                gmic_version,(cimg_uint64)commands_update.size(),hash_update);
+  if (!gmic_instance.load_commands_cache(filename_cache,cache_key)) {
+    gmic_instance.add_commands(gmic::decompress_stdlib().data());
+    gmic_instance.add_commands("cli_start:");
+    if (commands_update) try {
+        gmic_instance.add_commands(commands_update);
+      } catch (...) { is_invalid_updatefile = true; }
+    if (!is_invalid_updatefile) gmic_instance.save_commands_cache(filename_cache,cache_key);
+  }
   is_invalid_updatefile|=commands_update && (cimg_sscanf(commands_update," #@gmi%c",&sep)!=1 || sep!='c');
   commands_update.assign();
 
@@ -232,7 +248,7 @@ int main(int argc, char **argv) {
     CImgList<gmic_pixel_type> images;
     CImgList<char> images_names;
     if (is_help && !cimg::is_file(filename_update.data())) {
-      images.insert(gmic::stdlib); CImg<char>::string("stdlib").move_to(images_names);
+      images.insert(gmic::decompress_stdlib()); CImg<char>::string("stdlib").move_to(images_names);
     }
     gmic_instance.run(commands_line.data(),images,images_names);
   } catch (gmic_exception &e) {
@@ -260,7 +276,7 @@ int main(int argc, char **argv) {
         std::fflush(cimg::output());
         CImgList<gmic_pixel_type> images;
         CImgList<char> images_names;
-        images.insert(gmic::stdlib);
+        images.insert(gmic::decompress_stdlib());
         CImg<char>::string("stdlib").move_to(images_names);
         CImg<char> tmp_line(1024);
         cimg_snprintf(tmp_line,tmp_line.width(),
@@ -275,7 +291,7 @@ int main(int argc, char **argv) {
           gmic(tmp_line,images,images_names);
         } catch (...) { // Fallback in case overloaded version of 'help' crashed
           cimg_snprintf(tmp_line,tmp_line.width(),"help \"%s\"",e.command());
-          images.assign().insert(gmic::stdlib);
+          images.assign().insert(gmic::decompress_stdlib());
           images_names.assign();
           gmic(tmp_line,images,images_names);
         }
@@ -320,6 +320,7 @@ HEADERS +=  \
   src/CroppedImageListProxy.h \
   src/CroppedActiveLayerProxy.h \
   src/FilterGuiDynamismCache.h \
+  src/FilterHaloCache.h \
   src/FilterSyncRunner.h \
   src/FilterThread.h \
   src/FilterTextTranslator.h \
@@ -331,6 +332,7 @@ HEADERS +=  \
   src/IconLoader.h \
   src/ImageTools.h \
   src/InputOutputState.h \
+  src/InterpreterPool.h \
   src/KeypointList.h \
   src/LayersExtentProxy.h \
   src/Logger.h \
@@ -401,6 +403,7 @@ SOURCES += \
   src/CroppedImageListProxy.cpp \
   src/CroppedActiveLayerProxy.cpp \
   src/FilterGuiDynamismCache.cpp \
+  src/FilterHaloCache.cpp \
   src/FilterSyncRunner.cpp \
   src/FilterThread.cpp \
   src/FilterTextTranslator.cpp \
@@ -412,6 +415,7 @@ SOURCES += \
   src/IconLoader.cpp \
   src/ImageTools.cpp \
   src/InputOutputState.cpp \
+  src/InterpreterPool.cpp \
   src/KeypointList.cpp \
   src/LayersExtentProxy.cpp \
   src/LanguageSettings.cpp \
@@ -27,6 +27,8 @@
 #include <QDebug>
 #include "Common.h"
 #include "Host/GmicQtHost.h"
+#include "ImageTools.h"
+#include "Settings.h"
 #include "gmic.h"
 
 namespace GmicQt
@@ -36,14 +38,21 @@ double CroppedActiveLayerProxy::_x = -1.0;
 double CroppedActiveLayerProxy::_y = -1.0;
 double CroppedActiveLayerProxy::_width = -1.0;
 double CroppedActiveLayerProxy::_height = -1.0;
-std::unique_ptr<gmic_library::gmic_image<gmic_pixel_type>> CroppedActiveLayerProxy::_cachedImage(new gmic_library::gmic_image<gmic_pixel_type>);
+quint64 CroppedActiveLayerProxy::_serial = 0;
+std::shared_ptr<gmic_library::gmic_image<gmic_pixel_type>> CroppedActiveLayerProxy::_cachedImage(new gmic_library::gmic_image<gmic_pixel_type>);
+std::unique_ptr<gmic_library::gmic_image<unsigned short>> CroppedActiveLayerProxy::_compactImage(new gmic_library::gmic_image<unsigned short>);
 
-void CroppedActiveLayerProxy::get(gmic_library::gmic_image<gmic_pixel_type> & image, double x, double y, double width, double height)
+std::shared_ptr<const gmic_library::gmic_image<gmic_pixel_type>> CroppedActiveLayerProxy::get(double x, double y, double width, double height)
 {
   if ((x != _x) || (y != _y) || (width != _width) || (height != _height)) {
     update(x, y, width, height);
   }
-  image = *_cachedImage;
+  if (!_compactImage->is_empty()) {
+    std::shared_ptr<gmic_library::gmic_image<gmic_pixel_type>> image(new gmic_library::gmic_image<gmic_pixel_type>);
+    expandImage(*_compactImage, *image);
+    return image;
+  }
+  return _cachedImage;
 }
 
 QSize CroppedActiveLayerProxy::getSize(double x, double y, double width, double height)
@@ -51,13 +60,23 @@ QSize CroppedActiveLayerProxy::getSize(double x, double y, double width, double
   if ((x != _x) || (y != _y) || (width != _width) || (height != _height)) {
     update(x, y, width, height);
   }
+  if (!_compactImage->is_empty()) {
+    return QSize(_compactImage->width(), _compactImage->height());
+  }
   return QSize(_cachedImage->width(), _cachedImage->height());
 }
 
 void CroppedActiveLayerProxy::clear()
 {
-  _cachedImage->assign();
+  _cachedImage.reset(new gmic_library::gmic_image<gmic_pixel_type>);
+  _compactImage->assign();
   _x = _y = _width = _height = -1.0;
+  ++_serial;
+}
+
+quint64 CroppedActiveLayerProxy::serial()
+{
+  return _serial;
 }
 
 void CroppedActiveLayerProxy::update(double x, double y, double width, double height)
@@ -66,13 +85,22 @@ void CroppedActiveLayerProxy::update(double x, double y, double width, double he
   _y = y;
   _width = width;
   _height = height;
+  ++_serial;
 
   gmic_library::gmic_list<gmic_pixel_type> images;
   gmic_library::gmic_list<char> imageNames;
   GmicQtHost::getCroppedImages(images, imageNames, _x, _y, _width, _height, InputMode::Active);
   if (images.size() > 0) {
     GmicQtHost::applyColorProfile(images.front());
-    _cachedImage->swap(images.front());
+    if (Settings::compactImageStorage()) {
+      compactImage(images.front(), *_compactImage);
+      _cachedImage.reset(new gmic_library::gmic_image<gmic_pixel_type>);
+    } else {
+      // The previous image may still be in use by a caller of get()
+      _cachedImage.reset(new gmic_library::gmic_image<gmic_pixel_type>);
+      _cachedImage->swap(images.front());
+      _compactImage->assign();
+    }
   } else {
     clear();
   }
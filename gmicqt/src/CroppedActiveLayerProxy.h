@@ -41,17 +41,30 @@ class CroppedActiveLayerProxy {
 public:
   CroppedActiveLayerProxy() = delete;
 
-  static void get(gmic_library::gmic_image<gmic_pixel_type> & image, double x, double y, double width, double height);
+  /**
+   * @brief Get the cropped active layer without copying it.
+   *
+   * The returned image is shared with the cache and must not be modified.
+   * Cache updates never modify an image that has been handed out.
+   */
+  static std::shared_ptr<const gmic_library::gmic_image<gmic_pixel_type>> get(double x, double y, double width, double height);
   static QSize getSize(double x, double y, double width, double height);
   static void clear();
+  /**
+   * @brief Incremented each time the cached crop is updated or cleared,
+   *        so that images derived from it can tell when they are outdated.
+   */
+  static quint64 serial();
 
 private:
   static void update(double x, double y, double width, double height);
-  static std::unique_ptr<gmic_library::gmic_image<float>> _cachedImage;
+  static std::shared_ptr<gmic_library::gmic_image<float>> _cachedImage;
+  static std::unique_ptr<gmic_library::gmic_image<unsigned short>> _compactImage; // Used instead if Settings::compactImageStorage()
   static double _x;
   static double _y;
   static double _width;
   static double _height;
+  static quint64 _serial;
 };
 
 } // namespace GmicQt
@@ -25,57 +25,244 @@
 
 #include "CroppedImageListProxy.h"
 #include <QDebug>
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <thread>
+#include <vector>
 #include "Common.h"
+#include "Globals.h"
 #include "Host/GmicQtHost.h"
+#include "ImageTools.h"
+#include "LayersExtentProxy.h"
+#include "Settings.h"
 #include "gmic.h"
 
 namespace GmicQt
 {
 
+// Level l (1/2^l of the full size) of layer i is stored at index (l - 1) * (number of layers) + i,
+// in compact storage (previews only, never used for exact images).
+struct CroppedImageListProxy::Pyramid {
+  InputMode inputMode = InputMode::Unspecified;
+  QSize extent;
+  std::vector<QSize> baseSizes; // Full size of each layer
+  gmic_library::gmic_list<char> names;
+  gmic_library::gmic_list<unsigned short> levels; // Written by the build thread until ready is set
+  std::atomic<bool> ready{false};
+  std::atomic<bool> cancel{false}; // Checked by the build thread between images
+};
+
+namespace
+{
+
+void toFloat(gmic_library::gmic_image<float> & in, gmic_library::gmic_image<float> & out)
+{
+  in.move_to(out);
+}
+
+void toFloat(gmic_library::gmic_image<unsigned short> & in, gmic_library::gmic_image<float> & out)
+{
+  expandImage(in, out);
+}
+
+// Crop of a layer of full size [size], as computed by hosts, taken from a downscaled level of it
+template <typename T>
+void cropLevel(const gmic_library::gmic_image<T> & level, const QSize & size, double x, double y, double width, double height, double zoom, gmic_library::gmic_image<float> & out)
+{
+  const int ix = static_cast<int>(std::floor(x * size.width()));
+  const int iy = static_cast<int>(std::floor(y * size.height()));
+  const int iw = std::min(size.width() - ix, static_cast<int>(1 + std::ceil(width * size.width())));
+  const int ih = std::min(size.height() - iy, static_cast<int>(1 + std::ceil(height * size.height())));
+  if (level.is_empty() || (iw <= 0) || (ih <= 0)) {
+    out.assign();
+    return;
+  }
+  const double sx = level.width() / static_cast<double>(size.width());
+  const double sy = level.height() / static_cast<double>(size.height());
+  const int x0 = static_cast<int>(std::floor(ix * sx));
+  const int y0 = static_cast<int>(std::floor(iy * sy));
+  const int x1 = std::max(x0, std::min(level.width(), static_cast<int>(std::ceil((ix + iw) * sx))) - 1);
+  const int y1 = std::max(y0, std::min(level.height(), static_cast<int>(std::ceil((iy + ih) * sy))) - 1);
+  gmic_library::gmic_image<T> crop = level.get_crop(x0, y0, x1, y1);
+  toFloat(crop, out);
+  out.resize(std::round(iw * zoom), std::round(ih * zoom), 1, -100, 2);
+}
+
+} // namespace
+
 double CroppedImageListProxy::_x = -1.0;
 double CroppedImageListProxy::_y = -1.0;
 double CroppedImageListProxy::_width = -1.0;
 double CroppedImageListProxy::_height = -1.0;
 double CroppedImageListProxy::_zoom = 0.0;
+bool CroppedImageListProxy::_exact = false;
 InputMode CroppedImageListProxy::_inputMode = InputMode::Unspecified;
-std::unique_ptr<gmic_library::gmic_list<gmic_pixel_type>> CroppedImageListProxy::_cachedImageList(new gmic_library::gmic_list<gmic_pixel_type>);
+std::shared_ptr<gmic_library::gmic_list<gmic_pixel_type>> CroppedImageListProxy::_cachedImageList(new gmic_library::gmic_list<gmic_pixel_type>);
+std::unique_ptr<gmic_library::gmic_list<unsigned short>> CroppedImageListProxy::_compactImageList(new gmic_library::gmic_list<unsigned short>);
 std::unique_ptr<gmic_library::gmic_list<char>> CroppedImageListProxy::_cachedImageNames(new gmic_library::gmic_list<char>);
+std::shared_ptr<CroppedImageListProxy::Pyramid> CroppedImageListProxy::_pyramid;
+std::thread CroppedImageListProxy::_pyramidThread;
 
-void CroppedImageListProxy::get(gmic_library::gmic_list<gmic_pixel_type> & images, gmic_library::gmic_list<char> & imageNames,
-                                double x, double y, double width, double height, InputMode mode, double zoom)
+std::shared_ptr<const gmic_library::gmic_list<gmic_pixel_type>> CroppedImageListProxy::get(gmic_library::gmic_list<char> & imageNames, //
+                                                                                           double x, double y, double width, double height, InputMode mode, double zoom, bool exact)
 {
-  if ((x != _x) || (y != _y) || (width != _width) || (height != _height) || (mode != _inputMode) || (zoom != _zoom)) {
-    update(x, y, width, height, mode, zoom);
+  // Exact images can be served for any request, compact ones only when quantization is acceptable
+  if ((x != _x) || (y != _y) || (width != _width) || (height != _height) || (mode != _inputMode) || (zoom != _zoom) || (exact && !_exact)) {
+    update(x, y, width, height, mode, zoom, exact);
   }
-  images = *_cachedImageList;
   imageNames = *_cachedImageNames;
+  if (_compactImageList->size()) {
+    // Expanded images are not kept, so the caller gets the only reference
+    std::shared_ptr<gmic_library::gmic_list<gmic_pixel_type>> images(new gmic_library::gmic_list<gmic_pixel_type>(_compactImageList->size()));
+    for (unsigned int i = 0; i < _compactImageList->size(); ++i) {
+      expandImage((*_compactImageList)[i], (*images)[i]);
+    }
+    return images;
+  }
+  return _cachedImageList;
 }
 
-void CroppedImageListProxy::update(double x, double y, double width, double height, InputMode mode, double zoom)
+void CroppedImageListProxy::update(double x, double y, double width, double height, InputMode mode, double zoom, bool exact)
 {
+  _exact = exact;
   _x = x;
   _y = y;
   _width = width;
   _height = height;
   _inputMode = mode;
   _zoom = zoom;
-  GmicQtHost::getCroppedImages(*_cachedImageList, *_cachedImageNames, _x, _y, _width, _height, _inputMode);
-  if (zoom < 1.0) {
+  // Lists handed out by get() may still be in use, so a new one is always created
+  _cachedImageList.reset(new gmic_library::gmic_list<gmic_pixel_type>);
+  bool cropped = false;
+  if (zoom < 0.5) {
+    // A pyramid is only valid for the input mode and image extent it was built for
+    if (!_pyramid || (_pyramid->inputMode != mode) || (_pyramid->extent != LayersExtentProxy::getExtent(mode))) {
+      cropped = buildPyramid(*_cachedImageList, *_cachedImageNames, _x, _y, _width, _height, mode, zoom);
+    } else {
+      cropped = cropFromPyramid(*_cachedImageList, *_cachedImageNames, _x, _y, _width, _height, zoom);
+    }
+  }
+  if (!cropped) {
+    GmicQtHost::getCroppedImages(*_cachedImageList, *_cachedImageNames, _x, _y, _width, _height, _inputMode);
+    if (zoom < 1.0) {
+      for (unsigned int i = 0; i < _cachedImageList->size(); ++i) {
+        gmic_image<float> & image = (*_cachedImageList)[i];
+        image.resize(std::round(image.width() * zoom), std::round(image.height() * zoom), 1, -100, 2);
+      }
+    }
+  }
+  _compactImageList->assign();
+  if (Settings::compactImageStorage() && !exact) {
+    _compactImageList->assign(_cachedImageList->size());
     for (unsigned int i = 0; i < _cachedImageList->size(); ++i) {
-      gmic_image<float> & image = (*_cachedImageList)[i];
-      image.resize(std::round(image.width() * zoom), std::round(image.height() * zoom), 1, -100, 1);
+      compactImage((*_cachedImageList)[i], (*_compactImageList)[i]);
     }
+    _cachedImageList.reset(new gmic_library::gmic_list<gmic_pixel_type>);
   }
 }
 
 void CroppedImageListProxy::clear()
 {
-  _cachedImageList->assign();
+  _cachedImageList.reset(new gmic_library::gmic_list<gmic_pixel_type>);
+  _compactImageList->assign();
   _cachedImageNames->assign();
   _x = _y = _width = _height = -1.0;
   _inputMode = InputMode::Unspecified;
   _zoom = 0.0;
+  _exact = false;
+  stopPyramidBuild();
+  _pyramid.reset();
+}
+
+void CroppedImageListProxy::stopPyramidBuild()
+{
+  if (_pyramid) {
+    _pyramid->cancel.store(true, std::memory_order_relaxed);
+  }
+  if (_pyramidThread.joinable()) {
+    _pyramidThread.join();
+  }
+}
+
+bool CroppedImageListProxy::buildPyramid(gmic_library::gmic_list<gmic_pixel_type> & images, gmic_library::gmic_list<char> & imageNames, //
+                                         double x, double y, double width, double height, InputMode mode, double zoom)
+{
+  stopPyramidBuild();
+  std::shared_ptr<Pyramid> pyramid(new Pyramid);
+  pyramid->inputMode = mode;
+  pyramid->extent = LayersExtentProxy::getExtent(mode);
+  _pyramid = pyramid;
+
+  // Levels hold about a third of the full size pixels, at 2 bytes per value (assuming 4 channels).
+  // Above the budget, the pyramid is left empty and previews are cropped by the host.
+  const qint64 bytes = static_cast<qint64>(pyramid->extent.width()) * pyramid->extent.height() * 4 * sizeof(unsigned short) / 3;
+  if (bytes > INPUT_PYRAMID_MAX_BYTES) {
+    return false;
+  }
+
+  // Hosts are only called from the GUI thread. The full images also serve the current request.
+  std::shared_ptr<gmic_library::gmic_list<gmic_pixel_type>> full(new gmic_library::gmic_list<gmic_pixel_type>);
+  GmicQtHost::getCroppedImages(*full, pyramid->names, 0.0, 0.0, 1.0, 1.0, mode);
+  images.assign(full->size());
+  imageNames = pyramid->names;
+  for (unsigned int i = 0; i < full->size(); ++i) {
+    const QSize size((*full)[i].width(), (*full)[i].height());
+    pyramid->baseSizes.push_back(size);
+    cropLevel((*full)[i], size, x, y, width, height, zoom, images[i]);
+  }
+
+  _pyramidThread = std::thread([pyramid, full]() {
+    gmic_library::gmic_list<gmic_pixel_type> & level = *full;
+    for (;;) {
+      int largest = 0;
+      for (unsigned int i = 0; i < level.size(); ++i) {
+        largest = std::max(largest, std::max(level[i].width(), level[i].height()));
+      }
+      if (largest <= INPUT_PYRAMID_MIN_SIZE) {
+        break;
+      }
+      // Halving with area averaging (moving average interpolation)
+      for (unsigned int i = 0; i < level.size(); ++i) {
+        if (pyramid->cancel.load(std::memory_order_relaxed)) {
+          return; // Never ready, the pyramid is dropped
+        }
+        gmic_library::gmic_image<unsigned short> compact;
+        if (!level[i].is_empty()) {
+          level[i].resize((level[i].width() + 1) / 2, (level[i].height() + 1) / 2, 1, -100, 2);
+          compactImage(level[i], compact);
+        }
+        compact.move_to(pyramid->levels);
+      }
+    }
+    pyramid->ready.store(true, std::memory_order_release);
+  });
+  return true;
+}
+
+bool CroppedImageListProxy::cropFromPyramid(gmic_library::gmic_list<gmic_pixel_type> & images, gmic_library::gmic_list<char> & imageNames, //
+                                            double x, double y, double width, double height, double zoom)
+{
+  // Until the build thread is done, previews are cropped by the host
+  if (!_pyramid->ready.load(std::memory_order_acquire)) {
+    return false;
+  }
+  const unsigned int layers = static_cast<unsigned int>(_pyramid->baseSizes.size());
+  if (!layers || (_pyramid->levels.size() < layers)) {
+    return false;
+  }
+  // Smallest level that is still larger than the requested zoom
+  const unsigned int levels = _pyramid->levels.size() / layers;
+  unsigned int l = 1;
+  while ((l < levels) && (std::ldexp(1.0, -static_cast<int>(l + 1)) >= zoom)) {
+    ++l;
+  }
+  images.assign(layers);
+  imageNames = _pyramid->names;
+  for (unsigned int i = 0; i < layers; ++i) {
+    cropLevel(_pyramid->levels[(l - 1) * layers + i], _pyramid->baseSizes[i], x, y, width, height, zoom, images[i]);
+  }
+  return true;
 }
 
 } // namespace GmicQt
@@ -25,7 +25,9 @@
 #ifndef GMIC_QT_CROPPEDIMAGELISTPROXY_H
 #define GMIC_QT_CROPPEDIMAGELISTPROXY_H
 
+#include <QSize>
 #include <memory>
+#include <thread>
 #include "GmicQt.h"
 
 namespace gmic_library
@@ -41,12 +43,26 @@ class CroppedImageListProxy {
 public:
   CroppedImageListProxy() = delete;
 
-  static void get(gmic_library::gmic_list<gmic_pixel_type> & images, gmic_library::gmic_list<char> & imageNames, double x, double y, double width, double height, InputMode mode, double zoom);
-  static void update(double x, double y, double width, double height, InputMode mode, double zoom);
+  /**
+   * @brief Get the cropped images without copying them.
+   *
+   * The returned list is shared with the cache and must not be modified: a copy
+   * has to be made before writing to it, unless the caller holds the last reference.
+   * Cache updates never modify a list that has been handed out.
+   * With exact set, the images are never kept in compact storage (which quantizes them),
+   * as needed for the final processing of the images.
+   */
+  static std::shared_ptr<const gmic_library::gmic_list<gmic_pixel_type>> get(gmic_library::gmic_list<char> & imageNames, double x, double y, double width, double height, InputMode mode, double zoom, bool exact = false);
+  static void update(double x, double y, double width, double height, InputMode mode, double zoom, bool exact = false);
   static void clear();
 
 private:
-  static std::unique_ptr<gmic_library::gmic_list<float>> _cachedImageList;
+  struct Pyramid;
+  static bool buildPyramid(gmic_library::gmic_list<gmic_pixel_type> & images, gmic_library::gmic_list<char> & imageNames, double x, double y, double width, double height, InputMode mode, double zoom);
+  static void stopPyramidBuild();
+  static bool cropFromPyramid(gmic_library::gmic_list<gmic_pixel_type> & images, gmic_library::gmic_list<char> & imageNames, double x, double y, double width, double height, double zoom);
+  static std::shared_ptr<gmic_library::gmic_list<float>> _cachedImageList;
+  static std::unique_ptr<gmic_library::gmic_list<unsigned short>> _compactImageList; // Used instead if Settings::compactImageStorage()
   static std::unique_ptr<gmic_library::gmic_list<char>> _cachedImageNames;
   static double _x;
   static double _y;
@@ -54,6 +70,11 @@ private:
   static double _height;
   static InputMode _inputMode;
   static double _zoom;
+  static bool _exact;
+
+  // Downscaled copies of the whole input, for zoomed out previews (built by a background thread)
+  static std::shared_ptr<Pyramid> _pyramid;
+  static std::thread _pyramidThread; // Joined by clear(), before the window is gone
 };
 
 } // namespace GmicQt
@@ -0,0 +1,81 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FilterHaloCache.cpp
+ *
+ *  Copyright 2026 The digiKam developers
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "FilterHaloCache.h"
+#include <QMutexLocker>
+#include "Globals.h"
+#include "GmicStdlib.h"
+#include "InterpreterPool.h"
+#include "Misc.h"
+
+namespace
+{
+// Commands cropping the preview area by themselves (using the '_preview_[xy][01]' variables)
+const char * const PreviewCropCommands = "gui_crop_preview,gui_crop_resize_preview";
+} // namespace
+
+namespace GmicQt
+{
+
+QMutex FilterHaloCache::_mutex;
+QByteArray FilterHaloCache::_stdlib;
+QHash<QString, FilterHaloCache::Entry> FilterHaloCache::_cache;
+
+int FilterHaloCache::halo(const QString & command, const QString & arguments, bool & cropsPreview)
+{
+  QString fullCommand = command;
+  appendWithSpace(fullCommand, arguments);
+  {
+    const QByteArray stdlib = GmicStdLib::current();
+    QMutexLocker locker(&_mutex);
+    // Holding a (shallow) copy of the array guarantees that an unchanged data pointer means unchanged contents
+    if ((_stdlib.constData() != stdlib.constData()) || (_stdlib.size() != stdlib.size())) {
+      _stdlib = stdlib;
+      _cache.clear();
+    }
+    QHash<QString, Entry>::const_iterator it = _cache.constFind(fullCommand);
+    if (it != _cache.constEnd()) {
+      cropsPreview = it.value().cropsPreview;
+      return it.value().halo;
+    }
+  }
+  Entry entry{-1, false};
+  entry.halo = InterpreterPool::halo(fullCommand.toLocal8Bit().constData(), PreviewCropCommands, &entry.cropsPreview);
+  QMutexLocker locker(&_mutex);
+  if (_cache.size() >= FILTER_HALO_CACHE_MAX_SIZE) {
+    _cache.clear();
+  }
+  _cache.insert(fullCommand, entry);
+  cropsPreview = entry.cropsPreview;
+  return entry.halo;
+}
+
+void FilterHaloCache::clear()
+{
+  QMutexLocker locker(&_mutex);
+  _cache.clear();
+  _stdlib.clear();
+}
+
+} // namespace GmicQt
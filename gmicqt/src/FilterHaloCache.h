@@ -0,0 +1,67 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file FilterHaloCache.h
+ *
+ *  Copyright 2026 The digiKam developers
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GMIC_QT_FILTERHALOCACHE_H
+#define GMIC_QT_FILTERHALOCACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+namespace GmicQt
+{
+
+/**
+ * @brief Halo (in pixels) that a filter command needs around the previewed area.
+ *
+ * The halo is inferred by the G'MIC interpreter from the local built-in commands
+ * the filter expands to (see gmic::get_halo()), and cached per command line.
+ * A negative halo means that the filter has to see the whole image.
+ *
+ * The inference is approximate, so it is only used for previews:
+ * - Gaussian-like filters get a 4*sigma halo, so pixels near the border of the
+ *   region may differ slightly from a run on the whole image.
+ * - Arguments of custom commands are split at every ',', even inside quotes,
+ *   brackets or math expressions, so such arguments may be substituted wrongly.
+ */
+class FilterHaloCache {
+public:
+  FilterHaloCache() = delete;
+  static int halo(const QString & command, const QString & arguments, bool & cropsPreview);
+  static void clear();
+
+private:
+  struct Entry {
+    int halo;
+    bool cropsPreview;
+  };
+  static QMutex _mutex;
+  static QByteArray _stdlib;
+  static QHash<QString, Entry> _cache;
+};
+
+} // namespace GmicQt
+
+#endif // GMIC_QT_FILTERHALOCACHE_H
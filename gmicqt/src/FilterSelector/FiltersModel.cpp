@@ -116,6 +116,7 @@ FiltersModel::Filter::Filter()
   _previewFactor = PreviewFactorAny;
   _isAccurateIfZoomed = false;
   _previewFromFullImage = false;
+  _tileHalo = TileHaloNone;
   _isWarning = false;
 }
 
@@ -163,6 +164,12 @@ FiltersModel::Filter & FiltersModel::Filter::setPreviewFromFullImage(bool on)
   return *this;
 }
 
+FiltersModel::Filter & FiltersModel::Filter::setTileHalo(int halo)
+{
+  _tileHalo = halo;
+  return *this;
+}
+
 FiltersModel::Filter & FiltersModel::Filter::setPath(const QList<QString> & path)
 {
   _path = path;
@@ -272,6 +279,11 @@ bool FiltersModel::Filter::previewFromFullImage() const
   return _previewFromFullImage;
 }
 
+int FiltersModel::Filter::tileHalo() const
+{
+  return _tileHalo;
+}
+
 bool FiltersModel::Filter::isWarning() const
 {
   return _isWarning;
@@ -54,6 +54,7 @@ public:
     Filter & setPreviewFactor(float factor);
     Filter & setAccurateIfZoomed(bool accurate);
     Filter & setPreviewFromFullImage(bool on);
+    Filter & setTileHalo(int halo);
     Filter & setPath(const QList<QString> & path);
     Filter & setWarningFlag(bool flag);
     Filter & setDefaultInputMode(InputMode);
@@ -72,6 +73,7 @@ public:
     float previewFactor() const;
     bool isAccurateIfZoomed() const;
     bool previewFromFullImage() const;
+    int tileHalo() const;
     bool isWarning() const;
     InputMode defaultInputMode() const;
 
@@ -92,6 +94,7 @@ public:
     float _previewFactor;
     bool _isAccurateIfZoomed;
     bool _previewFromFullImage;
+    qint32 _tileHalo;
     QString _hash;
     bool _isWarning;
   };
@@ -72,6 +72,7 @@ bool FiltersModelBinaryReader::read(const QString & filename)
     stream >> filter._previewFactor;
     stream >> filter._isAccurateIfZoomed;
     stream >> filter._previewFromFullImage;
+    stream >> filter._tileHalo;
     READ_STRING(filter._hash);
     stream >> filter._isWarning;
     _model._hash2filter[filter._hash] = filter;
@@ -101,7 +102,7 @@ bool FiltersModelBinaryReader::readHeader(QDataStream & stream, QByteArray & has
   }
   quint32 version;
   stream >> version;
-  if (version <= (quint32)100) {
+  if (version == (quint32)102) {
     stream.setVersion(QDataStream::Qt_5_0);
   } else {
     Logger::warning("Filters binary cache: unsupported version");
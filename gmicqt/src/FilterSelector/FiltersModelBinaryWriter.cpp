@@ -47,7 +47,7 @@ bool FiltersModelBinaryWriter::write(const QString & filename, const QByteArray
   QDataStream stream(&file);
 
   stream << (quint32)0x03300330;
-  stream << (quint32)100;
+  stream << (quint32)102;
   stream.setVersion(QDataStream::Qt_5_0);
 
   stream << hash;
@@ -69,6 +69,7 @@ bool FiltersModelBinaryWriter::write(const QString & filename, const QByteArray
     stream << it.value()._previewFactor;
     stream << it.value()._isAccurateIfZoomed;
     stream << it.value()._previewFromFullImage;
+    stream << it.value()._tileHalo;
     stream << it.value()._hash.toUtf8();
     stream << it.value()._isWarning;
     ++it;
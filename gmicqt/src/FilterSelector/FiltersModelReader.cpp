@@ -25,14 +25,21 @@
 #include "FilterSelector/FiltersModelReader.h"
 #include <QBuffer>
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QList>
 #include <QLocale>
+#include <QPair>
 #include <QRegularExpression>
 #include <QSettings>
 #include <QString>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstring>
+#include <thread>
+#include <vector>
 #include "Common.h"
 #include "FilterSelector/FiltersModel.h"
 #include "Globals.h"
@@ -421,6 +428,10 @@ bool isPrefixAndColon(const QString & text, const QString & prefix)
   return traverseOneChar(pc, limit, CHAR_COLON);
 }
 
+// Sections of the stdlib smaller than this are not worth a thread of their own.
+const qint64 SectionMinimumSize = 64 * 1024;
+const int SectionsPerThread = 4;
+
 } // namespace
 
 namespace GmicQt
@@ -428,12 +439,41 @@ namespace GmicQt
 
 FiltersModelReader::FiltersModelReader(FiltersModel & model) : _model(model) {}
 
-void FiltersModelReader::parseFiltersDefinitions(const QByteArray & stdlibArray)
+/*
+ * A part of the stdlib parsed independently of the others. The folders of its filters
+ * are relative to the path at the start of the section: 'pops' counts the folders
+ * closed above that path ("_" prefixed folder names), and 'path' the ones opened since.
+ */
+struct FiltersModelReader::Section {
+  struct Definition {
+    int pops;
+    QList<QString> path;
+    QString name;
+    QString command;
+    QString previewCommand;
+    InputMode defaultInputMode;
+    float previewFactor;
+    bool accurateIfZoomed;
+    bool previewFromFullImage;
+    int tileHalo;
+    QString parameters;
+    bool warning;
+  };
+  const char * begin = nullptr;
+  const char * end = nullptr;
+  QVector<Definition> definitions;
+  QVector<QString> hiddenPaths;
+  QList<QPair<QString, QString>> messages; // Hint and text, logged by the calling thread
+  int pops = 0;
+  QList<QString> path;
+};
+
+void FiltersModelReader::parseFiltersDefinitions(const QByteArray & stdlibArray, qint64 sectionSize)
 {
   TIMING;
-  const char * stdlib = stdlibArray.constData();
-  const char * stdLibLimit = stdlib + stdlibArray.size();
-  QList<QString> filterPath;
+  QElapsedTimer timer;
+  timer.start();
+  const char * stdLibLimit = stdlibArray.constData() + stdlibArray.size();
 
   QString language = LanguageSettings::configuredTranslator();
   if (language.isEmpty()) {
@@ -446,9 +486,156 @@ void FiltersModelReader::parseFiltersDefinitions(const QByteArray & stdlibArray)
     language = "en";
   }
 
-  QString buffer = readBufferLine(stdlib, stdLibLimit);
-  QString line;
+  const QVector<const char *> starts = sectionStarts(stdlibArray, language, sectionSize);
+  QVector<Section> sections(starts.size());
+  for (int i = 0; i < starts.size(); ++i) {
+    sections[i].begin = starts[i];
+    sections[i].end = (i + 1 < starts.size()) ? starts[i + 1] : stdLibLimit;
+  }
+  const qint64 splitTime = timer.elapsed();
+
+  std::atomic<int> nextSection(0);
+  const int sectionCount = static_cast<int>(sections.size());
+  auto worker = [&]() {
+    int index;
+    while ((index = nextSection++) < sectionCount) {
+      parseSection(sections[index], stdLibLimit, language);
+    }
+  };
+  const int threadCount = std::max(1, std::min(QThread::idealThreadCount(), sectionCount));
+  std::vector<std::thread> threads;
+  for (int t = 1; t < threadCount; ++t) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (std::thread & thread : threads) {
+    thread.join();
+  }
+  const qint64 parseTime = timer.elapsed();
+
+  // Merge the sections in stdlib order, which gives the same model as a sequential parsing.
+  // Filters are built here as the HTML translation of names is not thread-safe.
+  QList<QString> filterPath;
   QVector<QString> hiddenPaths;
+  FiltersModel::Filter pathFilter; // Folder names are only translated when the path changes
+  pathFilter.setPath(QList<QString>());
+  for (const Section & section : sections) {
+    for (const QPair<QString, QString> & message : section.messages) {
+      Logger::log(message.second, message.first);
+    }
+    for (const Section::Definition & definition : section.definitions) {
+      const QList<QString> path = filterPath.mid(0, std::max(0, int(filterPath.size()) - definition.pops)) + definition.path;
+      if (path != pathFilter.path()) {
+        pathFilter.setPath(path);
+      }
+      FiltersModel::Filter filter(pathFilter);
+      filter.setName(definition.name);
+      filter.setCommand(definition.command);
+      filter.setPreviewCommand(definition.previewCommand);
+      filter.setDefaultInputMode(definition.defaultInputMode);
+      filter.setPreviewFactor(definition.previewFactor);
+      filter.setAccurateIfZoomed(definition.accurateIfZoomed);
+      filter.setPreviewFromFullImage(definition.previewFromFullImage);
+      filter.setTileHalo(definition.tileHalo);
+      filter.setParameters(definition.parameters);
+      filter.setWarningFlag(definition.warning);
+      filter.build();
+      _model.addFilter(filter);
+    }
+    hiddenPaths += section.hiddenPaths;
+    filterPath = filterPath.mid(0, std::max(0, int(filterPath.size()) - section.pops)) + section.path;
+  }
+
+  // Remove hidden filters from the model
+  for (const QString & path : hiddenPaths) {
+    const size_t count = _model.filterCount();
+    QList<QString> pathList = path.split("/", QT_SKIP_EMPTY_PARTS);
+    _model.removePath(pathList);
+    if (_model.filterCount() == count) {
+      Logger::warning(QString("While hiding filter, name or path not found: \"%1\"").arg(path));
+    }
+  }
+
+  Logger::note(QString("Parsed %1 filters in %2 ms: %3 sections on %4 threads (split %5 ms, parse %6 ms, merge %7 ms)")
+                   .arg(_model.filterCount())
+                   .arg(timer.elapsed())
+                   .arg(sectionCount)
+                   .arg(threadCount)
+                   .arg(splitTime)
+                   .arg(parseTime - splitTime)
+                   .arg(timer.elapsed() - parseTime));
+  TIMING;
+}
+
+QVector<const char *> FiltersModelReader::sectionStarts(const QByteArray & stdlibArray, const QString & language, qint64 sectionSize)
+{
+  const char * begin = stdlibArray.constData();
+  const char * limit = begin + stdlibArray.size();
+  if (sectionSize >= stdlibArray.size()) {
+    return QVector<const char *>(1, begin);
+  }
+  const qint64 step = (sectionSize > 0) ? sectionSize : std::max<qint64>(SectionMinimumSize, stdlibArray.size() / (std::max(1, QThread::idealThreadCount()) * SectionsPerThread));
+
+  // Sources concatenated by Updater::buildFullStdlib()
+  QVector<const char *> separators;
+  const int separatorSize = static_cast<int>(std::strlen(ToTopLevelSeparator));
+  int index = stdlibArray.indexOf(ToTopLevelSeparator);
+  while (index != -1) {
+    if (isSectionStart(begin + index, begin, limit, language)) {
+      separators.push_back(begin + index);
+    }
+    index = stdlibArray.indexOf(ToTopLevelSeparator, index + separatorSize);
+  }
+  separators.push_back(limit);
+
+  // Large sources are split further, at the next folder or filter definition
+  QVector<const char *> starts;
+  starts.push_back(begin);
+  for (const char * separator : separators) {
+    const char * pc = starts.back() + std::min<qint64>(step, separator - starts.back());
+    while (pc < separator) {
+      const char * eol = static_cast<const char *>(std::memchr(pc, '\n', separator - pc));
+      if (!eol) {
+        break;
+      }
+      pc = eol + 1;
+      if ((pc < separator) && isSectionStart(pc, begin, limit, language)) {
+        starts.push_back(pc);
+        pc += std::min<qint64>(step, separator - pc);
+      }
+    }
+    if ((separator != limit) && (separator != starts.back())) {
+      starts.push_back(separator);
+    }
+  }
+  return starts;
+}
+
+// A line where the reading of the parameters of a filter stops, and which is not
+// the continuation of the previous one.
+bool FiltersModelReader::isSectionStart(const char * line, const char * begin, const char * limit, const QString & language)
+{
+  if ((line > begin) && (line[-1] != '\n')) {
+    return false;
+  }
+  if ((line - begin >= 2) && (line[-2] == '\\')) {
+    return false;
+  }
+  const char * pc = line;
+  traverseSpaces(pc, limit);
+  if (((limit - pc) < 5) || std::strncmp(pc, "#@gui", 5)) {
+    return false;
+  }
+  const QString text = readBufferLine(line, limit);
+  return isFolderNoLanguage(text) || isFolderLanguage(text, language) || isFilterNoLanguage(text) || isFilterLanguage(text, language);
+}
+
+void FiltersModelReader::parseSection(Section & section, const char * limit, const QString & language)
+{
+  const char * stdlib = section.begin;
+  const char * lineStart = stdlib;
+  QString buffer = readBufferLine(stdlib, limit);
+  QString line;
 
   const QChar WarningPrefix('!');
   do {
@@ -456,8 +643,9 @@ void FiltersModelReader::parseFiltersDefinitions(const QByteArray & stdlibArray)
     if (containsGuiComment(line)) {
       QString path;
       if (containsHidePath(line, language, path)) {
-        hiddenPaths.push_back(path);
-        buffer = readBufferLine(stdlib, stdLibLimit);
+        section.hiddenPaths.push_back(path);
+        lineStart = stdlib;
+        buffer = readBufferLine(stdlib, limit);
       } else if (isFolderNoLanguage(line) || isFolderLanguage(line, language)) {
         //
         // A folder
@@ -465,17 +653,19 @@ void FiltersModelReader::parseFiltersDefinitions(const QByteArray & stdlibArray)
         QString folderName = line;
         removeAtGuiLangPrefix(folderName);
 
-        while (folderName.startsWith("_") && !filterPath.isEmpty()) {
-          folderName.remove(0, 1);
-          filterPath.pop_back();
-        }
         while (folderName.startsWith("_")) {
           folderName.remove(0, 1);
+          if (section.path.isEmpty()) {
+            ++section.pops;
+          } else {
+            section.path.pop_back();
+          }
         }
         if (!folderName.isEmpty()) {
-          filterPath.push_back(folderName);
+          section.path.push_back(folderName);
         }
-        buffer = readBufferLine(stdlib, stdLibLimit);
+        lineStart = stdlib;
+        buffer = readBufferLine(stdlib, limit);
       } else if (isFilterNoLanguage(line) || isFilterLanguage(line, language)) {
         //
         // A filter
@@ -496,7 +686,11 @@ void FiltersModelReader::parseFiltersDefinitions(const QByteArray & stdlibArray)
         QString inputMode;
         if (containsInputMode(filterCommands, inputMode)) {
           removeInputMode(filterCommands);
-          defaultInputMode = symbolToInputMode(inputMode);
+          QString inputModeWarning;
+          defaultInputMode = symbolToInputMode(inputMode, inputModeWarning);
+          if (!inputModeWarning.isEmpty()) {
+            section.messages.push_back(qMakePair(QString("warning"), inputModeWarning));
+          }
         }
 
         QList<QString> commands = filterCommands.split(",");
@@ -529,62 +723,72 @@ void FiltersModelReader::parseFiltersDefinitions(const QByteArray & stdlibArray)
           }
           previewFactor = preview[1].toFloat(&ok);
           if (!ok) {
-            Logger::error(QString("Cannot parse zoom factor for filter [%1]:\n%2").arg(filterName).arg(line));
+            section.messages.push_back(qMakePair(QString("error"), QString("Cannot parse zoom factor for filter [%1]:\n%2").arg(filterName).arg(line)));
             previewFactor = PreviewFactorAny;
           }
           previewFactor = std::abs(previewFactor);
         }
 
+        // Optional tiling annotation: "tile(halo)"
+        int tileHalo = TileHaloNone;
+        if (commands.size() >= 3) {
+          QString tile = commands[2].trimmed();
+          if (tile == "tile") {
+            section.messages.push_back(qMakePair(QString("error"), QString("Missing tile halo for filter [%1], use tile(halo):\n%2").arg(filterName).arg(line)));
+          } else if (tile.startsWith("tile(") && tile.endsWith(")")) {
+            bool ok = false;
+            tileHalo = tile.mid(5, tile.size() - 6).trimmed().toInt(&ok);
+            if (!ok || (tileHalo < 0)) {
+              section.messages.push_back(qMakePair(QString("error"), QString("Cannot parse tile halo for filter [%1]:\n%2").arg(filterName).arg(line)));
+              tileHalo = TileHaloNone;
+            }
+          }
+        }
+
         QString filterPreviewCommand = preview[0].trimmed();
         QString start = line;
         removeLeadingSpaces(start);
         removeSpaceAndText(start); // #@gui or #@gui_fr
 
-        // Read parameters
+        // Read parameters, past the end of the section if needed (sections start with
+        // a folder or a filter, where the reading stops)
         QString parameters;
         do {
-          buffer = readBufferLine(stdlib, stdLibLimit);
+          lineStart = stdlib;
+          buffer = readBufferLine(stdlib, limit);
           if (isPrefixAndColon(buffer, start)) { //
             QString parameterLine = buffer;
             removeAtGuiSpacesAndColon(parameterLine);
             parameters += parameterLine;
           }
-        } while ((stdlib != stdLibLimit)                //
+        } while ((stdlib != limit)                      //
                  && !isFolderNoLanguage(buffer)         //
                  && !isFolderLanguage(buffer, language) //
                  && !isFilterNoLanguage(buffer)         //
                  && !isFilterLanguage(buffer, language));
-        FiltersModel::Filter filter;
-        filter.setName(filterName);
-        filter.setCommand(filterCommand);
-        filter.setPreviewCommand(filterPreviewCommand);
-        filter.setDefaultInputMode(defaultInputMode);
-        filter.setPreviewFactor(previewFactor);
-        filter.setAccurateIfZoomed(accurateIfZoomed);
-        filter.setPreviewFromFullImage(previewFromFullImage);
-        filter.setParameters(parameters);
-        filter.setPath(filterPath);
-        filter.setWarningFlag(warning);
-        filter.build();
-        _model.addFilter(filter);
+        Section::Definition definition;
+        definition.pops = section.pops;
+        definition.path = section.path;
+        definition.name = filterName;
+        definition.command = filterCommand;
+        definition.previewCommand = filterPreviewCommand;
+        definition.defaultInputMode = defaultInputMode;
+        definition.previewFactor = previewFactor;
+        definition.accurateIfZoomed = accurateIfZoomed;
+        definition.previewFromFullImage = previewFromFullImage;
+        definition.tileHalo = tileHalo;
+        definition.parameters = parameters;
+        definition.warning = warning;
+        section.definitions.push_back(definition);
       } else {
-        buffer = readBufferLine(stdlib, stdLibLimit);
+        lineStart = stdlib;
+        buffer = readBufferLine(stdlib, limit);
       }
     } else {
-      buffer = readBufferLine(stdlib, stdLibLimit);
-    }
-  } while (!buffer.isEmpty());
-
-  // Remove hidden filters from the model
-  for (const QString & path : hiddenPaths) {
-    const size_t count = _model.filterCount();
-    QList<QString> pathList = path.split("/", QT_SKIP_EMPTY_PARTS);
-    _model.removePath(pathList);
-    if (_model.filterCount() == count) {
-      Logger::warning(QString("While hiding filter, name or path not found: \"%1\"").arg(path));
+      lineStart = stdlib;
+      buffer = readBufferLine(stdlib, limit);
     }
-  }
-  TIMING;
+  } while (!buffer.isEmpty() && (lineStart < section.end));
 }
 
 bool FiltersModelReader::textIsPrecededBySpacesInSomeLineOfArray(const QByteArray & text, const QByteArray & array)
@@ -608,10 +812,10 @@ bool FiltersModelReader::textIsPrecededBySpacesInSomeLineOfArray(const QByteArra
   return false;
 }
 
-InputMode FiltersModelReader::symbolToInputMode(const QString & str)
+InputMode FiltersModelReader::symbolToInputMode(const QString & str, QString & warning)
 {
   if (str.length() != 1) {
-    Logger::warning(QString("'%1' is not recognized as a default input mode (should be a single symbol/letter)").arg(str));
+    warning = QString("'%1' is not recognized as a default input mode (should be a single symbol/letter)").arg(str);
     return InputMode::Unspecified;
   }
   switch (str.toLocal8Bit()[0]) {
@@ -633,7 +837,7 @@ InputMode FiltersModelReader::symbolToInputMode(const QString & str)
   case 'i':
     return InputMode::AllInvisible;
   default:
-    Logger::warning(QString("'%1' is not recognized as a default input mode").arg(str));
+    warning = QString("'%1' is not recognized as a default input mode").arg(str);
     return InputMode::Unspecified;
   }
 }
@@ -25,6 +25,7 @@
 #ifndef GMIC_QT_FILTERSMODELREADER_H
 #define GMIC_QT_FILTERSMODELREADER_H
 #include <QString>
+#include <QVector>
 #include "FilterSelector/FiltersModel.h"
 
 class QByteArray;
@@ -36,14 +37,23 @@ namespace GmicQt
 class FiltersModelReader {
 public:
   FiltersModelReader(FiltersModel & model);
-  void parseFiltersDefinitions(const QByteArray &stdlibArray);
+  /**
+   * Parse the stdlib in sections, on several threads. The sections are about sectionSize bytes
+   * (0 for a size depending on the number of threads, tests only otherwise): a size larger than
+   * the stdlib parses it as a single section.
+   */
+  void parseFiltersDefinitions(const QByteArray &stdlibArray, qint64 sectionSize = 0);
 
 private:
+  struct Section;
   FiltersModel & _model;
+  static QVector<const char *> sectionStarts(const QByteArray & stdlibArray, const QString & language, qint64 sectionSize);
+  static bool isSectionStart(const char * line, const char * begin, const char * limit, const QString & language);
+  static void parseSection(Section & section, const char * limit, const QString & language);
   static QString readBufferLine(QBuffer &);
   static QString readBufferLine(const char *& ptr, const char * limit);
   static bool textIsPrecededBySpacesInSomeLineOfArray(const QByteArray & text, const QByteArray & array);
-  static InputMode symbolToInputMode(const QString & str);
+  static InputMode symbolToInputMode(const QString & str, QString & warning);
 };
 
 } // namespace GmicQt
@@ -123,7 +123,9 @@ void FiltersPresenter::readFilters()
 
   QString cacheFilename = QString("%1%2").arg(gmicConfigPath(true), FILTERS_CACHE_FILENAME);
   bool readFromCacheIsOK = false;
-  if (GmicStdLib::hash() == FiltersModelBinaryReader::readHash(cacheFilename)) {
+  const QByteArray stdlib = GmicStdLib::current();
+  const QByteArray stdlibHash = GmicStdLib::hash(stdlib);
+  if (stdlibHash == FiltersModelBinaryReader::readHash(cacheFilename)) {
     readFromCacheIsOK = FiltersModelBinaryReader(_filtersModel).read(cacheFilename);
   } else {
     FilterGuiDynamismCache::clear();
@@ -131,10 +133,10 @@ void FiltersPresenter::readFilters()
 
   if (!readFromCacheIsOK) {
     FiltersModelReader filterModelReader(_filtersModel);
-    filterModelReader.parseFiltersDefinitions(GmicStdLib::Array);
+    filterModelReader.parseFiltersDefinitions(stdlib);
     // Write cache
     FiltersModelBinaryWriter writer(_filtersModel);
-    writer.write(cacheFilename, GmicStdLib::hash());
+    writer.write(cacheFilename, stdlibHash);
   }
 }
 
@@ -619,6 +621,7 @@ void FiltersPresenter::setCurrentFilter(const QString & hash)
       _currentFilter.previewCommand = fave.previewCommand();
       _currentFilter.isAccurateIfZoomed = filter.isAccurateIfZoomed();
       _currentFilter.previewFromFullImage = filter.previewFromFullImage();
+      _currentFilter.tileHalo = filter.tileHalo();
       _currentFilter.previewFactor = filter.previewFactor();
     } else {
       setInvalidFilter();
@@ -639,6 +642,7 @@ void FiltersPresenter::setCurrentFilter(const QString & hash)
     _currentFilter.previewCommand = filter.previewCommand();
     _currentFilter.isAccurateIfZoomed = filter.isAccurateIfZoomed();
     _currentFilter.previewFromFullImage = filter.previewFromFullImage();
+    _currentFilter.tileHalo = filter.tileHalo();
     _currentFilter.previewFactor = filter.previewFactor();
   } else {
     _currentFilter.setInvalid();
@@ -667,6 +671,7 @@ void FiltersPresenter::Filter::clear()
   plainTextName.clear();
   previewFactor = PreviewFactorAny;
   previewFromFullImage = false;
+  tileHalo = TileHaloNone;
   defaultInputMode = InputMode::Unspecified;
   isAFave = false;
 }
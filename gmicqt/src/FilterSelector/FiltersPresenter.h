@@ -56,6 +56,7 @@ public:
     QString hash;
     bool isAccurateIfZoomed;
     bool previewFromFullImage;
+    int tileHalo;
     float previewFactor;
     bool isAFave;
     void clear();
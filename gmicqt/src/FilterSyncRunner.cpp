@@ -27,7 +27,7 @@
 #include <QThread>
 #include <iostream>
 #include "FilterThread.h"
-#include "GmicStdlib.h"
+#include "InterpreterPool.h"
 #include "Logger.h"
 #include "Misc.h"
 #include "PersistentMemory.h"
@@ -156,19 +156,23 @@ void FilterSyncRunner::run()
     _gmicAbort = false;
     _gmicProgress = -1;
     Logger::log(fullCommandLine, _logSuffix, true);
-    gmic gmicInstance(_environment.isEmpty() ? nullptr : QString("%1").arg(_environment).toLocal8Bit().constData(), GmicStdLib::Array.constData(), true, &_gmicProgress, &_gmicAbort, 0.0f);
+    InterpreterPool::Lease gmicInstance(&_gmicProgress, &_gmicAbort);
+    if (!_environment.isEmpty()) {
+      gmicInstance->run(_environment.toLocal8Bit().constData(), 0.0f);
+    }
     if (PersistentMemory::image()) {
       if (*PersistentMemory::image() == gmic_store) {
-        gmicInstance.set_variable("_persistent", PersistentMemory::image());
+        gmicInstance->set_variable("_persistent", PersistentMemory::image());
       } else {
-        gmicInstance.set_variable("_persistent", '=', PersistentMemory::image());
+        gmicInstance->set_variable("_persistent", '=', PersistentMemory::image());
       }
     }
-    gmicInstance.set_variable("_host", '=', GmicQtHost::ApplicationShortname);
-    gmicInstance.set_variable("_tk", '=', "qt");
-    gmicInstance.run(fullCommandLine.toLocal8Bit().constData(), *_images, *_imageNames);
-    _gmicStatus = QString::fromLocal8Bit(gmicInstance.status);
-    gmicInstance.get_variable("_persistent").move_to(*_persistentMemoryOutput);
+    gmicInstance->set_variable("_host", '=', GmicQtHost::ApplicationShortname);
+    gmicInstance->set_variable("_tk", '=', "qt");
+    gmicInstance->run(fullCommandLine.toLocal8Bit().constData(), *_images, *_imageNames);
+    _gmicStatus = QString::fromLocal8Bit(gmicInstance->status);
+    gmicInstance->get_variable("_persistent").move_to(*_persistentMemoryOutput);
+    gmicInstance.release();
   } catch (gmic_exception & e) {
     _images->assign();
     _imageNames->assign();
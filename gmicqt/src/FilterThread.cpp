@@ -24,10 +24,18 @@
  */
 #include "FilterThread.h"
 #include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QRegularExpression>
+#include <atomic>
+#include <exception>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <vector>
 #include "FilterParameters/AbstractParameter.h"
-#include "GmicStdlib.h"
+#include "Globals.h"
+#include "InterpreterPool.h"
 #include "Logger.h"
 #include "Misc.h"
 #include "PersistentMemory.h"
@@ -37,6 +45,31 @@
 namespace GmicQt
 {
 
+namespace
+{
+
+// Runs a function in a thread with the stack size G'MIC needs (see FilterThread constructor)
+class TileThread : public QThread {
+public:
+  explicit TileThread(const std::function<void()> & function) : _function(function)
+  {
+#ifdef _IS_MACOS_
+    setStackSize(8 * 1024 * 1024);
+#endif
+  }
+
+protected:
+  void run() override
+  {
+    _function();
+  }
+
+private:
+  std::function<void()> _function;
+};
+
+} // namespace
+
 FilterThread::FilterThread(QObject * parent, const QString & command, const QString & arguments, const QString & environment)
     : QThread(parent), _command(command), _arguments(arguments), _environment(environment), //
       _images(new gmic_library::gmic_list<float>),                                          //
@@ -46,6 +79,10 @@ FilterThread::FilterThread(QObject * parent, const QString & command, const QStr
   _gmicAbort = false;
   _failed = false;
   _gmicProgress = 0.0f;
+  _tileHalo = -1;
+  _tileSize = 0;
+  _tileCount = 0;
+  _doneTiles = 0;
 #ifdef _IS_MACOS_
   setStackSize(8 * 1024 * 1024);
 #endif
@@ -68,6 +105,31 @@ void FilterThread::swapImages(gmic_library::gmic_list<float> & images)
   _images->swap(images);
 }
 
+void FilterThread::setSharedImages(const std::shared_ptr<const gmic_library::gmic_list<float>> & images)
+{
+  _images->assign();
+  _sharedImages = images;
+}
+
+const gmic_library::gmic_list<float> & FilterThread::inputImages() const
+{
+  return _sharedImages ? *_sharedImages : *_images;
+}
+
+void FilterThread::detachImages()
+{
+  if (!_sharedImages) {
+    return;
+  }
+  if (_sharedImages.use_count() == 1) {
+    // The cache has dropped these images meanwhile, no one else can reach them
+    _images->swap(const_cast<gmic_library::gmic_list<float> &>(*_sharedImages));
+  } else {
+    *_images = *_sharedImages;
+  }
+  _sharedImages.reset();
+}
+
 void FilterThread::setInputImages(const gmic_library::gmic_list<float> & list)
 {
   *_images = list;
@@ -176,6 +238,10 @@ int FilterThread::duration() const
 
 float FilterThread::progress() const
 {
+  const int tileCount = _tileCount;
+  if (tileCount) {
+    return 100.0f * _doneTiles / tileCount;
+  }
   return _gmicProgress;
 }
 
@@ -191,11 +257,173 @@ void FilterThread::setLogSuffix(const QString & text)
   _logSuffix = text;
 }
 
+void FilterThread::setTiling(int halo, int tileSize)
+{
+  _tileHalo = halo;
+  _tileSize = tileSize;
+}
+
 void FilterThread::abortGmic()
 {
   _gmicAbort = true;
 }
 
+void FilterThread::setupInterpreter(gmic & interpreter)
+{
+  if (!_environment.isEmpty()) {
+    interpreter.run(_environment.toLocal8Bit().constData(), 0.0f);
+  }
+  if (PersistentMemory::image()) {
+    if (*PersistentMemory::image() == gmic_store) {
+      interpreter.set_variable("_persistent", PersistentMemory::image());
+    } else {
+      interpreter.set_variable("_persistent", '=', PersistentMemory::image());
+    }
+  }
+  interpreter.set_variable("_host", '=', GmicQtHost::ApplicationShortname);
+  interpreter.set_variable("_tk", '=', "qt");
+}
+
+// Run the command independently on overlapping tiles of the input images, on all cores, and stitch the results.
+// Returns false (leaving the input untouched) when the images cannot be tiled or a tile output is not aligned
+// with its input, so that the caller can process the whole images instead.
+bool FilterThread::runTiles(const QString & fullCommandLine)
+{
+  const gmic_library::gmic_list<float> & input = inputImages();
+  if (!input.size() || (_tileHalo < 0) || (_tileSize <= 0)) {
+    return false;
+  }
+  const gmic_library::gmic_image<float> & first = input[0];
+  const int width = static_cast<int>(first.width());
+  const int height = static_cast<int>(first.height());
+  for (unsigned int i = 0; i < input.size(); ++i) {
+    const gmic_library::gmic_image<float> & image = input[i];
+    if ((static_cast<int>(image.width()) != width) || (static_cast<int>(image.height()) != height) || (image.depth() != 1)) {
+      return false;
+    }
+  }
+  if ((static_cast<qint64>(width) * height < TILED_APPLY_MIN_PIXELS) || ((width <= _tileSize) && (height <= _tileSize))) {
+    return false;
+  }
+  const int columns = (width + _tileSize - 1) / _tileSize;
+  const int rows = (height + _tileSize - 1) / _tileSize;
+  const int tileCount = columns * rows;
+  const QByteArray command = fullCommandLine.toLocal8Bit();
+
+  gmic_library::gmic_list<float> result(input.size());
+  gmic_library::gmic_list<char> resultNames;
+  QString status;
+  QMutex mutex;
+  bool allocated = false;
+  bool misaligned = false;
+  QString errorMessage;
+  std::atomic<int> nextTile(0);
+
+  auto worker = [&]() {
+    float progress = -1.0f;
+    int index;
+    while (((index = nextTile++) < tileCount) && !_gmicAbort) {
+      {
+        QMutexLocker locker(&mutex);
+        if (misaligned || !errorMessage.isEmpty()) {
+          return;
+        }
+      }
+      const int x0 = (index % columns) * _tileSize;
+      const int y0 = (index / columns) * _tileSize;
+      const int x1 = std::min(width, x0 + _tileSize) - 1;
+      const int y1 = std::min(height, y0 + _tileSize) - 1;
+      const int cx0 = std::max(0, x0 - _tileHalo);
+      const int cy0 = std::max(0, y0 - _tileHalo);
+      const int cx1 = std::min(width - 1, x1 + _tileHalo);
+      const int cy1 = std::min(height - 1, y1 + _tileHalo);
+      QString error;
+      // Nothing may escape a worker thread: any error stops the tiled processing
+      try {
+        gmic_library::gmic_list<float> tile(input.size());
+        for (unsigned int i = 0; i < input.size(); ++i) {
+          input[i].get_crop(cx0, cy0, cx1, cy1).move_to(tile[i]);
+        }
+        gmic_library::gmic_list<char> names(*_imageNames);
+        InterpreterPool::Lease interpreter(&progress, &_gmicAbort);
+        setupInterpreter(*interpreter);
+        interpreter->run(command.constData(), tile, names);
+        QMutexLocker locker(&mutex);
+        bool aligned = (tile.size() == result.size());
+        for (unsigned int i = 0; aligned && (i < tile.size()); ++i) {
+          aligned = (static_cast<int>(tile[i].width()) == 1 + cx1 - cx0) && (static_cast<int>(tile[i].height()) == 1 + cy1 - cy0) && (tile[i].depth() == 1) && //
+                    (!allocated || (tile[i].spectrum() == result[i].spectrum()));
+        }
+        if (!aligned) {
+          interpreter.release();
+          misaligned = true;
+          return;
+        }
+        if (!allocated) {
+          for (unsigned int i = 0; i < tile.size(); ++i) {
+            result[i].assign(width, height, 1, tile[i].spectrum());
+          }
+          allocated = true;
+        }
+        if (index == 0) {
+          status = QString::fromLocal8Bit(interpreter->status);
+          interpreter->get_variable("_persistent").move_to(*_persistentMemoryOutput);
+          names.move_to(resultNames);
+        }
+        interpreter.release();
+        locker.unlock();
+        // Tiles cover disjoint areas of the (already allocated) result images
+        for (unsigned int i = 0; i < tile.size(); ++i) {
+          result[i].draw_image(x0, y0, 0, 0, tile[i].get_crop(x0 - cx0, y0 - cy0, x1 - cx0, y1 - cy0));
+        }
+        ++_doneTiles;
+        continue;
+      } catch (gmic_exception & e) {
+        error = e.what();
+      } catch (std::exception & e) {
+        error = e.what();
+      } catch (...) {
+        error = "Unknown error during tiled processing";
+      }
+      QMutexLocker locker(&mutex);
+      if (errorMessage.isEmpty()) {
+        errorMessage = error.isEmpty() ? QString("Unknown error during tiled processing") : error;
+      }
+      return;
+    }
+  };
+
+  _doneTiles = 0;
+  _tileCount = tileCount;
+  const int threadCount = std::max(1, std::min(QThread::idealThreadCount(), tileCount));
+  std::vector<std::unique_ptr<TileThread>> threads;
+  for (int t = 1; t < threadCount; ++t) {
+    threads.emplace_back(new TileThread(worker));
+    threads.back()->start();
+  }
+  worker();
+  for (std::unique_ptr<TileThread> & thread : threads) {
+    thread->wait();
+  }
+  _tileCount = 0;
+
+  if (!errorMessage.isEmpty()) {
+    throw gmic_exception(nullptr, errorMessage.toLocal8Bit().constData());
+  }
+  if (_gmicAbort) {
+    throw gmic_exception(nullptr, "Aborted");
+  }
+  if (misaligned) {
+    Logger::warning(QString("Tiled processing not applicable (output not aligned with input), processing whole image."));
+    return false;
+  }
+  _sharedImages.reset();
+  _images->swap(result);
+  _imageNames->swap(resultNames);
+  _gmicStatus = status;
+  return true;
+}
+
 void FilterThread::run()
 {
   _startTime.start();
@@ -208,21 +436,20 @@ void FilterThread::run()
     appendWithSpace(fullCommandLine, _arguments);
     _gmicAbort = false;
     _gmicProgress = -1;
+    _tileCount = 0;
     Logger::log(fullCommandLine, _logSuffix, true);
-    gmic gmicInstance(_environment.isEmpty() ? nullptr : QString("%1").arg(_environment).toLocal8Bit().constData(), GmicStdLib::Array.constData(), true, &_gmicProgress, &_gmicAbort, 0.0f);
-    if (PersistentMemory::image()) {
-      if (*PersistentMemory::image() == gmic_store) {
-        gmicInstance.set_variable("_persistent", PersistentMemory::image());
-      } else {
-        gmicInstance.set_variable("_persistent", '=', PersistentMemory::image());
-      }
+    if (runTiles(fullCommandLine)) {
+      return;
     }
-    gmicInstance.set_variable("_host", '=', GmicQtHost::ApplicationShortname);
-    gmicInstance.set_variable("_tk", '=', "qt");
-    gmicInstance.run(fullCommandLine.toLocal8Bit().constData(), *_images, *_imageNames);
-    _gmicStatus = QString::fromLocal8Bit(gmicInstance.status);
-    gmicInstance.get_variable("_persistent").move_to(*_persistentMemoryOutput);
+    detachImages();
+    InterpreterPool::Lease gmicInstance(&_gmicProgress, &_gmicAbort);
+    setupInterpreter(*gmicInstance);
+    gmicInstance->run(fullCommandLine.toLocal8Bit().constData(), *_images, *_imageNames);
+    _gmicStatus = QString::fromLocal8Bit(gmicInstance->status);
+    gmicInstance->get_variable("_persistent").move_to(*_persistentMemoryOutput);
+    gmicInstance.release();
   } catch (gmic_exception & e) {
+    _sharedImages.reset();
     _images->assign();
     _imageNames->assign();
     const char * message = e.what();
@@ -28,13 +28,18 @@
 #include <QElapsedTimer>
 #include <QString>
 #include <QThread>
+#include <atomic>
+#include <memory>
 #include "Common.h"
 #include "GmicQt.h"
 #include "Host/GmicQtHost.h"
 
+struct gmic;
+
 namespace gmic_library
 {
 template <typename T> struct gmic_list;
+template <typename T> struct gmic_image;
 }
 
 namespace GmicQt
@@ -50,6 +55,13 @@ public:
   void setInputImages(const gmic_library::gmic_list<float> & list);
   void setImageNames(const gmic_library::gmic_list<char> & imageNames);
   void swapImages(gmic_library::gmic_list<float> & images);
+  /**
+   * @brief Use images shared with a cache as input.
+   *
+   * They are only read by tiled processing, and copied when the interpreter is about to
+   * modify them (or taken over if the thread holds the last reference by then).
+   */
+  void setSharedImages(const std::shared_ptr<const gmic_library::gmic_list<float>> & images);
   const gmic_library::gmic_list<float> & images() const;
   const gmic_library::gmic_list<char> & imageNames() const;
   gmic_library::gmic_image<char> & persistentMemoryOutput();
@@ -62,6 +74,7 @@ public:
   float progress() const;
   QString fullCommand() const;
   void setLogSuffix(const QString & text);
+  void setTiling(int halo, int tileSize);
 
   static QStringList status2StringList(QString);
   static QList<int> status2Visibilities(const QString &);
@@ -76,10 +89,15 @@ protected:
   void run() override;
 
 private:
+  void setupInterpreter(gmic & interpreter);
+  bool runTiles(const QString & fullCommandLine);
+  const gmic_library::gmic_list<float> & inputImages() const;
+  void detachImages();
   QString _command;
   const QString _arguments;
   QString _environment;
   gmic_library::gmic_list<float> * _images;
+  std::shared_ptr<const gmic_library::gmic_list<float>> _sharedImages;
   gmic_library::gmic_list<char> * _imageNames;
   gmic_library::gmic_image<char> * _persistentMemoryOutput;
   bool _gmicAbort;
@@ -90,6 +108,10 @@ private:
   QString _name;
   QString _logSuffix;
   QElapsedTimer _startTime;
+  int _tileHalo;
+  int _tileSize;
+  std::atomic<int> _tileCount; // Progress of tiled processing, shared by its worker threads
+  std::atomic<int> _doneTiles;
 };
 
 } // namespace GmicQt
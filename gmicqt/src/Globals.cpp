@@ -31,5 +31,7 @@ namespace GmicQt
 const float PreviewFactorAny = -1.0f;
 const float PreviewFactorFullImage = 1.0f;
 const float PreviewFactorActualSize = 0.0f;
+const int TileHaloNone = -1;
+const char * const ToTopLevelSeparator = "#@gui ________________________________________________________________________________\n";
 
 } // namespace GmicQt
@@ -34,6 +34,9 @@ namespace GmicQt
 extern const float PreviewFactorAny;
 extern const float PreviewFactorFullImage;
 extern const float PreviewFactorActualSize;
+extern const int TileHaloNone;
+// Line appended after each source of filters, closing all the folders it may have left open.
+extern const char * const ToTopLevelSeparator;
 const char WarningPrefix = '!';
 } // namespace GmicQt
 
@@ -43,6 +46,7 @@ const char WarningPrefix = '!';
 #define FILTERS_VISIBILITY_FILENAME "gmic_qt_visibility.dat"
 #define FILTERS_TAGS_FILENAME "gmic_qt_tags.dat"
 #define FILTERS_CACHE_FILENAME "gmic_qt_filters.dat"
+#define COMMANDS_CACHE_FILENAME "gmic_qt_commands.dat"
 
 #define FAVE_FOLDER_TEXT "<b>Faves</b>"
 #define FAVES_IMPORT_KEY "Faves/ImportedGTK179"
@@ -55,6 +59,9 @@ const char WarningPrefix = '!';
 #define LANGUAGE_CODE_KEY "Config/LanguageCode"
 #define HIGHDPI_KEY "Config/HighDPIEnabled"
 #define PREVIEW_SPLITTER_KEY "Config/PreviewSplitterType"
+#define OUT_OF_CORE_THRESHOLD_KEY "Config/OutOfCoreThresholdMB"
+#define OUT_OF_CORE_PATH_KEY "Config/OutOfCorePath"
+#define COMPACT_IMAGE_STORAGE_KEY "Config/CompactImageStorage"
 #define INTERNET_NEVER_UPDATE_PERIODICITY std::numeric_limits<int>::max()
 #define ONE_DAY_HOURS (24)
 #define ONE_WEEK_HOURS (7 * 24)
@@ -69,4 +76,13 @@ const char WarningPrefix = '!';
 #define KEYPOINTS_INTERACTIVE_MIDDLE_DELAY_MS ((KEYPOINTS_INTERACTIVE_LOWER_DELAY_MS + KEYPOINTS_INTERACTIVE_UPPER_DELAY_MS) / 2)
 #define KEYPOINTS_INTERACTIVE_AVERAGING_COUNT 6
 
+#define INTERPRETER_POOL_MAX_IDLE 4
+#define FILTER_HALO_CACHE_MAX_SIZE 256
+
+#define TILED_APPLY_TILE_SIZE 1024
+#define TILED_APPLY_MIN_PIXELS (16 * 1024 * 1024)
+
+#define INPUT_PYRAMID_MIN_SIZE 256
+#define INPUT_PYRAMID_MAX_BYTES (256 * 1024 * 1024)
+
 #endif // GMIC_QT_GLOBALS_H
@@ -31,9 +31,11 @@
 #include <QSize>
 #include <QString>
 #include <cstring>
+#include <memory>
 #include "CroppedActiveLayerProxy.h"
 #include "CroppedImageListProxy.h"
 #include "FilterGuiDynamismCache.h"
+#include "FilterHaloCache.h"
 #include "FilterSyncRunner.h"
 #include "FilterThread.h"
 #include "Globals.h"
@@ -47,6 +49,22 @@
 #include "Settings.h"
 #include "gmic.h"
 
+namespace
+{
+// Expand a normalized rectangle by margin pixels on each side, within a width x height image.
+GmicQt::GmicProcessor::FilterContext::VisibleRect expandedRect(const GmicQt::GmicProcessor::FilterContext::VisibleRect & rect, double margin, int width, int height)
+{
+  GmicQt::GmicProcessor::FilterContext::VisibleRect result;
+  const double mx = (width > 0) ? (margin / width) : 0.0;
+  const double my = (height > 0) ? (margin / height) : 0.0;
+  result.x = std::max(0.0, rect.x - mx);
+  result.y = std::max(0.0, rect.y - my);
+  result.w = std::min(1.0, rect.x + rect.w + mx) - result.x;
+  result.h = std::min(1.0, rect.y + rect.h + my) - result.y;
+  return result;
+}
+} // namespace
+
 namespace GmicQt
 {
 
@@ -89,41 +107,65 @@ void GmicProcessor::execute()
 {
   gmic_list<char> imageNames;
   FilterContext::VisibleRect & rect = _filterContext.visibleRect;
+  const bool isPreview = (_filterContext.requestType == FilterContext::RequestType::Preview) || //
+                         (_filterContext.requestType == FilterContext::RequestType::SynchronousPreview);
+  int maxWidth;
+  int maxHeight;
+  LayersExtentProxy::getExtent(_filterContext.inputOutputState.inputMode, maxWidth, maxHeight);
+
+  // Filters made of local commands only are previewed on the visible area plus the halo they need,
+  // instead of the whole image (filters cropping the preview by themselves) or the visible area only.
+  int halo = -1;
+  bool cropsPreview = false;
+  if (isPreview) {
+    halo = FilterHaloCache::halo(_filterContext.filterCommand, _filterContext.filterArguments, cropsPreview);
+  }
+  const bool previewFromRegion = isPreview && _filterContext.previewFromFullImage && cropsPreview && (halo >= 0);
+  const bool previewWithHalo = isPreview && !_filterContext.previewFromFullImage && !cropsPreview && (halo > 0);
+  FilterContext::VisibleRect inputRect = rect;
+  _previewHaloInputSize = QSize();
+
   _gmicImages->assign();
+  std::shared_ptr<const gmic_list<gmic_pixel_type>> inputImages;
   if ((_filterContext.requestType == FilterContext::RequestType::Preview) ||            //
       (_filterContext.requestType == FilterContext::RequestType::SynchronousPreview) || //
       (_filterContext.requestType == FilterContext::RequestType::GUIDynamismRun)) {
-    if (_filterContext.previewFromFullImage) {
-      CroppedImageListProxy::get(*_gmicImages, imageNames, 0.0, 0.0, 1.0, 1.0, _filterContext.inputOutputState.inputMode, 1.0);
+    if (previewFromRegion) {
+      inputRect = expandedRect(rect, halo, maxWidth, maxHeight);
+      inputImages = CroppedImageListProxy::get(imageNames, inputRect.x, inputRect.y, inputRect.w, inputRect.h, _filterContext.inputOutputState.inputMode, 1.0);
+      updateImageNames(imageNames);
+    } else if (_filterContext.previewFromFullImage) {
+      inputImages = CroppedImageListProxy::get(imageNames, 0.0, 0.0, 1.0, 1.0, _filterContext.inputOutputState.inputMode, 1.0);
+      updateImageNames(imageNames);
+    } else if (previewWithHalo) {
+      // The halo is expressed in pixels of the (possibly downscaled) preview input
+      inputRect = expandedRect(rect, halo / std::min(_filterContext.zoomFactor, 1.0), maxWidth, maxHeight);
+      inputImages = CroppedImageListProxy::get(imageNames, inputRect.x, inputRect.y, inputRect.w, inputRect.h, _filterContext.inputOutputState.inputMode, _filterContext.zoomFactor);
       updateImageNames(imageNames);
     } else {
-      CroppedImageListProxy::get(*_gmicImages, imageNames, rect.x, rect.y, rect.w, rect.h, _filterContext.inputOutputState.inputMode, _filterContext.zoomFactor);
+      inputImages = CroppedImageListProxy::get(imageNames, rect.x, rect.y, rect.w, rect.h, _filterContext.inputOutputState.inputMode, _filterContext.zoomFactor);
       updateImageNames(imageNames);
     }
   } else {
-    CroppedImageListProxy::get(*_gmicImages, imageNames, rect.x, rect.y, rect.w, rect.h, _filterContext.inputOutputState.inputMode, 1.0);
+    inputImages = CroppedImageListProxy::get(imageNames, rect.x, rect.y, rect.w, rect.h, _filterContext.inputOutputState.inputMode, 1.0, true);
   }
   _waitingCursorTimer.start(WAITING_CURSOR_DELAY);
   const InputOutputState & io = _filterContext.inputOutputState;
   QString env = QString("_input_layers=%1").arg(static_cast<int>(io.inputMode));
   env += QString(" _output_mode=%1").arg(static_cast<int>(io.outputMode));
   env += QString(" _output_messages=%1").arg(static_cast<int>(Settings::outputMessageMode()));
-  if ((_filterContext.requestType == FilterContext::RequestType::Preview) || //
-      (_filterContext.requestType == FilterContext::RequestType::SynchronousPreview)) {
+  if (isPreview) {
     env += QString(" _preview_area_width=%1").arg(_filterContext.previewWindowWidth);
     env += QString(" _preview_area_height=%1").arg(_filterContext.previewWindowHeight);
     env += QString(" _preview_timeout=%1").arg(_filterContext.previewTimeout);
     env += QString(" _preview_enabled=%1").arg(int(_filterContext.previewCheckBox));
     env += QString(" _randomized=%1").arg(int(_filterContext.randomized));
   }
-  int maxWidth;
-  int maxHeight;
   int preview_x0;
   int preview_y0;
   int preview_x1;
   int preview_y1;
   QSize previewSize;
-  LayersExtentProxy::getExtent(_filterContext.inputOutputState.inputMode, maxWidth, maxHeight);
   if (_filterContext.previewFromFullImage) {
     preview_x0 = static_cast<int>(rect.x * maxWidth);
     preview_y0 = static_cast<int>(rect.y * maxHeight);
@@ -134,6 +176,26 @@ void GmicProcessor::execute()
       previewSize = QSize(static_cast<int>(std::round(previewSize.width() * _filterContext.zoomFactor)), //
                           static_cast<int>(std::round(previewSize.height() * _filterContext.zoomFactor)));
     }
+    if (previewFromRegion) {
+      // Preview coordinates are relative to the region given to the filter (same rounding as the host)
+      const int x0 = static_cast<int>(std::floor(inputRect.x * maxWidth));
+      const int y0 = static_cast<int>(std::floor(inputRect.y * maxHeight));
+      preview_x0 -= x0;
+      preview_x1 -= x0;
+      preview_y0 -= y0;
+      preview_y1 -= y0;
+    }
+  } else if (previewWithHalo && inputImages->size()) {
+    const gmic_library::gmic_image<float> & input = (*inputImages)[0];
+    const int width = static_cast<int>(input.width());
+    const int height = static_cast<int>(input.height());
+    preview_x0 = static_cast<int>(std::round(width * (rect.x - inputRect.x) / inputRect.w));
+    preview_y0 = static_cast<int>(std::round(height * (rect.y - inputRect.y) / inputRect.h));
+    preview_x1 = std::max(preview_x0, std::min(width, static_cast<int>(std::round(width * (rect.x + rect.w - inputRect.x) / inputRect.w))) - 1);
+    preview_y1 = std::max(preview_y0, std::min(height, static_cast<int>(std::round(height * (rect.y + rect.h - inputRect.y) / inputRect.h))) - 1);
+    previewSize = QSize(1 + preview_x1 - preview_x0, 1 + preview_y1 - preview_y0);
+    _previewHaloInputSize = QSize(width, height);
+    _previewHaloCrop = QRect(QPoint(preview_x0, preview_y0), previewSize);
   } else {
     if (_filterContext.zoomFactor < 1.0) {
       maxWidth = static_cast<int>(std::round(maxWidth * _filterContext.zoomFactor));
@@ -154,6 +216,7 @@ void GmicProcessor::execute()
   _completedExecutionTime.restart();
   if (_filterContext.requestType == FilterContext::RequestType::SynchronousPreview) {
     FilterSyncRunner runner(this, _filterContext.filterCommand, _filterContext.filterArguments, env);
+    *_gmicImages = *inputImages;
     runner.swapImages(*_gmicImages);
     runner.setImageNames(imageNames);
     runner.setLogSuffix("preview");
@@ -166,7 +229,7 @@ void GmicProcessor::execute()
   } else if ((_filterContext.requestType == FilterContext::RequestType::Preview) || //
              (_filterContext.requestType == FilterContext::RequestType::GUIDynamismRun)) {
     _filterThread = new FilterThread(this, _filterContext.filterCommand, _filterContext.filterArguments, env);
-    _filterThread->swapImages(*_gmicImages);
+    _filterThread->setSharedImages(inputImages);
     _filterThread->setImageNames(imageNames);
     _filterThread->setLogSuffix("preview");
     if (_filterContext.requestType == FilterContext::RequestType::Preview) {
@@ -185,9 +248,13 @@ void GmicProcessor::execute()
     _lastAppliedCommandArguments = _filterContext.filterArguments;
     _lastAppliedCommandInOutState = _filterContext.inputOutputState;
     _filterThread = new FilterThread(this, _filterContext.filterCommand, _filterContext.filterArguments, env);
-    _filterThread->swapImages(*_gmicImages);
+    _filterThread->setSharedImages(inputImages);
     _filterThread->setImageNames(imageNames);
     _filterThread->setLogSuffix("apply");
+    // Only with the halo given by the filter: the inferred one is not reliable enough for the final result
+    if (_filterContext.tileHalo >= 0) {
+      _filterThread->setTiling(_filterContext.tileHalo, TILED_APPLY_TILE_SIZE);
+    }
     connect(_filterThread, &FilterThread::finished, this, &GmicProcessor::onApplyThreadFinished, Qt::QueuedConnection);
     gmic_library::cimg::srand(_previewRandomSeed);
     _filterThread->start();
@@ -401,6 +468,7 @@ void GmicProcessor::onPreviewThreadFinished()
   unsigned int badSpectrumIndex = 0;
   bool correctSpectrums = checkImageSpectrumAtMost4(*_gmicImages, badSpectrumIndex);
   if (correctSpectrums) {
+    cropPreviewHalo(*_gmicImages);
     for (unsigned int i = 0; i < _gmicImages->size(); ++i) {
       GmicQtHost::applyColorProfile((*_gmicImages)[i]);
     }
@@ -547,6 +615,7 @@ void GmicProcessor::manageSynchonousRunner(FilterSyncRunner & runner)
   _gmicImages->assign();
   runner.swapImages(*_gmicImages);
   PersistentMemory::move_from(runner.persistentMemoryOutput());
+  cropPreviewHalo(*_gmicImages);
   for (unsigned int i = 0; i < _gmicImages->size(); ++i) {
     GmicQtHost::applyColorProfile((*_gmicImages)[i]);
   }
@@ -555,6 +624,20 @@ void GmicProcessor::manageSynchonousRunner(FilterSyncRunner & runner)
   emit previewImageAvailable();
 }
 
+void GmicProcessor::cropPreviewHalo(gmic_library::gmic_list<float> & images) const
+{
+  if (_previewHaloInputSize.isEmpty()) {
+    return;
+  }
+  // Only images with the geometry of the input are known to be aligned with it
+  for (unsigned int i = 0; i < images.size(); ++i) {
+    gmic_library::gmic_image<float> & image = images[i];
+    if ((static_cast<int>(image.width()) == _previewHaloInputSize.width()) && (static_cast<int>(image.height()) == _previewHaloInputSize.height())) {
+      image.crop(_previewHaloCrop.left(), _previewHaloCrop.top(), _previewHaloCrop.right(), _previewHaloCrop.bottom());
+    }
+  }
+}
+
 const QList<int> & GmicProcessor::parametersVisibilityStates() const
 {
   return _parametersVisibilityStates;
@@ -28,6 +28,7 @@
 #include <QElapsedTimer>
 #include <QList>
 #include <QObject>
+#include <QRect>
 #include <QSettings>
 #include <QSignalMapper>
 #include <QString>
@@ -35,6 +36,7 @@
 #include <QTimer>
 #include <QVector>
 #include <deque>
+#include "Globals.h"
 #include "GmicQt.h"
 #include "InputOutputState.h"
 
@@ -76,6 +78,7 @@ public:
     int previewWindowHeight;
     int previewTimeout;
     bool previewFromFullImage = false;
+    int tileHalo = TileHaloNone;
     bool previewCheckBox;
     bool randomized;
     QString filterName;
@@ -138,6 +141,7 @@ private:
   void updateImageNames(gmic_library::gmic_list<char> & imageNames);
   void abortCurrentFilterThread();
   void manageSynchonousRunner(FilterSyncRunner & runner);
+  void cropPreviewHalo(gmic_library::gmic_list<float> & images) const;
 
   FilterThread * _filterThread;
   FilterContext _filterContext;
@@ -163,6 +167,8 @@ private:
   std::deque<int> _lastFilterPreviewExecutionDurations;
   int _completeFullImageProcessingCount;
   QVector<bool> _gmicStatusQuotedParameters;
+  QRect _previewHaloCrop;    // Visible area within the (halo-expanded) preview input
+  QSize _previewHaloInputSize; // Size of the preview input, empty if no halo was added
 };
 
 } // namespace GmicQt
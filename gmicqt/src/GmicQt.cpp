@@ -32,8 +32,12 @@
 #include <QString>
 #include <QThread>
 #include <QTimer>
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
 #include "Common.h"
 #include "Globals.h"
 #include "HeadlessProcessor.h"
@@ -45,6 +49,10 @@
 #include "Widgets/InOutPanel.h"
 #include "Widgets/ProgressInfoWindow.h"
 #include "gmic.h"
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define GMIC_QT_CONVERSION_SSE2
+#endif
 #ifdef _IS_MACOS_
 #include <libgen.h>
 #include <mach-o/dyld.h>
@@ -68,6 +76,172 @@ inline unsigned char float2uchar_bounded(const float & in)
   return (in < 0.0f) ? 0 : ((in > 255.0f) ? 255 : static_cast<unsigned char>(in));
 }
 
+// Below this number of pixels per thread, image conversions run on a single thread.
+const qint64 ConversionMinPixelsPerThread = 256 * 1024;
+
+/*
+ * Call rows(first, last) on bands of rows [first, last) covering [0, height),
+ * in parallel when the image is large enough.
+ */
+void forEachRowBand(const int width, const int height, const std::function<void(int, int)> & rows)
+{
+  const qint64 pixels = static_cast<qint64>(width) * height;
+  const int bands = static_cast<int>(std::min<qint64>(std::min<qint64>(QThread::idealThreadCount(), height), pixels / ConversionMinPixelsPerThread));
+  if (bands < 2) {
+    rows(0, height);
+    return;
+  }
+  std::vector<std::thread> threads;
+  threads.reserve(bands - 1);
+  for (int band = 1; band < bands; ++band) {
+    threads.emplace_back(rows, static_cast<int>((static_cast<qint64>(height) * band) / bands), static_cast<int>((static_cast<qint64>(height) * (band + 1)) / bands));
+  }
+  rows(0, height / bands);
+  for (std::thread & thread : threads) {
+    thread.join();
+  }
+}
+
+#ifdef GMIC_QT_CONVERSION_SSE2
+// Four floats clamped to [0,255] and truncated, as float2uchar_bounded() does.
+inline __m128i boundedInts(const float * in)
+{
+  return _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in), _mm_setzero_ps()), _mm_set1_ps(255.0f)));
+}
+
+inline __m128 byteToFloats(const __m128i pixels, const int shift)
+{
+  return _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, shift), _mm_set1_epi32(0xFF)));
+}
+#endif
+
+/*
+ * Row kernels between planar float channels and packed 8-bit QImage scanlines.
+ * Format_ARGB32 pixels are 0xAARRGGBB words, hence BGRA bytes on little-endian machines.
+ */
+
+void rowToARGB32(const float * srcR, const float * srcG, const float * srcB, const float * srcA, unsigned char * dst, const int n)
+{
+  int x = 0;
+  if (!archIsLittleEndian()) {
+    for (; x < n; ++x, dst += 4) {
+      dst[0] = float2uchar_bounded(srcA[x]);
+      dst[1] = float2uchar_bounded(srcR[x]);
+      dst[2] = float2uchar_bounded(srcG[x]);
+      dst[3] = float2uchar_bounded(srcB[x]);
+    }
+    return;
+  }
+#ifdef GMIC_QT_CONVERSION_SSE2
+  for (; x + 4 <= n; x += 4, dst += 16) {
+    const __m128i pixels = _mm_or_si128(_mm_or_si128(boundedInts(srcB + x), _mm_slli_epi32(boundedInts(srcG + x), 8)), //
+                                        _mm_or_si128(_mm_slli_epi32(boundedInts(srcR + x), 16), _mm_slli_epi32(boundedInts(srcA + x), 24)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), pixels);
+  }
+#endif
+  for (; x < n; ++x, dst += 4) {
+    dst[0] = float2uchar_bounded(srcB[x]);
+    dst[1] = float2uchar_bounded(srcG[x]);
+    dst[2] = float2uchar_bounded(srcR[x]);
+    dst[3] = float2uchar_bounded(srcA[x]);
+  }
+}
+
+void rowToRGB888(const float * srcR, const float * srcG, const float * srcB, unsigned char * dst, const int n)
+{
+  int x = 0;
+#ifdef GMIC_QT_CONVERSION_SSE2
+  if (archIsLittleEndian()) {
+    // Each pixel is written as a 32-bit word whose last byte is overwritten by the next pixel,
+    // so the last pixel of the row is always left to the scalar loop.
+    alignas(16) quint32 words[4];
+    for (; x + 4 < n; x += 4, dst += 12) {
+      _mm_store_si128(reinterpret_cast<__m128i *>(words), _mm_or_si128(_mm_or_si128(boundedInts(srcR + x), _mm_slli_epi32(boundedInts(srcG + x), 8)), //
+                                                                      _mm_slli_epi32(boundedInts(srcB + x), 16)));
+      std::memcpy(dst, words, 4);
+      std::memcpy(dst + 3, words + 1, 4);
+      std::memcpy(dst + 6, words + 2, 4);
+      std::memcpy(dst + 9, words + 3, 4);
+    }
+  }
+#endif
+  for (; x < n; ++x, dst += 3) {
+    dst[0] = float2uchar_bounded(srcR[x]);
+    dst[1] = float2uchar_bounded(srcG[x]);
+    dst[2] = float2uchar_bounded(srcB[x]);
+  }
+}
+
+void rowToGray8(const float * src, unsigned char * dst, const int n)
+{
+  int x = 0;
+#ifdef GMIC_QT_CONVERSION_SSE2
+  for (; x + 16 <= n; x += 16) {
+    const __m128i low = _mm_packs_epi32(boundedInts(src + x), boundedInts(src + x + 4));
+    const __m128i high = _mm_packs_epi32(boundedInts(src + x + 8), boundedInts(src + x + 12));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x), _mm_packus_epi16(low, high));
+  }
+#endif
+  for (; x < n; ++x) {
+    dst[x] = float2uchar_bounded(src[x]);
+  }
+}
+
+void rowFromARGB32(const unsigned char * src, float * dstR, float * dstG, float * dstB, float * dstA, const int n)
+{
+  int x = 0;
+  if (!archIsLittleEndian()) {
+    for (; x < n; ++x, src += 4) {
+      dstA[x] = static_cast<float>(src[0]);
+      dstR[x] = static_cast<float>(src[1]);
+      dstG[x] = static_cast<float>(src[2]);
+      dstB[x] = static_cast<float>(src[3]);
+    }
+    return;
+  }
+#ifdef GMIC_QT_CONVERSION_SSE2
+  for (; x + 4 <= n; x += 4, src += 16) {
+    const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+    _mm_storeu_ps(dstB + x, byteToFloats(pixels, 0));
+    _mm_storeu_ps(dstG + x, byteToFloats(pixels, 8));
+    _mm_storeu_ps(dstR + x, byteToFloats(pixels, 16));
+    _mm_storeu_ps(dstA + x, byteToFloats(pixels, 24));
+  }
+#endif
+  for (; x < n; ++x, src += 4) {
+    dstB[x] = static_cast<float>(src[0]);
+    dstG[x] = static_cast<float>(src[1]);
+    dstR[x] = static_cast<float>(src[2]);
+    dstA[x] = static_cast<float>(src[3]);
+  }
+}
+
+void rowFromRGB888(const unsigned char * src, float * dstR, float * dstG, float * dstB, const int n)
+{
+  int x = 0;
+#ifdef GMIC_QT_CONVERSION_SSE2
+  if (archIsLittleEndian()) {
+    // Pixels are read as 32-bit words, so the last pixel of the row is left to the scalar loop.
+    quint32 words[4];
+    for (; x + 4 < n; x += 4, src += 12) {
+      std::memcpy(words, src, 4);
+      std::memcpy(words + 1, src + 3, 4);
+      std::memcpy(words + 2, src + 6, 4);
+      std::memcpy(words + 3, src + 9, 4);
+      const __m128i pixels = _mm_set_epi32(static_cast<int>(words[3]), static_cast<int>(words[2]), static_cast<int>(words[1]), static_cast<int>(words[0]));
+      _mm_storeu_ps(dstR + x, byteToFloats(pixels, 0));
+      _mm_storeu_ps(dstG + x, byteToFloats(pixels, 8));
+      _mm_storeu_ps(dstB + x, byteToFloats(pixels, 16));
+    }
+  }
+#endif
+  for (; x < n; ++x, src += 3) {
+    dstR[x] = static_cast<float>(src[0]);
+    dstG[x] = static_cast<float>(src[1]);
+    dstB[x] = static_cast<float>(src[2]);
+  }
+}
+
 } // namespace
 
 namespace GmicQt
@@ -352,190 +526,93 @@ template void calibrateImage(gmic_library::gmic_image<unsigned char> & img, cons
 
 void convertGmicImageToQImage(const gmic_library::gmic_image<float> & in, QImage & out)
 {
-  out = QImage(in.width(), in.height(), QImage::Format_RGB888);
-
-  if (in.spectrum() >= 4 && out.format() != QImage::Format_ARGB32) {
-    out = out.convertToFormat(QImage::Format_ARGB32);
+  QImage::Format format;
+  if (in.spectrum() >= 4 || in.spectrum() == 2) {
+    format = QImage::Format_ARGB32;
+  } else if (in.spectrum() == 3) {
+    format = QImage::Format_RGB888;
+  } else {
+// Format_Grayscale8 was added in Qt 5.5.
+#if QT_VERSION_GTE(5, 5, 0)
+    format = QImage::Format_Grayscale8;
+#else
+    format = QImage::Format_RGB888;
+#endif
   }
 
-  if (in.spectrum() == 3 && out.format() != QImage::Format_RGB888) {
-    out = out.convertToFormat(QImage::Format_RGB888);
+  // Write into the caller's image when it can be reused as is, otherwise
+  // allocate the destination format directly.
+  if (out.width() != in.width() || out.height() != in.height() || out.format() != format || !out.isDetached()) {
+    out = QImage(in.width(), in.height(), format);
   }
-
-  if (in.spectrum() == 2 && out.format() != QImage::Format_ARGB32) {
-    out = out.convertToFormat(QImage::Format_ARGB32);
+  if (out.isNull()) {
+    return;
   }
 
-// Format_Grayscale8 was added in Qt 5.5.
-#if QT_VERSION_GTE(5, 5, 0)
-  if (in.spectrum() == 1 && out.format() != QImage::Format_Grayscale8) {
-    out = out.convertToFormat(QImage::Format_Grayscale8);
-  }
-#else
-  if (in.spectrum() == 1) {
-    out = out.convertToFormat(QImage::Format_RGB888);
-  }
-#endif
+  // Scanlines are addressed from bits(), as scanLine() may not be called from several threads.
+  unsigned char * const bits = out.bits();
+  const qint64 bytesPerLine = out.bytesPerLine();
+  const int width = in.width();
+  const qint64 channelSize = static_cast<qint64>(width) * in.height();
+  const float * const src = in.data();
 
-  if (in.spectrum() >= 4) {
-    const float * srcR = in.data(0, 0, 0, 0);
-    const float * srcG = in.data(0, 0, 0, 1);
-    const float * srcB = in.data(0, 0, 0, 2);
-    const float * srcA = in.data(0, 0, 0, 3);
-    int height = out.height();
-    if (archIsLittleEndian()) {
-      for (int y = 0; y < height; ++y) {
-        int n = in.width();
-        unsigned char * dst = out.scanLine(y);
-        while (n--) {
-          dst[0] = float2uchar_bounded(*srcB++);
-          dst[1] = float2uchar_bounded(*srcG++);
-          dst[2] = float2uchar_bounded(*srcR++);
-          dst[3] = float2uchar_bounded(*srcA++);
-          dst += 4;
-        }
-      }
-    } else {
-      for (int y = 0; y < height; ++y) {
-        int n = in.width();
-        unsigned char * dst = out.scanLine(y);
-        while (n--) {
-          dst[0] = float2uchar_bounded(*srcA++);
-          dst[1] = float2uchar_bounded(*srcR++);
-          dst[2] = float2uchar_bounded(*srcG++);
-          dst[3] = float2uchar_bounded(*srcB++);
-          dst += 4;
-        }
-      }
-    }
-  } else if (in.spectrum() == 3) {
-    const float * srcR = in.data(0, 0, 0, 0);
-    const float * srcG = in.data(0, 0, 0, 1);
-    const float * srcB = in.data(0, 0, 0, 2);
-    int height = out.height();
-    for (int y = 0; y < height; ++y) {
-      int n = in.width();
-      unsigned char * dst = out.scanLine(y);
-      while (n--) {
-        dst[0] = float2uchar_bounded(*srcR++);
-        dst[1] = float2uchar_bounded(*srcG++);
-        dst[2] = float2uchar_bounded(*srcB++);
-        dst += 3;
-      }
-    }
-  } else if (in.spectrum() == 2) {
-    //
-    // Gray + Alpha
-    //
-    const float * src = in.data(0, 0, 0, 0);
-    const float * srcA = in.data(0, 0, 0, 1);
-    int height = out.height();
-    if (archIsLittleEndian()) {
-      for (int y = 0; y < height; ++y) {
-        int n = in.width();
-        unsigned char * dst = out.scanLine(y);
-        while (n--) {
-          dst[2] = dst[1] = dst[0] = float2uchar_bounded(*src++);
-          dst[3] = float2uchar_bounded(*srcA++);
-          dst += 4;
-        }
-      }
-    } else {
-      for (int y = 0; y < height; ++y) {
-        int n = in.width();
-        unsigned char * dst = out.scanLine(y);
-        while (n--) {
-          dst[1] = dst[2] = dst[3] = float2uchar_bounded(*src++);
-          dst[0] = float2uchar_bounded(*srcA++);
-          dst += 4;
-        }
-      }
-    }
-  } else {
-    //
-    // 8-bits Gray levels
-    //
-    const float * src = in.data(0, 0, 0, 0);
-    int height = out.height();
-    for (int y = 0; y < height; ++y) {
-      int n = in.width();
-      unsigned char * dst = out.scanLine(y);
+  forEachRowBand(width, in.height(), [&](const int firstRow, const int lastRow) {
+    for (int y = firstRow; y < lastRow; ++y) {
+      const float * const srcRow = src + static_cast<qint64>(y) * width;
+      unsigned char * const dst = bits + y * bytesPerLine;
+      switch (in.spectrum()) {
+      case 1:
 #if QT_VERSION_GTE(5, 5, 0)
-      while (n--) {
-        *dst++ = static_cast<unsigned char>(*src++);
-      }
+        rowToGray8(srcRow, dst, width);
 #else
-      while (n--) {
-        dst[0] = float2uchar_bounded(*src);
-        dst[1] = float2uchar_bounded(*src);
-        dst[2] = float2uchar_bounded(*src);
-        ++src;
-        dst += 3;
-      }
+        rowToRGB888(srcRow, srcRow, srcRow, dst, width);
 #endif
+        break;
+      case 2: // Gray + Alpha
+        rowToARGB32(srcRow, srcRow, srcRow, srcRow + channelSize, dst, width);
+        break;
+      case 3:
+        rowToRGB888(srcRow, srcRow + channelSize, srcRow + 2 * channelSize, dst, width);
+        break;
+      default:
+        rowToARGB32(srcRow, srcRow + channelSize, srcRow + 2 * channelSize, srcRow + 3 * channelSize, dst, width);
+        break;
+      }
     }
-  }
+  });
 }
 
 void convertQImageToGmicImage(const QImage & in, gmic_library::gmic_image<float> & out)
 {
   Q_ASSERT_X(in.format() == QImage::Format_ARGB32 || in.format() == QImage::Format_RGB888, "convert", "bad input format");
+  if (in.format() != QImage::Format_ARGB32 && in.format() != QImage::Format_RGB888) {
+    return;
+  }
 
-  if (in.format() == QImage::Format_ARGB32) {
-    const int w = in.width();
-    const int h = in.height();
-    out.assign(w, h, 1, 4);
-    float * dstR = out.data(0, 0, 0, 0);
-    float * dstG = out.data(0, 0, 0, 1);
-    float * dstB = out.data(0, 0, 0, 2);
-    float * dstA = out.data(0, 0, 0, 3);
-    if (archIsLittleEndian()) {
-      for (int y = 0; y < h; ++y) {
-        const unsigned char * src = in.scanLine(y);
-        int n = in.width();
-        while (n--) {
-          *dstB++ = static_cast<float>(src[0]);
-          *dstG++ = static_cast<float>(src[1]);
-          *dstR++ = static_cast<float>(src[2]);
-          *dstA++ = static_cast<float>(src[3]);
-          src += 4;
-        }
-      }
-    } else {
-      for (int y = 0; y < h; ++y) {
-        const unsigned char * src = in.scanLine(y);
-        int n = in.width();
-        while (n--) {
-          *dstA++ = static_cast<float>(src[0]);
-          *dstR++ = static_cast<float>(src[1]);
-          *dstG++ = static_cast<float>(src[2]);
-          *dstB++ = static_cast<float>(src[3]);
-          src += 4;
-        }
-      }
-    }
+  const bool withAlpha = (in.format() == QImage::Format_ARGB32);
+  const int w = in.width();
+  const int h = in.height();
+  out.assign(w, h, 1, withAlpha ? 4 : 3);
+  if (out.is_empty()) {
     return;
   }
 
-  if (in.format() == QImage::Format_RGB888) {
-    const int w = in.width();
-    const int h = in.height();
-    out.assign(w, h, 1, 3);
-    float * dstR = out.data(0, 0, 0, 0);
-    float * dstG = out.data(0, 0, 0, 1);
-    float * dstB = out.data(0, 0, 0, 2);
-    for (int y = 0; y < h; ++y) {
-      const unsigned char * src = in.scanLine(y);
-      int n = in.width();
-      while (n--) {
-        *dstR++ = static_cast<float>(src[0]);
-        *dstG++ = static_cast<float>(src[1]);
-        *dstB++ = static_cast<float>(src[2]);
-        src += 3;
+  const unsigned char * const bits = in.constBits();
+  const qint64 bytesPerLine = in.bytesPerLine();
+  const qint64 channelSize = static_cast<qint64>(w) * h;
+  float * const dst = out.data();
+
+  forEachRowBand(w, h, [&](const int firstRow, const int lastRow) {
+    for (int y = firstRow; y < lastRow; ++y) {
+      const unsigned char * const src = bits + y * bytesPerLine;
+      float * const dstRow = dst + static_cast<qint64>(y) * w;
+      if (withAlpha) {
+        rowFromARGB32(src, dstRow, dstRow + channelSize, dstRow + 2 * channelSize, dstRow + 3 * channelSize, w);
+      } else {
+        rowFromRGB888(src, dstRow, dstRow + channelSize, dstRow + 2 * channelSize, w);
       }
     }
-    return;
-  }
+  });
 }
 
 } // namespace GmicQt
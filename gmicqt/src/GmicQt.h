@@ -142,6 +142,12 @@ int run(UserInterfaceMode interfaceMode = UserInterfaceMode::Full,
 template <typename T> //
 void calibrateImage(gmic_library::gmic_image<T> & img, const int spectrum, const bool isPreview);
 
+/**
+ * Convert a G'MIC image to a QImage (Grayscale8, RGB888 or ARGB32, depending on the spectrum).
+ *
+ * If out already has the expected size and format and does not share its data,
+ * pixels are written in place, which includes a QImage built on a caller-supplied buffer.
+ */
 void convertGmicImageToQImage(const gmic_library::gmic_image<float> & in, QImage & out);
 
 void convertQImageToGmicImage(const QImage & in, gmic_library::gmic_image<float> & out);
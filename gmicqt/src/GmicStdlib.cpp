@@ -29,6 +29,7 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QList>
+#include <QMutexLocker>
 #include <QRegularExpression>
 #include <QRegularExpressionMatch>
 #include <QString>
@@ -42,20 +43,35 @@
 namespace GmicQt
 {
 
-QByteArray GmicStdLib::Array;
+QMutex GmicStdLib::_mutex;
+QByteArray GmicStdLib::_array;
 
 void GmicStdLib::loadStdLib() // TODO : Remove
 {
   QString path = QString("%1update%2.gmic").arg(gmicConfigPath(false)).arg(gmic_version);
   QFileInfo info(path);
   QFile stdlib(path);
+  QByteArray array;
   if ((info.size() == 0) || !stdlib.open(QFile::ReadOnly)) {
     gmic_image<char> stdlib_h = gmic::decompress_stdlib();
-    Array = QByteArray::fromRawData(stdlib_h, stdlib_h.size());
-    Array[Array.size() - 1] = '\n';
+    array = QByteArray::fromRawData(stdlib_h, stdlib_h.size());
+    array[array.size() - 1] = '\n';
   } else {
-    Array = stdlib.readAll();
+    array = stdlib.readAll();
   }
+  setCurrent(array);
+}
+
+QByteArray GmicStdLib::current()
+{
+  QMutexLocker locker(&_mutex);
+  return _array;
+}
+
+void GmicStdLib::setCurrent(const QByteArray & stdlib)
+{
+  QMutexLocker locker(&_mutex);
+  _array = stdlib;
 }
 
 QString GmicStdLib::substituteSourceVariables(QString text)
@@ -101,9 +117,9 @@ QStringList GmicStdLib::substituteSourceVariables(const QStringList & list)
   return result;
 }
 
-QByteArray GmicStdLib::hash()
+QByteArray GmicStdLib::hash(const QByteArray & stdlib)
 {
-  return QCryptographicHash::hash(Array, QCryptographicHash::Sha1);
+  return QCryptographicHash::hash(stdlib, QCryptographicHash::Sha1);
 }
 
 } // namespace GmicQt
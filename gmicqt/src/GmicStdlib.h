@@ -26,6 +26,7 @@
 #define GMIC_QT_GMICSTDLIB_H
 
 #include <QByteArray>
+#include <QMutex>
 #include <QString>
 #include <QStringList>
 
@@ -36,10 +37,19 @@ class GmicStdLib {
 public:
   GmicStdLib() = delete;
   static void loadStdLib();
-  static QByteArray Array;
+  /**
+   * The stdlib in use, as a (shallow) copy: it may be replaced meanwhile by another thread.
+   * While the copy is held, its data pointer cannot be reused by another stdlib.
+   */
+  static QByteArray current();
+  static void setCurrent(const QByteArray & stdlib);
   static QString substituteSourceVariables(QString text);
   static QStringList substituteSourceVariables(const QStringList &list);
-  static QByteArray hash();
+  static QByteArray hash(const QByteArray & stdlib);
+
+private:
+  static QMutex _mutex;
+  static QByteArray _array;
 };
 
 } // namespace GmicQt
@@ -60,7 +60,7 @@ HeadlessProcessor::HeadlessProcessor(QObject * parent) //
 {
   _progressWindow = nullptr;
   _processingCompletedProperly = false;
-  GmicStdLib::Array = Updater::getInstance()->buildFullStdlib();
+  GmicStdLib::setCurrent(Updater::getInstance()->fullStdlib());
 }
 
 HeadlessProcessor::~HeadlessProcessor()
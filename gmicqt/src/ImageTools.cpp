@@ -68,6 +68,30 @@ template <typename T> bool hasAlphaChannel(const gmic_library::gmic_image<T> & i
   return image.spectrum() == 2 || image.spectrum() == 4;
 }
 
+void compactImage(const gmic_library::gmic_image<float> & in, gmic_library::gmic_image<unsigned short> & out)
+{
+  out.assign(in.width(), in.height(), in.depth(), in.spectrum());
+  const float * src = in.data();
+  unsigned short * dst = out.data();
+  const size_t size = in.size();
+  for (size_t i = 0; i < size; ++i) {
+    const float value = src[i] * 256.0f + 0.5f;
+    // Written so that NaN is stored as 0 (converting it is undefined behavior)
+    dst[i] = !(value > 0.0f) ? 0 : (value >= 65535.0f) ? 65535 : static_cast<unsigned short>(value);
+  }
+}
+
+void expandImage(const gmic_library::gmic_image<unsigned short> & in, gmic_library::gmic_image<float> & out)
+{
+  out.assign(in.width(), in.height(), in.depth(), in.spectrum());
+  const unsigned short * src = in.data();
+  float * dst = out.data();
+  const size_t size = in.size();
+  for (size_t i = 0; i < size; ++i) {
+    dst[i] = src[i] * (1.0f / 256.0f);
+  }
+}
+
 template bool hasAlphaChannel(const gmic_library::gmic_image<float> &);
 template bool hasAlphaChannel(const gmic_library::gmic_image<unsigned char> &);
 
@@ -42,6 +42,13 @@ void buildPreviewImage(const gmic_library::gmic_list<float> & images, gmic_libra
 
 template <typename T> bool hasAlphaChannel(const gmic_library::gmic_image<T> & image);
 
+/**
+ * Compact storage of images with values in [0,255] as 8.8 fixed-point 16-bit integers
+ * (exact for 8-bit inputs, 1/256 precision otherwise). Out-of-range values are clamped.
+ */
+void compactImage(const gmic_library::gmic_image<float> & in, gmic_library::gmic_image<unsigned short> & out);
+void expandImage(const gmic_library::gmic_image<unsigned short> & in, gmic_library::gmic_image<float> & out);
+
 } // namespace GmicQt
 
 #endif // GMIC_QT_IMAGETOOLS_H
@@ -0,0 +1,191 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file InterpreterPool.cpp
+ *
+ *  Copyright 2026 The digiKam developers
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "InterpreterPool.h"
+#include <QCryptographicHash>
+#include <QMutexLocker>
+#include "Common.h"
+#include "Globals.h"
+#include "GmicStdlib.h"
+#include "Logger.h"
+#include "Utils.h"
+#include "gmic.h"
+
+namespace GmicQt
+{
+
+QMutex InterpreterPool::_mutex;
+QMutex InterpreterPool::_buildMutex;
+QMutex InterpreterPool::_haloMutex;
+QByteArray InterpreterPool::_stdlib;
+QByteArray InterpreterPool::_stdlibHash;
+std::shared_ptr<gmic> InterpreterPool::_reference;
+QList<gmic *> InterpreterPool::_idleInterpreters;
+QHash<gmic *, QByteArray> InterpreterPool::_busyInterpreters;
+
+InterpreterPool::Lease::Lease(float * progress, bool * isAbort) : _interpreter(InterpreterPool::acquire(progress, isAbort)) {}
+
+InterpreterPool::Lease::~Lease()
+{
+  InterpreterPool::discard(_interpreter);
+}
+
+gmic * InterpreterPool::Lease::operator->() const
+{
+  return _interpreter;
+}
+
+gmic & InterpreterPool::Lease::operator*() const
+{
+  return *_interpreter;
+}
+
+void InterpreterPool::Lease::release()
+{
+  InterpreterPool::release(_interpreter);
+  _interpreter = nullptr;
+}
+
+gmic * InterpreterPool::acquire(float * progress, bool * isAbort)
+{
+  QByteArray hash;
+  std::shared_ptr<gmic> referenceInterpreter = reference(&hash);
+  gmic * interpreter = nullptr;
+  {
+    QMutexLocker locker(&_mutex);
+    if ((hash == _stdlibHash) && !_idleInterpreters.isEmpty()) {
+      interpreter = _idleInterpreters.takeLast();
+    }
+  }
+  // Idle interpreters were reset from the same reference: their command tables are only copied if a run changed them
+  const bool keepCommands = interpreter;
+  if (!interpreter) {
+    interpreter = new gmic(nullptr, nullptr, false, nullptr, nullptr, 0.0f);
+  }
+  try {
+    interpreter->reset(*referenceInterpreter, progress, isAbort, keepCommands);
+  } catch (...) {
+    delete interpreter;
+    throw;
+  }
+  QMutexLocker locker(&_mutex);
+  _busyInterpreters.insert(interpreter, hash);
+  return interpreter;
+}
+
+void InterpreterPool::release(gmic * interpreter)
+{
+  if (!interpreter) {
+    return;
+  }
+  QMutexLocker locker(&_mutex);
+  const QByteArray hash = _busyInterpreters.take(interpreter);
+  if (!hash.isEmpty() && (hash == _stdlibHash) && (_idleInterpreters.size() < INTERPRETER_POOL_MAX_IDLE)) {
+    _idleInterpreters.push_back(interpreter);
+    return;
+  }
+  locker.unlock();
+  delete interpreter;
+}
+
+void InterpreterPool::discard(gmic * interpreter)
+{
+  if (!interpreter) {
+    return;
+  }
+  {
+    QMutexLocker locker(&_mutex);
+    _busyInterpreters.remove(interpreter);
+  }
+  delete interpreter;
+}
+
+void InterpreterPool::clear()
+{
+  QMutexLocker locker(&_mutex);
+  qDeleteAll(_idleInterpreters);
+  _idleInterpreters.clear();
+  _reference.reset();
+  _stdlib.clear();
+  _stdlibHash.clear();
+}
+
+int InterpreterPool::halo(const char * commandsLine, const char * roiCommands, bool * isRoiCommand)
+{
+  std::shared_ptr<gmic> referenceInterpreter = reference(nullptr);
+  // get_halo() only writes the debug info of the interpreter, which reset() does not copy
+  QMutexLocker locker(&_haloMutex);
+  return referenceInterpreter->get_halo(commandsLine, roiCommands, isRoiCommand);
+}
+
+// The stdlib is parsed without holding the pool mutex, so that releasing or discarding interpreters is never
+// blocked by it. Concurrent callers needing a new reference wait for the first one to build it.
+std::shared_ptr<gmic> InterpreterPool::reference(QByteArray * hash)
+{
+  const QByteArray stdlib = GmicStdLib::current();
+  {
+    QMutexLocker locker(&_mutex);
+    // Holding a (shallow) copy of the array guarantees that an unchanged data pointer means unchanged contents
+    if (_reference && (_stdlib.constData() == stdlib.constData()) && (_stdlib.size() == stdlib.size())) {
+      if (hash) {
+        *hash = _stdlibHash;
+      }
+      return _reference;
+    }
+  }
+  const QByteArray stdlibHash = QCryptographicHash::hash(stdlib, QCryptographicHash::Sha1);
+  if (hash) {
+    *hash = stdlibHash;
+  }
+  QMutexLocker buildLocker(&_buildMutex);
+  {
+    QMutexLocker locker(&_mutex);
+    if (_reference && (stdlibHash == _stdlibHash)) {
+      _stdlib = stdlib;
+      return _reference;
+    }
+  }
+  TIMING;
+  std::shared_ptr<gmic> interpreter(new gmic(nullptr, nullptr, false, nullptr, nullptr, 0.0f));
+  // Command tables are restored from a precompiled cache, unless the stdlib or the G'MIC version changed
+  const QString cacheFilename = gmicConfigPath(true) + COMMANDS_CACHE_FILENAME;
+  const QByteArray cacheKey = QString("%1_%2").arg(gmic_version).arg(QString::fromLatin1(stdlibHash.toHex())).toLatin1();
+  if (!interpreter->load_commands_cache(cacheFilename.toLocal8Bit().constData(), cacheKey.constData())) {
+    interpreter->add_commands(gmic::decompress_stdlib().data());
+    interpreter->add_commands(stdlib.constData());
+    if (!interpreter->save_commands_cache(cacheFilename.toLocal8Bit().constData(), cacheKey.constData())) {
+      Logger::warning(QString("Cannot write commands cache %1").arg(cacheFilename));
+    }
+  }
+  QMutexLocker locker(&_mutex);
+  qDeleteAll(_idleInterpreters);
+  _idleInterpreters.clear();
+  _stdlib = stdlib;
+  _stdlibHash = stdlibHash;
+  _reference = interpreter;
+  TIMING;
+  return _reference;
+}
+
+} // namespace GmicQt
@@ -0,0 +1,92 @@
+/** -*- mode: c++ ; c-basic-offset: 2 -*-
+ *
+ *  @file InterpreterPool.h
+ *
+ *  Copyright 2026 The digiKam developers
+ *
+ *  This file is part of G'MIC-Qt, a generic plug-in for raster graphics
+ *  editors, offering hundreds of filters thanks to the underlying G'MIC
+ *  image processing framework.
+ *
+ *  gmic_qt is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  gmic_qt is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with gmic_qt.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#ifndef GMIC_QT_INTERPRETERPOOL_H
+#define GMIC_QT_INTERPRETERPOOL_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <memory>
+
+struct gmic;
+
+namespace GmicQt
+{
+
+/**
+ * @brief Pool of G'MIC interpreters with the full stdlib already parsed.
+ *
+ * A reference interpreter is built once for a given GmicStdLib::current()
+ * (keyed by its hash). Checked-out interpreters are reset to the state of
+ * this reference (global variables, status, callstack). Command tables are
+ * only copied again when a run has changed them.
+ */
+class InterpreterPool {
+public:
+  /**
+   * @brief Interpreter checked out of the pool, discarded when going out of scope unless released.
+   */
+  class Lease {
+  public:
+    Lease(float * progress, bool * isAbort);
+    ~Lease();
+    Lease(const Lease &) = delete;
+    Lease & operator=(const Lease &) = delete;
+    gmic * operator->() const;
+    gmic & operator*() const;
+    void release();
+
+  private:
+    gmic * _interpreter;
+  };
+
+  InterpreterPool() = delete;
+  static gmic * acquire(float * progress, bool * isAbort);
+  static void release(gmic * interpreter);
+  static void discard(gmic * interpreter);
+  static void clear();
+  /**
+   * @brief Halo of a commands line (see gmic::get_halo()), analyzed with the reference interpreter.
+   *
+   * The analysis only reads the command tables, so no interpreter has to be reset for it.
+   */
+  static int halo(const char * commandsLine, const char * roiCommands, bool * isRoiCommand);
+
+private:
+  static std::shared_ptr<gmic> reference(QByteArray * hash);
+  static QMutex _mutex;
+  static QMutex _buildMutex;
+  static QMutex _haloMutex;
+  static QByteArray _stdlib;
+  static QByteArray _stdlibHash;
+  static std::shared_ptr<gmic> _reference;
+  static QList<gmic *> _idleInterpreters;
+  static QHash<gmic *, QByteArray> _busyInterpreters;
+};
+
+} // namespace GmicQt
+
+#endif // GMIC_QT_INTERPRETERPOOL_H
@@ -271,6 +271,7 @@ MainWindow::~MainWindow()
   FilterGuiDynamismCache::save();
   saveSettings();
   Logger::setMode(Logger::Mode::StandardOutput); // Close log file, if necessary
+  CroppedImageListProxy::clear();                // Cached input images outlive the window otherwise
   delete ui;
 }
 
@@ -399,7 +400,7 @@ void MainWindow::onUpdateDownloadsFinished(int status)
 void MainWindow::buildFiltersTree()
 {
   saveCurrentParameters();
-  GmicStdLib::Array = Updater::getInstance()->buildFullStdlib();
+  GmicStdLib::setCurrent(Updater::getInstance()->fullStdlib());
   const bool withVisibility = filtersSelectionMode();
   _filtersPresenter->clear();
   _filtersPresenter->readFilters();
@@ -529,6 +530,7 @@ void MainWindow::onStartupFiltersUpdateFinished(int status)
   // Let the standalone version load an image, if necessary (not pretty)
   if (GmicQtHost::ApplicationName.isEmpty()) {
     LayersExtentProxy::clear();
+    CroppedImageListProxy::clear();
     QSize extent = LayersExtentProxy::getExtent(ui->inOutSelector->inputMode());
     ui->previewWidget->setFullImageSize(extent);
     ui->previewWidget->update();
@@ -853,6 +855,7 @@ void MainWindow::processImage()
   ui->filterParams->updateValueString(false); // Required to get up-to-date values of text parameters
   context.filterArguments = ui->filterParams->valueString();
   context.previewFromFullImage = false;
+  context.tileHalo = currentFilter.tileHalo;
   _processor.setGmicStatusQuotedParameters(ui->filterParams->quotedParameters());
   ui->filterParams->clearButtonParameters();
   _processor.setContext(context);
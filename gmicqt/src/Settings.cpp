@@ -28,6 +28,7 @@
 #include "Host/GmicQtHost.h"
 #include "IconLoader.h"
 #include "SourcesWidget.h"
+#include "gmic.h"
 
 #include <QDir>
 #include <QLocale>
@@ -58,6 +59,9 @@ int Settings::_previewTimeout = 16;
 OutputMessageMode Settings::_outputMessageMode;
 bool Settings::_previewZoomAlwaysEnabled = false;
 bool Settings::_notifyFailedStartupUpdate = true;
+int Settings::_outOfCoreThreshold = 0;
+QString Settings::_outOfCorePath;
+bool Settings::_compactImageStorage = false;
 bool Settings::_highDPI = false;
 QStringList Settings::_filterSources;
 SourcesWidget::OfficialFilters Settings::_officialFilterSource;
@@ -99,6 +103,10 @@ void Settings::load(UserInterfaceMode userInterfaceMode)
   _notifyFailedStartupUpdate = settings.value("Config/NotifyIfStartupUpdateFails", true).toBool();
   _highDPI = settings.value(HIGHDPI_KEY, false).toBool();
   _filterSources = settings.value("Config/FilterSources", SourcesWidget::defaultList()).toStringList();
+  _outOfCoreThreshold = settings.value(OUT_OF_CORE_THRESHOLD_KEY, 0).toInt();
+  _outOfCorePath = settings.value(OUT_OF_CORE_PATH_KEY, QString()).toString();
+  applyOutOfCoreStorage();
+  _compactImageStorage = settings.value(COMPACT_IMAGE_STORAGE_KEY, false).toBool();
 
   QString officialFilterSource = settings.value(OFFICIAL_FILTER_SOURCE_KEY, QString("EnabledWithUpdates")).toString();
   if (officialFilterSource == QString("Disable")) {
@@ -277,6 +285,46 @@ void Settings::setOfficialFilterSource(SourcesWidget::OfficialFilters status)
   _officialFilterSource = status;
 }
 
+int Settings::outOfCoreThreshold()
+{
+  return _outOfCoreThreshold;
+}
+
+void Settings::setOutOfCoreThreshold(int megabytes)
+{
+  _outOfCoreThreshold = megabytes;
+  applyOutOfCoreStorage();
+}
+
+const QString & Settings::outOfCorePath()
+{
+  return _outOfCorePath;
+}
+
+void Settings::setOutOfCorePath(const QString & path)
+{
+  _outOfCorePath = path;
+  applyOutOfCoreStorage();
+}
+
+bool Settings::compactImageStorage()
+{
+  return _compactImageStorage;
+}
+
+void Settings::setCompactImageStorage(bool on)
+{
+  _compactImageStorage = on;
+}
+
+void Settings::applyOutOfCoreStorage()
+{
+  // Image buffers of at least the threshold size (0 = disabled) are stored in memory-mapped temporary files
+  const QByteArray path = QDir::toNativeSeparators(_outOfCorePath).toLocal8Bit();
+  const cimg_ulong threshold = static_cast<cimg_ulong>(std::max(0, _outOfCoreThreshold)) * 1024 * 1024;
+  gmic_library::cimg::mmap_mode(threshold, path.isEmpty() ? nullptr : path.constData());
+}
+
 void Settings::save(QSettings & settings)
 {
   removeObsoleteKeys(settings);
@@ -296,6 +344,9 @@ void Settings::save(QSettings & settings)
   settings.setValue("Config/NotifyIfStartupUpdateFails", _notifyFailedStartupUpdate);
   settings.setValue(HIGHDPI_KEY, _highDPI);
   settings.setValue("Config/FilterSources", _filterSources);
+  settings.setValue(OUT_OF_CORE_THRESHOLD_KEY, _outOfCoreThreshold);
+  settings.setValue(OUT_OF_CORE_PATH_KEY, _outOfCorePath);
+  settings.setValue(COMPACT_IMAGE_STORAGE_KEY, _compactImageStorage);
 
   switch (_officialFilterSource) {
   case SourcesWidget::OfficialFilters::Disabled:
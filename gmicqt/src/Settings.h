@@ -72,6 +72,12 @@ public:
   static void setFilterSources(const QStringList &);
   static SourcesWidget::OfficialFilters officialFilterSource();
   static void setOfficialFilterSource(SourcesWidget::OfficialFilters);
+  static int outOfCoreThreshold();
+  static void setOutOfCoreThreshold(int megabytes);
+  static const QString & outOfCorePath();
+  static void setOutOfCorePath(const QString &);
+  static bool compactImageStorage();
+  static void setCompactImageStorage(bool);
 
   static void save(QSettings &);
   static void load(UserInterfaceMode userInterfaceMode);
@@ -89,6 +95,7 @@ public:
 
 private:
   static void removeObsoleteKeys(QSettings &);
+  static void applyOutOfCoreStorage();
   static bool _visibleLogos;
   static bool _darkThemeEnabled;
   static QString _languageCode;
@@ -104,6 +111,9 @@ private:
   static bool _highDPI;
   static QStringList _filterSources;
   static SourcesWidget::OfficialFilters _officialFilterSource;
+  static int _outOfCoreThreshold;
+  static QString _outOfCorePath;
+  static bool _compactImageStorage;
 };
 
 } // namespace GmicQt
@@ -27,11 +27,13 @@
 #include <QDebug>
 #include <QFile>
 #include <QFileInfo>
+#include <QMutexLocker>
 #include <QNetworkRequest>
 #include <QTextStream>
 #include <QUrl>
 #include <iostream>
 #include "Common.h"
+#include "Globals.h"
 #include "GmicStdlib.h"
 #include "Logger.h"
 #include "Misc.h"
@@ -151,6 +153,7 @@ void Updater::processReply(QNetworkReply * reply)
     _errorMessages << QString(tr("Error writing file %1")).arg(filename);
     return;
   }
+  invalidateFullStdlib();
   _someNetworkUpdatesAchieved = true;
 }
 
@@ -284,7 +287,6 @@ void Updater::prependOfficialSourceIfRelevant(QStringList & list)
 QByteArray Updater::buildFullStdlib() const
 {
   QByteArray result;
-  const QByteArray ToTopLevelSeparator = QString("#@gui %1\n").arg(QString("_").repeated(80)).toUtf8();
 
   QStringList sources = GmicStdLib::substituteSourceVariables(Settings::filterSources());
 
@@ -314,6 +316,48 @@ QByteArray Updater::buildFullStdlib() const
   return result;
 }
 
+QByteArray Updater::fullStdlib()
+{
+  QMutexLocker locker(&_fullStdlibMutex);
+  const QString signature = fullStdlibSignature();
+  if (_fullStdlibSignature.isEmpty() || (signature != _fullStdlibSignature)) {
+    TIMING;
+    _fullStdlib = buildFullStdlib();
+    _fullStdlibSignature = signature;
+    TIMING;
+  }
+  return _fullStdlib;
+}
+
+QString Updater::fullStdlibSignature() const
+{
+  QStringList filenames;
+  if (Settings::officialFilterSource() == SourcesWidget::OfficialFilters::EnabledWithUpdates) {
+    filenames << localFilename(QString::fromUtf8(OfficialFilterSourceURL));
+  }
+  const QStringList sources = GmicStdLib::substituteSourceVariables(Settings::filterSources());
+  for (const QString & source : sources) {
+    filenames << localFilename(source);
+  }
+  QString signature = QString::number(static_cast<int>(Settings::officialFilterSource()));
+  for (const QString & filename : filenames) {
+    QFileInfo info(filename);
+    if (info.exists()) {
+      signature += QString("\n%1 %2 %3").arg(filename).arg(info.size()).arg(info.lastModified().toMSecsSinceEpoch());
+    } else {
+      signature += QString("\n%1").arg(filename);
+    }
+  }
+  return signature;
+}
+
+void Updater::invalidateFullStdlib()
+{
+  QMutexLocker locker(&_fullStdlibMutex);
+  _fullStdlibSignature.clear();
+  _fullStdlib.clear();
+}
+
 bool Updater::someNetworkUpdateAchieved() const
 {
   return _someNetworkUpdatesAchieved;
@@ -32,6 +32,7 @@
 #include <QFileInfo>
 #include <QList>
 #include <QMap>
+#include <QMutex>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
 #include <QObject>
@@ -75,6 +76,14 @@ public:
   bool allDownloadsOk() const;
   QByteArray buildFullStdlib() const;
 
+  /**
+   * @brief Memoized version of buildFullStdlib(). The returned array is
+   *        implicitly shared with the cached one, and is rebuilt only when
+   *        the filter sources settings or the size/date of a source file
+   *        have changed.
+   */
+  QByteArray fullStdlib();
+
   bool someNetworkUpdateAchieved() const;
 
 signals:
@@ -94,6 +103,8 @@ private:
   void appendBuiltinGmicStdlib(QByteArray & array) const;
   bool appendLocalGmicFile(QByteArray & array, QString filename) const;
   void prependOfficialSourceIfRelevant(QStringList & list);
+  QString fullStdlibSignature() const;
+  void invalidateFullStdlib();
   explicit Updater(QObject * parent);
   static bool isCImgCompressed(const QByteArray & data);
   static QByteArray cimgzDecompress(const QByteArray & array);
@@ -106,6 +117,9 @@ private:
   QSet<QNetworkReply *> _pendingReplies;
   QList<QString> _errorMessages;
   bool _someNetworkUpdatesAchieved;
+  QMutex _fullStdlibMutex;
+  QString _fullStdlibSignature;
+  QByteArray _fullStdlib;
 };
 
 } // namespace GmicQt
@@ -53,6 +53,7 @@ PreviewWidget::PreviewWidget(QWidget * parent) : QWidget(parent)
   _image->assign();
   _savedPreview = new gmic_library::gmic_image<float>;
   _savedPreview->assign();
+  _compactSavedPreview = new gmic_library::gmic_image<unsigned short>;
   _transparency.load(":resources/transparency.png");
 
   _visibleRect = PreviewRect::Full;
@@ -68,6 +69,7 @@ PreviewWidget::PreviewWidget(QWidget * parent) : QWidget(parent)
   qApp->installEventFilter(this);
   _rightClickEnabled = false;
   _originalImageSize = QSize(-1, -1);
+  _originalPixmapSerial = 0;
   _movedKeypointOrigin = QPoint(-1, -1);
   _movedKeypointIndex = -1;
   _previewType = PreviewType::Full;
@@ -83,6 +85,7 @@ PreviewWidget::~PreviewWidget()
   QSettings().setValue(PREVIEW_SPLITTER_KEY, static_cast<int>(_savedPreviewType));
   delete _image;
   delete _savedPreview;
+  delete _compactSavedPreview;
 }
 
 const gmic_library::gmic_image<float> & PreviewWidget::image() const
@@ -96,7 +99,14 @@ void PreviewWidget::setPreviewImage(const gmic_library::gmic_image<float> & imag
   _errorImage = QImage();
   _overlayMessage.clear();
   *_image = image;
-  *_savedPreview = image;
+  _previewPixmap = QPixmap();
+  if (Settings::compactImageStorage()) {
+    compactImage(image, *_compactSavedPreview);
+    _savedPreview->assign();
+  } else {
+    *_savedPreview = image;
+    _compactSavedPreview->assign();
+  }
   _savedPreviewIsValid = true;
   updateOriginalImagePosition();
   _paintOriginalImage = false;
@@ -252,18 +262,17 @@ void PreviewWidget::updateErrorImage()
 {
   gmic_library::gmic_list<float> images;
   gmic_library::gmic_list<char> imageNames;
-  images.assign();
   imageNames.assign();
-  gmic_image<float> image;
-  getOriginalImageCrop(image);
-  image.move_to(images);
+  images.assign(1);
+  images[0] = *originalImageCrop();
   QString fullCommandLine = commandFromOutputMessageMode(Settings::outputMessageMode());
   fullCommandLine += QString(" _host=%1 _tk=qt").arg(GmicQtHost::ApplicationShortname);
   fullCommandLine += QString(" _preview_area_width=%1").arg(width());
   fullCommandLine += QString(" _preview_area_height=%1").arg(height());
   fullCommandLine += QString(" gui_error_preview \"%2\"").arg(_errorMessage);
   try {
-    gmic(fullCommandLine.toLocal8Bit().constData(), images, imageNames, GmicStdLib::Array.constData(), true);
+    const QByteArray stdlib = GmicStdLib::current();
+    gmic(fullCommandLine.toLocal8Bit().constData(), images, imageNames, stdlib.constData(), true);
   } catch (...) {
     images.assign();
     imageNames.assign();
@@ -428,27 +437,52 @@ void PreviewWidget::paintPreview(QPainter & painter)
   if (hasAlphaChannel(*_image)) {
     painter.fillRect(_imagePosition, QBrush(_transparency));
   }
-  QImage qimage;
-  convertGmicImageToQImage(_image->get_resize(_imagePosition.width(), _imagePosition.height(), 1, -100, 1), qimage);
-  painter.drawImage(_imagePosition, qimage);
+  painter.drawPixmap(_imagePosition, previewPixmap());
   paintKeypoints(painter);
 }
 
+const QPixmap & PreviewWidget::previewPixmap()
+{
+  if (_previewPixmap.isNull() || (_previewPixmap.size() != _imagePosition.size())) {
+    QImage qimage;
+    if ((_image->width() == _imagePosition.width()) && (_image->height() == _imagePosition.height())) {
+      convertGmicImageToQImage(*_image, qimage);
+    } else {
+      convertGmicImageToQImage(_image->get_resize(_imagePosition.width(), _imagePosition.height(), 1, -100, 1), qimage);
+    }
+    _previewPixmap = QPixmap::fromImage(qimage);
+  }
+  return _previewPixmap;
+}
+
 void PreviewWidget::paintOriginalImage(QPainter & painter)
 {
-  gmic_image<float> image;
-  getOriginalImageCrop(image);
   updateOriginalImagePosition();
-  if (!image.width() && !image.height()) {
+  if (!_originalPixmap.isNull() && (_originalPixmap.size() == _imagePosition.size()) && (_originalPixmapSerial == CroppedActiveLayerProxy::serial())) {
+    if (_originalPixmap.hasAlphaChannel()) {
+      painter.fillRect(_imagePosition, QBrush(_transparency));
+    }
+    painter.drawPixmap(_imagePosition, _originalPixmap);
+    paintKeypoints(painter);
+    return;
+  }
+  const std::shared_ptr<const gmic_image<float>> image = originalImageCrop();
+  if (!image->width() && !image->height()) {
+    _originalPixmap = QPixmap();
     painter.fillRect(rect(), QBrush(_transparency));
   } else {
-    image.resize(_imagePosition.width(), _imagePosition.height(), 1, -100, 1);
-    if (hasAlphaChannel(image)) {
+    if (hasAlphaChannel(*image)) {
       painter.fillRect(_imagePosition, QBrush(_transparency));
     }
     QImage qimage;
-    convertGmicImageToQImage(image, qimage);
-    painter.drawImage(_imagePosition, qimage);
+    if ((image->width() == _imagePosition.width()) && (image->height() == _imagePosition.height())) {
+      convertGmicImageToQImage(*image, qimage);
+    } else {
+      convertGmicImageToQImage(image->get_resize(_imagePosition.width(), _imagePosition.height(), 1, -100, 1), qimage);
+    }
+    _originalPixmap = QPixmap::fromImage(qimage);
+    _originalPixmapSerial = CroppedActiveLayerProxy::serial();
+    painter.drawPixmap(_imagePosition, _originalPixmap);
     paintKeypoints(painter);
   }
 }
@@ -1161,9 +1195,9 @@ QSize PreviewWidget::originalImageCropSize()
   return CroppedActiveLayerProxy::getSize(_visibleRect.x, _visibleRect.y, _visibleRect.w, _visibleRect.h);
 }
 
-void PreviewWidget::getOriginalImageCrop(gmic_library::gmic_image<float> & image)
+std::shared_ptr<const gmic_library::gmic_image<float>> PreviewWidget::originalImageCrop()
 {
-  CroppedActiveLayerProxy::get(image, _visibleRect.x, _visibleRect.y, _visibleRect.w, _visibleRect.h);
+  return CroppedActiveLayerProxy::get(_visibleRect.x, _visibleRect.y, _visibleRect.w, _visibleRect.h);
 }
 
 void PreviewWidget::onPreviewParametersChanged()
@@ -1254,7 +1288,12 @@ void PreviewWidget::invalidateSavedPreview()
 
 void PreviewWidget::restorePreview()
 {
-  *_image = *_savedPreview;
+  if (!_compactSavedPreview->is_empty()) {
+    expandImage(*_compactSavedPreview, *_image);
+  } else {
+    *_image = *_savedPreview;
+  }
+  _previewPixmap = QPixmap();
 }
 
 void PreviewWidget::enableRightClick()
@@ -34,6 +34,7 @@
 #include <QRectF>
 #include <QSize>
 #include <QWidget>
+#include <memory>
 #include "Host/GmicQtHost.h"
 #include "KeypointList.h"
 #include "ZoomConstraint.h"
@@ -158,12 +159,13 @@ private:
   void paintPreview(QPainter &);
   void paintOriginalImage(QPainter &);
   void paintSplittedPreview(QPainter &);
-  void getOriginalImageCrop(gmic_library::gmic_image<float> & image);
+  std::shared_ptr<const gmic_library::gmic_image<float>> originalImageCrop();
   void updateOriginalImagePosition();
   void updatePreviewImagePosition();
   QRect splittedPreviewPosition();
   void updateErrorImage();
   void paintPreviewSplitter(QPainter & painter);
+  const QPixmap & previewPixmap();
 
   void paintKeypoints(QPainter & painter);
   int keypointUnderMouse(const QPoint & p);
@@ -184,6 +186,7 @@ private:
   void saveVisibleCenter();
   gmic_library::gmic_image<float> * _image;
   gmic_library::gmic_image<float> * _savedPreview;
+  gmic_library::gmic_image<unsigned short> * _compactSavedPreview; // Used instead if Settings::compactImageStorage()
   QSize _fullImageSize;
   double _currentZoomFactor;
   ZoomConstraint _zoomConstraint;
@@ -240,6 +243,11 @@ private:
   QString _errorMessage;
   QString _overlayMessage;
   QImage _errorImage;
+
+  // Display-ready copies of the preview and of the original crop, scaled to _imagePosition
+  QPixmap _previewPixmap;
+  QPixmap _originalPixmap;
+  quint64 _originalPixmapSerial; // CroppedActiveLayerProxy::serial() of _originalPixmap
   KeypointList _keypoints;
   int _movedKeypointIndex;
   QPoint _movedKeypointOrigin;
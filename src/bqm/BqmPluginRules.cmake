@@ -12,6 +12,7 @@ set(gmic_bqm_SRCS
     ${CMAKE_SOURCE_DIR}/src/bqm/gmicfilternode.cpp
     ${CMAKE_SOURCE_DIR}/src/bqm/gmicfilternode_reader.cpp
     ${CMAKE_SOURCE_DIR}/src/bqm/gmicfilternode_writer.cpp
+    ${CMAKE_SOURCE_DIR}/src/bqm/gmicfilterstore.cpp
     ${CMAKE_SOURCE_DIR}/src/bqm/gmicfiltermngr.cpp
     ${CMAKE_SOURCE_DIR}/src/bqm/gmicfiltermngr_stack.cpp
     ${CMAKE_SOURCE_DIR}/src/bqm/gmicfiltermngr_proxy.cpp
@@ -19,6 +20,10 @@ set(gmic_bqm_SRCS
     ${CMAKE_SOURCE_DIR}/src/bqm/gmicfilterwidget.cpp
     ${CMAKE_SOURCE_DIR}/src/bqm/gmicfilterdialog.cpp
     ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmprocessor.cpp
+    ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmscheduler.cpp
+    ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmresultcache.cpp
+    ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmworker.cpp
+    ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmworkerpool.cpp
     ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmtool.cpp
     ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmplugin.cpp
     ${CMAKE_SOURCE_DIR}/src/bqm/gmicfilterchain.cpp
@@ -40,6 +45,13 @@ add_library(Bqm_Gmic_Plugin
 
 set_target_properties(Bqm_Gmic_Plugin PROPERTIES PREFIX "")
 
+# The plugin looks for the G'MIC worker in the install directory.
+
+target_compile_definitions(Bqm_Gmic_Plugin
+                           PRIVATE
+                           GMIC_BQM_WORKER_DIR="${CMAKE_INSTALL_FULL_LIBEXECDIR}"
+)
+
 set_target_properties(Bqm_Gmic_Plugin
                       PROPERTIES
                       CXX_STANDARD 17
@@ -62,6 +74,49 @@ target_link_libraries(Bqm_Gmic_Plugin
 install(TARGETS Bqm_Gmic_Plugin
         DESTINATION ${QT_PLUGINS_DIR}/digikam/bqm)
 
+# --- G'MIC worker process, built from the G'MIC sources only.
+
+set(gmic_worker_SRCS
+    ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmworker_main.cpp
+)
+
+foreach(_file ${gmic_worker_SRCS})
+    set_property(SOURCE ${_file} PROPERTY COMPILE_DEFINITIONS ${modern_qt_definitions})
+endforeach()
+
+# Without dynamic linking, the G'MIC library is only compiled in the gmic-qt sources.
+
+if(NOT ENABLE_DYNAMIC_LINKING)
+
+    set(gmic_worker_SRCS
+        ${gmic_worker_SRCS}
+        ${GMIC_PATH}/gmic.cpp
+    )
+
+endif()
+
+add_executable(digikam_gmic_worker
+               ${gmic_worker_SRCS}
+)
+
+set_target_properties(digikam_gmic_worker
+                      PROPERTIES
+                      CXX_STANDARD 17
+                      CXX_STANDARD_REQUIRED YES
+                      CXX_EXTENSIONS NO
+)
+
+target_link_libraries(digikam_gmic_worker
+                      PRIVATE
+
+                      Qt${QT_VERSION_MAJOR}::Core
+
+                      ${gmic_qt_LIBRARIES}
+)
+
+install(TARGETS digikam_gmic_worker
+        DESTINATION ${CMAKE_INSTALL_LIBEXECDIR})
+
 # Install debug symbols
 
 if(MSVC)
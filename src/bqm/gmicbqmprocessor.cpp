@@ -27,6 +27,9 @@
 #include "Updater.h"
 #include "GmicQt.h"
 #include "gmicqtimageconverter.h"
+#include "gmicbqmresultcache.h"
+#include "gmicbqmworker.h"
+#include "gmicbqmworkerpool.h"
 
 using namespace DigikamGmicQtPluginCommon;
 using namespace GmicQt;
@@ -43,27 +46,44 @@ public:
 public:
 
     FilterThread*                   filterThread = nullptr;
+    GmicBqmWorker*                  worker       = nullptr;
+    bool                            useWorkers   = false;
+    bool                            cancelled    = false;
     gmic_library::gmic_list<float>* gmicImages   = new gmic_library::gmic_list<gmic_pixel_type>;
 
     QTimer                          timer;
     QString                         filterName;
 
     QString                         command;
+    QString                         stageCommand;           ///< The command of the running stage.
     bool                            completed    = false;
+    int                             threads      = 0;
+
+    gmic_library::gmic_list<char>   imageNames;
+    QStringList                     stages;
+    int                             stage        = 0;       ///< Number of stages already applied.
+    bool                            useCache     = false;
+    QByteArray                      imageKey;
 
     DImg                            inImage;
-    DImg                            outImage;
+    gmic_library::gmic_list<float>  outImages;
 };
 
 GmicBqmProcessor::GmicBqmProcessor(QObject* const parent)
     : QObject(parent),
       d      (new Private)
 {
-    GmicStdLib::Array = Updater::getInstance()->buildFullStdlib();
+    // The full stdlib is memoized process-wide, so that the data published is only new when it was rebuilt.
+    // Processors are created concurrently by the Batch Queue Manager threads, which read it through
+    // GmicStdLib::current().
+
+    GmicStdLib::setCurrent(Updater::getInstance()->fullStdlib());
 }
 
 GmicBqmProcessor::~GmicBqmProcessor()
 {
+    GmicBqmWorkerPool::discard(d->worker);
+
     delete d->gmicImages;
     delete d;
 }
@@ -73,6 +93,11 @@ void GmicBqmProcessor::setInputImage(const DImg& inImage)
     d->inImage = inImage;
 }
 
+void GmicBqmProcessor::setThreadCount(int threads)
+{
+    d->threads = threads;
+}
+
 bool GmicBqmProcessor::setProcessingCommand(const QString& command)
 {
     if (command.isEmpty())
@@ -90,78 +115,242 @@ bool GmicBqmProcessor::setProcessingCommand(const QString& command)
     return true;
 }
 
+void GmicBqmProcessor::setChainStages(const QStringList& stages)
+{
+    d->stages = stages;
+}
+
+void GmicBqmProcessor::setUseWorkers(bool useWorkers)
+{
+    d->useWorkers = useWorkers;
+}
+
 void GmicBqmProcessor::startProcessing()
 {
-    gmic_list<char> imageNames;
+    d->completed = false;
+    d->cancelled = false;
+    d->stage     = 0;
+    d->useCache  = (!d->stages.isEmpty()                 &&
+                    GmicBqmResultCache::isEnabled()       &&
+                    GmicBqmResultCache::isCacheable(d->stages));
 
     d->gmicImages->assign(1);
-    imageNames.assign(1);
+    d->imageNames.assign(1);
 
     QString name  = QString::fromUtf8("pos(0,0),name(%1)").arg(QLatin1String("Batch Queue Manager"));
     QByteArray ba = name.toUtf8();
-    gmic_image<char>::string(ba.constData()).move_to(imageNames[0]);
+    gmic_image<char>::string(ba.constData()).move_to(d->imageNames[0]);
 
     qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "Processing image size"
                                      << d->inImage.size();
 
-    GMicQtImageConverter::convertDImgtoCImg(
-                                            d->inImage.copy(
-                                                            0, 0,
-                                                            d->inImage.width(),
-                                                            d->inImage.height()
-                                                           ),
-                                            *d->gmicImages[0]
-                                           );
+    if (d->useCache)
+    {
+        // Resume from the longest prefix of the chain already computed for this image.
+
+        d->imageKey = GmicBqmResultCache::imageKey(d->inImage);
+
+        for (int count = d->stages.size() ; count > 0 ; --count)
+        {
+            if (GmicBqmResultCache::load(GmicBqmResultCache::stageKey(d->imageKey, d->stages, count), *d->gmicImages))
+            {
+                d->stage = count;
+                break;
+            }
+        }
+
+        qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC: resuming after" << d->stage
+                                         << "cached stages of" << d->stages.size();
+
+        if (d->stage == d->stages.size())
+        {
+            d->gmicImages->swap(d->outImages);
+            d->completed = true;
+
+            // Emitted once the caller is listening, as with a filter thread.
+
+            QMetaObject::invokeMethod(this, "signalDone", Qt::QueuedConnection,
+                                      Q_ARG(QString, QString()));
+
+            return;
+        }
+    }
+
+    if (d->stage == 0)
+    {
+        // Converted from the scanlines of the input image, without intermediate copy.
+
+        GMicQtImageConverter::convertDImgtoCImg(d->inImage, (*d->gmicImages)[0]);
+    }
+
+    d->timer.setInterval(250);
+
+    connect(&d->timer, &QTimer::timeout,
+            this, &GmicBqmProcessor::slotSendProgressInformation);
+
+    d->timer.start();
+
+    startStage(d->useCache ? d->stages[d->stage] : d->command);
+}
 
-    qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << QString::fromUtf8("G'MIC: %1").arg(d->command);
+void GmicBqmProcessor::startStage(const QString& command, bool useWorker)
+{
+    d->stageCommand = command;
+
+    qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << QString::fromUtf8("G'MIC: %1").arg(command);
 
     QString env = QString::fromLatin1("_input_layers=%1").arg((int)DefaultInputMode);
     env        += QString::fromLatin1(" _output_mode=%1").arg((int)DefaultOutputMode);
     env        += QString::fromLatin1(" _output_messages=%1").arg((int)OutputMessageMode::VerboseConsole);
 
+    if (d->threads > 0)
+    {
+        // Sets the number of threads of the interpreter in the filter thread only.
+
+        env    += QString::fromLatin1(" _cpus=%1").arg(d->threads);
+    }
+
+    if (d->useWorkers && useWorker)
+    {
+        d->worker = GmicBqmWorkerPool::acquire();
+
+        if (d->worker)
+        {
+            // Queued, as the worker is released or deleted once finished.
+
+            connect(d->worker, SIGNAL(signalFinished()),
+                    this, SLOT(slotWorkerFinished()),
+                    Qt::QueuedConnection);
+
+            if (d->worker->run(command, env, *d->gmicImages))
+            {
+                return;
+            }
+
+            if (d->worker->tooLarge())
+            {
+                qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC: images too large for a worker, processing in the digiKam process.";
+
+                GmicBqmWorkerPool::release(d->worker);
+            }
+            else
+            {
+                qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "Cannot run G'MIC worker:" << d->worker->errorMessage();
+
+                GmicBqmWorkerPool::discard(d->worker);
+            }
+
+            d->worker = nullptr;
+        }
+        else
+        {
+            qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC worker not available, processing in the digiKam process.";
+        }
+    }
+
     d->filterThread = new FilterThread(this,
                                        QLatin1String("skip 0"),
-                                       d->command,
+                                       command,
                                        env);
 
     d->filterThread->swapImages(*d->gmicImages);
-    d->filterThread->setImageNames(imageNames);
-
-    d->completed = false;
+    d->filterThread->setImageNames(d->imageNames);
 
     connect(d->filterThread, &FilterThread::finished,
             this, &GmicBqmProcessor::slotProcessingFinished);
 
-    d->timer.setInterval(250);
-
-    connect(&d->timer, &QTimer::timeout,
-            this, &GmicBqmProcessor::slotSendProgressInformation);
-
-    d->timer.start();
     d->filterThread->start();
 }
 
 void GmicBqmProcessor::slotSendProgressInformation()
 {
-    if (d->filterThread)
+    if (d->filterThread || d->worker)
     {
-        Q_EMIT signalProgress(d->filterThread->progress());
+        float progress = d->filterThread ? d->filterThread->progress()
+                                         : d->worker->progress();
+
+        if (d->useCache && (progress >= 0.0F))
+        {
+            progress = (100.0F * d->stage + progress) / d->stages.size();
+        }
+
+        Q_EMIT signalProgress(progress);
     }
 }
 
 void GmicBqmProcessor::slotProcessingFinished()
 {
-    d->timer.stop();
-    QString errorMessage;
     QStringList status = d->filterThread->gmicStatus();
 
     qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC Filter status" << status;
 
-    if (d->filterThread->failed())
+    const bool failed  = d->filterThread->failed();
+    const bool aborted = d->filterThread->aborted();
+    QString errorMessage;
+
+    if (failed)
+    {
+        errorMessage = d->filterThread->errorMessage();
+    }
+    else if (!aborted)
+    {
+        d->filterThread->swapImages(*d->gmicImages);
+        d->imageNames = d->filterThread->imageNames();
+    }
+
+    d->filterThread->deleteLater();
+    d->filterThread = nullptr;
+
+    stageFinished(failed, aborted, errorMessage);
+}
+
+void GmicBqmProcessor::slotWorkerFinished()
+{
+    // A cancelled worker is killed, and reports a failure.
+
+    const bool aborted = d->cancelled;
+    const bool failed  = (!aborted && d->worker->failed());
+    QString errorMessage;
+
+    if (failed && d->worker->tooLarge())
+    {
+        // The output images do not fit in shared memory: run the stage again in this process.
+
+        qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC: output images too large for a worker, processing in the digiKam process.";
+
+        GmicBqmWorkerPool::release(d->worker);
+        d->worker = nullptr;
+        startStage(d->stageCommand, false);
+
+        return;
+    }
+
+    if (failed || aborted)
+    {
+        errorMessage = d->worker->errorMessage();
+        GmicBqmWorkerPool::discard(d->worker);
+    }
+    else
+    {
+        d->worker->takeImages(*d->gmicImages);
+        GmicBqmWorkerPool::release(d->worker);
+    }
+
+    d->worker = nullptr;
+
+    stageFinished(failed, aborted, failed ? errorMessage : QString());
+}
+
+void GmicBqmProcessor::stageFinished(bool failed, bool aborted, const QString& message)
+{
+    d->timer.stop();
+    QString errorMessage;
+
+    if (failed)
     {
         qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC Filter execution failed!";
 
-        errorMessage = d->filterThread->errorMessage();
+        errorMessage = message;
 
         if (errorMessage.isEmpty())
         {
@@ -173,15 +362,26 @@ void GmicBqmProcessor::slotProcessingFinished()
     }
     else
     {
-        gmic_list<gmic_pixel_type> images = d->filterThread->images();
-
-        if (!d->filterThread->aborted())
+        if (!aborted)
         {
-            GMicQtImageConverter::convertCImgtoDImg(
-                                                    images[0],
-                                                    d->outImage,
-                                                    d->inImage.sixteenBit()
-                                                   );
+            if (d->useCache)
+            {
+                ++d->stage;
+
+                GmicBqmResultCache::store(GmicBqmResultCache::stageKey(d->imageKey, d->stages, d->stage), *d->gmicImages);
+
+                if (d->stage < d->stages.size())
+                {
+                    d->timer.start();
+                    startStage(d->stages[d->stage]);
+
+                    return;
+                }
+            }
+
+            // Converted later into the destination image, see outputImage().
+
+            d->gmicImages->swap(d->outImages);
 
             qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC Filter execution completed!";
 
@@ -194,9 +394,6 @@ void GmicBqmProcessor::slotProcessingFinished()
 
     }
 
-    d->filterThread->deleteLater();
-    d->filterThread = nullptr;
-
     Q_EMIT signalDone(errorMessage);
 }
 
@@ -206,11 +403,22 @@ void GmicBqmProcessor::cancel()
     {
         d->filterThread->abortGmic();
     }
+
+    if (d->worker)
+    {
+        // The worker process belongs to the processing thread.
+
+        d->cancelled = true;
+        QMetaObject::invokeMethod(d->worker, "abort", Qt::QueuedConnection);
+    }
 }
 
-DImg GmicBqmProcessor::outputImage() const
+void GmicBqmProcessor::outputImage(DImg& image) const
 {
-    return d->outImage;
+    if (d->outImages.size())
+    {
+        GMicQtImageConverter::convertCImgtoDImg(d->outImages[0], image, d->inImage.sixteenBit());
+    }
 }
 
 QString GmicBqmProcessor::processingCommand() const
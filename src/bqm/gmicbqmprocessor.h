@@ -18,6 +18,7 @@
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
 
 // digiKam includes
 
@@ -40,10 +41,33 @@ public:
     QString processingCommand()     const;
     QString filterName()            const;
     bool processingComplete()       const;
-    DImg outputImage()              const;
+
+    /**
+     * Write the processed pixels directly into image, keeping its metadata.
+     */
+    void outputImage(DImg& image)   const;
 
     void setInputImage(const DImg& inImage);
+
+    /**
+     * Limit the number of threads used by the G'MIC interpreter (all cores by default).
+     */
+    void setThreadCount(int threads);
     bool setProcessingCommand(const QString& command);
+
+    /**
+     * Commands of the chain stages joined in the processing command. When the result cache
+     * is enabled, the chain runs stage by stage from the longest prefix found in the cache,
+     * and the result of each stage is stored in the cache. Chains which depend on the state of
+     * the interpreter or on random numbers always run as a whole. See GmicBqmResultCache.
+     */
+    void setChainStages(const QStringList& stages);
+
+    /**
+     * Run G'MIC in worker processes instead of the digiKam process, see GmicBqmWorkerPool.
+     * Processing falls back to a filter thread when no worker can be started.
+     */
+    void setUseWorkers(bool useWorkers);
     void startProcessing();
     void cancel();
 
@@ -56,6 +80,15 @@ private Q_SLOTS:
 
     void slotSendProgressInformation();
     void slotProcessingFinished();
+    void slotWorkerFinished();
+
+private:
+
+    /**
+     * Run a command on the current images, in a worker process if enabled and useWorker is set.
+     */
+    void startStage(const QString& command, bool useWorker = true);
+    void stageFinished(bool failed, bool aborted, const QString& message);
 
 private:
 
@@ -0,0 +1,595 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2026-10-17
+ * Description : digiKam Batch Queue Manager plugin for GmicQt.
+ *               On-disk cache of intermediate G'MIC chain results.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+#include "gmicbqmresultcache.h"
+
+// C++ includes
+
+#include <algorithm>
+
+// Qt includes
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QQueue>
+#include <QSet>
+#include <QStandardPaths>
+#include <QThread>
+
+// digiKam includes
+
+#include "digikam_debug.h"
+
+// Local includes
+
+#include "GmicStdlib.h"
+#include "gmic.h"
+
+using namespace GmicQt;
+
+namespace DigikamBqmGmicQtPlugin
+{
+
+namespace
+{
+
+const char* const s_fileSuffix = ".cimgz";
+
+QMutex           s_mutex;
+qint64           s_maxSize      = 0;
+qint64           s_totalSize    = -1;       ///< Size of the cache directory, computed on first eviction.
+QByteArray       s_hashedStdlib;            ///< Shallow copies, their data cannot be reused by another stdlib.
+QByteArray       s_stdlibHash;
+QByteArray       s_analyzedStdlib;
+QSet<QByteArray> s_randomCommands;          ///< Commands of the stdlib which may use random numbers.
+
+bool isNameStart(char c)
+{
+    return (((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z')) || (c == '_'));
+}
+
+bool isNameChar(char c)
+{
+    return (isNameStart(c) || ((c >= '0') && (c <= '9')));
+}
+
+/**
+ * Return the length of the name at the start of 'item', 0 if there is none.
+ */
+int nameLength(const QByteArray& item, int start = 0)
+{
+    if ((start >= item.size()) || !isNameStart(item[start]))
+    {
+        return 0;
+    }
+
+    int end = start + 1;
+
+    while ((end < item.size()) && isNameChar(item[end]))
+    {
+        ++end;
+    }
+
+    return (end - start);
+}
+
+/**
+ * Return true if 'code' calls one of the math functions using random numbers.
+ */
+bool hasRandomMath(const QByteArray& code)
+{
+    for (int i = 0 ; i < code.size() - 1 ; ++i)
+    {
+        if ((i > 0) && isNameChar(code[i - 1]))
+        {
+            continue;
+        }
+
+        if ((((code[i] == 'u') || (code[i] == 'v') || (code[i] == 'g')) && (code[i + 1] == '(')) ||
+            (code.mid(i, 6) == "srand("))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * Split G'MIC code in items, without the quoted strings and the substitutions,
+ * which hold arguments and math expressions rather than commands.
+ */
+QList<QByteArray> codeItems(const QByteArray& code)
+{
+    QByteArray plain;
+    plain.reserve(code.size());
+    int depth   = 0;
+    bool quoted = false;
+
+    for (const char c : code)
+    {
+        if      (c == '"')
+        {
+            quoted = !quoted;
+            plain.append(' ');
+        }
+        else if (!quoted && ((c == '{') || (c == '}')))
+        {
+            depth = qMax(0, depth + ((c == '{') ? 1 : -1));
+            plain.append(' ');
+        }
+        else if (!quoted && (depth == 0))
+        {
+            plain.append(c);
+        }
+    }
+
+    return plain.simplified().split(' ');
+}
+
+/**
+ * Return the name of the command called by a G'MIC item, such as '-blur', '+noise[0]' or 'fx_foo..',
+ * or an empty array if the item cannot be a command.
+ */
+QByteArray commandName(const QByteArray& item)
+{
+    const int start  = ((item.startsWith('-') || item.startsWith('+')) ? 1 : 0);
+    const int length = nameLength(item, start);
+
+    if (length == 0)
+    {
+        return QByteArray();
+    }
+
+    const QByteArray rest = item.mid(start + length);
+
+    if (rest.isEmpty() || (rest == ".") || (rest == "..") || (rest == "...") ||
+        (rest.startsWith('[') && rest.endsWith(']')))
+    {
+        return item.mid(start, length);
+    }
+
+    return QByteArray();
+}
+
+/**
+ * Return true if 'command' is one of the built-in commands using random numbers.
+ */
+bool isRandomBuiltin(const QByteArray& command)
+{
+    return ((command == "noise") || (command == "rand") || (command == "srand") || (command == "patchmatch"));
+}
+
+/**
+ * Return true if a G'MIC item assigns a variable, such as 'a=1', 'a,b=1,2' or 'a+=1'.
+ */
+bool isAssignment(const QByteArray& item)
+{
+    int pos = 0;
+
+    while (true)
+    {
+        const int length = nameLength(item, pos);
+
+        if (length == 0)
+        {
+            return false;
+        }
+
+        pos += length;
+
+        if ((pos < item.size()) && (item[pos] == ','))
+        {
+            ++pos;
+            continue;
+        }
+
+        break;
+    }
+
+    if ((pos < item.size()) && QByteArray("-+*/%&|^<>.").contains(item[pos]))
+    {
+        ++pos;
+    }
+
+    return ((pos < item.size()) && (item[pos] == '='));
+}
+
+/**
+ * With a copy of the first array held, an unchanged data pointer means unchanged contents.
+ */
+bool isSameArray(const QByteArray& held, const QByteArray& array)
+{
+    return ((held.constData() == array.constData()) && (held.size() == array.size()));
+}
+
+/**
+ * Find the commands of the stdlib which may use random numbers: the ones calling a random
+ * built-in command or math function, directly or through other commands of the stdlib.
+ * Must be called with s_mutex locked.
+ */
+void analyzeStdlib()
+{
+    const QByteArray stdlib = GmicStdLib::current();
+
+    if (isSameArray(s_analyzedStdlib, stdlib))
+    {
+        return;
+    }
+
+    s_analyzedStdlib = stdlib;
+    s_randomCommands.clear();
+
+    QHash<QByteArray, QByteArray> bodies;
+    QByteArray current;
+    const QList<QByteArray> lines = stdlib.split('\n');
+
+    for (const QByteArray& line : lines)
+    {
+        if (line.startsWith('#'))
+        {
+            continue;
+        }
+
+        // A definition starts with the name of the command followed by ':', at the beginning of a line.
+
+        const int length = nameLength(line);
+        const int colon  = line.indexOf(':', length);
+
+        if ((length > 0) && (colon > 0) && line.mid(length, colon - length).trimmed().isEmpty())
+        {
+            current = line.left(length);
+            bodies[current].append(line.mid(colon + 1));
+        }
+        else if (!current.isEmpty())
+        {
+            bodies[current].append('\n').append(line);
+        }
+    }
+
+    QHash<QByteArray, QList<QByteArray> > callers;
+    QQueue<QByteArray>                    queue;
+
+    for (auto it = bodies.constBegin() ; it != bodies.constEnd() ; ++it)
+    {
+        bool random                   = hasRandomMath(it.value());
+        const QList<QByteArray> items = codeItems(it.value());
+
+        for (const QByteArray& item : items)
+        {
+            const QByteArray name = commandName(item);
+
+            if (isRandomBuiltin(name))
+            {
+                random = true;
+            }
+            else if (!name.isEmpty() && (name != it.key()) && bodies.contains(name))
+            {
+                callers[name] << it.key();
+            }
+        }
+
+        if (random)
+        {
+            s_randomCommands.insert(it.key());
+            queue.enqueue(it.key());
+        }
+    }
+
+    while (!queue.isEmpty())
+    {
+        const QList<QByteArray> list = callers.value(queue.dequeue());
+
+        for (const QByteArray& caller : list)
+        {
+            if (!s_randomCommands.contains(caller))
+            {
+                s_randomCommands.insert(caller);
+                queue.enqueue(caller);
+            }
+        }
+    }
+
+    qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC result cache:" << s_randomCommands.size() << "of"
+                                     << bodies.size() << "stdlib commands may use random numbers";
+}
+
+QString cacheFilePath(const QByteArray& key)
+{
+    return (GmicBqmResultCache::cacheDirectory() + QLatin1Char('/') +
+            QString::fromLatin1(key.toHex()) + QLatin1String(s_fileSuffix));
+}
+
+QFileInfoList cacheFiles()
+{
+    const QStringList filters(QString::fromLatin1("*") + QLatin1String(s_fileSuffix));
+
+    return QDir(GmicBqmResultCache::cacheDirectory()).entryInfoList(filters, QDir::Files);
+}
+
+/**
+ * The stdlib is memoized process-wide: only hash it again when it was rebuilt.
+ */
+QByteArray stdlibHash()
+{
+    QMutexLocker locker(&s_mutex);
+
+    const QByteArray stdlib = GmicStdLib::current();
+
+    if (s_stdlibHash.isEmpty() || !isSameArray(s_hashedStdlib, stdlib))
+    {
+        s_hashedStdlib = stdlib;
+        s_stdlibHash   = QCryptographicHash::hash(stdlib, QCryptographicHash::Sha1);
+    }
+
+    return s_stdlibHash;
+}
+
+} // namespace
+
+void GmicBqmResultCache::setMaxSize(int megabytes)
+{
+    QMutexLocker locker(&s_mutex);
+
+    s_maxSize = (qint64)std::max(0, megabytes) * 1024 * 1024;
+}
+
+bool GmicBqmResultCache::isEnabled()
+{
+    QMutexLocker locker(&s_mutex);
+
+    return (s_maxSize > 0);
+}
+
+QString GmicBqmResultCache::cacheDirectory()
+{
+    return (QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+            QLatin1String("/gmicbqmresults"));
+}
+
+QByteArray GmicBqmResultCache::imageKey(const DImg& image)
+{
+    QCryptographicHash hash(QCryptographicHash::Md5);
+
+    const QByteArray geometry = QString::fromLatin1("%1x%2,%3,%4").arg(image.width())
+                                                                   .arg(image.height())
+                                                                   .arg((int)image.sixteenBit())
+                                                                   .arg((int)image.hasAlpha())
+                                                                   .toLatin1();
+    hash.addData(geometry);
+
+    // Hashed by chunks, as the size of an image can exceed the range of an int.
+
+    const qint64 chunk     = 64 * 1024 * 1024;
+    const char* const bits = reinterpret_cast<const char*>(image.bits());
+    const qint64 size      = image.numBytes();
+
+    for (qint64 offset = 0 ; bits && (offset < size) ; offset += chunk)
+    {
+        hash.addData(bits + offset, (int)std::min(chunk, size - offset));
+    }
+
+    return hash.result();
+}
+
+QByteArray GmicBqmResultCache::stageKey(const QByteArray& imageKey, const QStringList& stages, int count)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(imageKey);
+    hash.addData(stdlibHash());
+
+    for (int i = 0 ; i < std::min(count, (int)stages.size()) ; ++i)
+    {
+        // The stage length separates the commands unambiguously.
+
+        hash.addData(QByteArray::number(stages[i].size()));
+        hash.addData(stages[i].toUtf8());
+    }
+
+    return hash.result();
+}
+
+bool GmicBqmResultCache::isCacheable(const QStringList& stages)
+{
+    QMutexLocker locker(&s_mutex);
+
+    analyzeStdlib();
+
+    for (const QString& stage : stages)
+    {
+        const QByteArray code         = stage.toUtf8();
+        const QList<QByteArray> items = codeItems(code);
+
+        if (hasRandomMath(code))
+        {
+            return false;
+        }
+
+        // Variables set at the top level of a stage, and the commands it defines, remain in the interpreter
+        // which runs the joined chain, but not in the one which runs the next stage.
+
+        if ((stages.size() > 1) && code.contains('$'))
+        {
+            return false;
+        }
+
+        for (const QByteArray& item : items)
+        {
+            const QByteArray name = commandName(item);
+
+            if (isRandomBuiltin(name) || s_randomCommands.contains(name))
+            {
+                return false;
+            }
+
+            if ((stages.size() > 1) && (isAssignment(item) || (name == "command") || (name == "m")))
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool GmicBqmResultCache::load(const QByteArray& key, gmic_library::gmic_list<float>& images)
+{
+    const QString path = cacheFilePath(key);
+
+    if (!QFile::exists(path))
+    {
+        return false;
+    }
+
+    try
+    {
+        images.load_cimg(QFile::encodeName(path).constData());
+    }
+    catch (...)
+    {
+        // Truncated or evicted by another job meanwhile.
+
+        qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "Cannot load G'MIC cached result" << path;
+        images.assign();
+
+        return false;
+    }
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 10, 0))
+
+    // The modification time orders the results for the eviction.
+
+    QFile file(path);
+
+    if (file.open(QIODevice::ReadWrite))
+    {
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+
+#endif
+
+    return true;
+}
+
+void GmicBqmResultCache::store(const QByteArray& key, const gmic_library::gmic_list<float>& images)
+{
+    if (!isEnabled() || images.is_empty())
+    {
+        return;
+    }
+
+    if (!QDir().mkpath(cacheDirectory()))
+    {
+        qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "Cannot create G'MIC result cache directory" << cacheDirectory();
+
+        return;
+    }
+
+    // Written under a temporary name, so that concurrent jobs never load a partial file.
+
+    const QString path = cacheFilePath(key);
+    const QString temp = path + QString::fromLatin1(".%1.tmp").arg((quintptr)QThread::currentThreadId());
+
+    try
+    {
+        images.save_cimg(QFile::encodeName(temp).constData(), true);
+    }
+    catch (...)
+    {
+        qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "Cannot store G'MIC result in cache" << path;
+        QFile::remove(temp);
+
+        return;
+    }
+
+    QFile::remove(path);
+
+    if (!QFile::rename(temp, path))
+    {
+        QFile::remove(temp);
+
+        return;
+    }
+
+    const qint64 size = QFileInfo(path).size();
+
+    {
+        QMutexLocker locker(&s_mutex);
+
+        if (s_totalSize >= 0)
+        {
+            s_totalSize += size;
+
+            if (s_totalSize <= s_maxSize)
+            {
+                return;
+            }
+        }
+    }
+
+    evict();
+}
+
+void GmicBqmResultCache::evict()
+{
+    QMutexLocker locker(&s_mutex);
+
+    QFileInfoList files = cacheFiles();
+    s_totalSize         = 0;
+
+    for (const QFileInfo& info : qAsConst(files))
+    {
+        s_totalSize += info.size();
+    }
+
+    if (s_totalSize <= s_maxSize)
+    {
+        return;
+    }
+
+    // Evict down to 90% of the size, so that the directory is not scanned on each store.
+
+    std::sort(files.begin(), files.end(),
+              [](const QFileInfo& a, const QFileInfo& b)
+              {
+                  return (a.lastModified() < b.lastModified());
+              }
+    );
+
+    const qint64 target = s_maxSize - s_maxSize / 10;
+
+    for (const QFileInfo& info : qAsConst(files))
+    {
+        if (s_totalSize <= target)
+        {
+            break;
+        }
+
+        if (QFile::remove(info.absoluteFilePath()))
+        {
+            s_totalSize -= info.size();
+        }
+    }
+
+    qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC result cache evicted down to" << s_totalSize << "bytes";
+}
+
+} // namespace DigikamBqmGmicQtPlugin
@@ -0,0 +1,95 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2026-10-17
+ * Description : digiKam Batch Queue Manager plugin for GmicQt.
+ *               On-disk cache of intermediate G'MIC chain results.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+#pragma once
+
+// Qt includes
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+// digiKam includes
+
+#include "dimg.h"
+
+using namespace Digikam;
+
+namespace gmic_library
+{
+template <typename T> struct gmic_list;
+}
+
+namespace DigikamBqmGmicQtPlugin
+{
+
+/**
+ * Process-wide cache of the images produced after each stage of a filter chain,
+ * stored as compressed CImg files in the user cache directory.
+ * A result is keyed by the hash of the input pixels, the commands of the chain prefix
+ * which produced it, and the hash of the G'MIC stdlib, so that a rerun of a queue
+ * resumes from the longest prefix already computed.
+ * The least recently used results are evicted when the cache exceeds its size.
+ */
+class GmicBqmResultCache
+{
+
+public:
+
+    /**
+     * Set the maximum size of the cache in MB. A null size disables the cache.
+     */
+    static void setMaxSize(int megabytes);
+    static bool isEnabled();
+
+    /**
+     * Return false if a chain must run as a whole, without the cache. The stages of a chain run
+     * in separate interpreters, and a chain resumed from a cached prefix cannot restore the state
+     * left by the skipped stages: chains of several stages which set or substitute variables,
+     * or define commands, are not cached. Chains which may use random numbers are not cached
+     * either, so that each run draws new ones as without cache.
+     * The commands called by the stages are followed through the stdlib definitions, and the
+     * commands of the stdlib are assumed not to pass global variables from one call to another.
+     */
+    static bool isCacheable(const QStringList& stages);
+
+    /**
+     * Hash of the pixels and geometry of an input image.
+     */
+    static QByteArray imageKey(const DImg& image);
+
+    /**
+     * Key of the result of the first count stages of a chain applied to an image.
+     */
+    static QByteArray stageKey(const QByteArray& imageKey, const QStringList& stages, int count);
+
+    /**
+     * Return false if there is no result for the key.
+     */
+    static bool load(const QByteArray& key, gmic_library::gmic_list<float>& images);
+    static void store(const QByteArray& key, const gmic_library::gmic_list<float>& images);
+
+    static QString cacheDirectory();
+
+private:
+
+    static void evict();
+
+    // Disable
+    GmicBqmResultCache()  = delete;
+    ~GmicBqmResultCache() = delete;
+};
+
+} // namespace DigikamBqmGmicQtPlugin
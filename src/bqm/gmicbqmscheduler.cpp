@@ -0,0 +1,123 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2026-10-17
+ * Description : digiKam Batch Queue Manager plugin for GmicQt.
+ *               Admission control of concurrent G'MIC jobs.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+#include "gmicbqmscheduler.h"
+
+// C++ includes
+
+#include <algorithm>
+
+// Qt includes
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QWaitCondition>
+
+namespace DigikamBqmGmicQtPlugin
+{
+
+namespace
+{
+
+/**
+ * Filters usually hold the input, the output and a couple of intermediate
+ * float buffers at the same time.
+ */
+const int s_buffersPerJob = 4;
+
+QMutex         s_mutex;
+QWaitCondition s_jobDone;
+int            s_maxJobs     = 0;
+qint64         s_budget      = 0;
+int            s_runningJobs = 0;
+qint64         s_usedMemory  = 0;
+
+int effectiveMaxJobs()
+{
+    return ((s_maxJobs > 0) ? s_maxJobs : std::max(1, QThread::idealThreadCount()));
+}
+
+} // namespace
+
+void GmicBqmScheduler::setLimits(int maxJobs, int memoryBudgetMB)
+{
+    QMutexLocker locker(&s_mutex);
+
+    s_maxJobs = std::max(0, maxJobs);
+    s_budget  = (qint64)std::max(0, memoryBudgetMB) * 1024 * 1024;
+
+    // Waiting jobs may fit within the new limits.
+
+    s_jobDone.wakeAll();
+}
+
+int GmicBqmScheduler::maxJobs()
+{
+    QMutexLocker locker(&s_mutex);
+
+    return effectiveMaxJobs();
+}
+
+int GmicBqmScheduler::threadsPerJob()
+{
+    const int jobs = maxJobs();
+
+    return std::max(1, QThread::idealThreadCount() / jobs);
+}
+
+qint64 GmicBqmScheduler::estimatedJobMemory(int width, int height, int channels)
+{
+    return ((qint64)width * height * std::max(channels, 1) * sizeof(float) * s_buffersPerJob);
+}
+
+bool GmicBqmScheduler::acquire(qint64 memory, const std::function<bool()>& isCancelled)
+{
+    QMutexLocker locker(&s_mutex);
+
+    while (
+           (s_runningJobs > 0) &&
+           (
+            (s_runningJobs >= effectiveMaxJobs()) ||
+            ((s_budget > 0) && ((s_usedMemory + memory) > s_budget))
+           )
+          )
+    {
+        if (isCancelled && isCancelled())
+        {
+            return false;
+        }
+
+        // Cancellation is not signaled through the condition, hence the timeout.
+
+        s_jobDone.wait(&s_mutex, 100);
+    }
+
+    ++s_runningJobs;
+    s_usedMemory += memory;
+
+    return true;
+}
+
+void GmicBqmScheduler::release(qint64 memory)
+{
+    QMutexLocker locker(&s_mutex);
+
+    --s_runningJobs;
+    s_usedMemory -= memory;
+    s_jobDone.wakeAll();
+}
+
+} // namespace DigikamBqmGmicQtPlugin
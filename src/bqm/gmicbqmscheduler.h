@@ -0,0 +1,74 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2026-10-17
+ * Description : digiKam Batch Queue Manager plugin for GmicQt.
+ *               Admission control of concurrent G'MIC jobs.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+#pragma once
+
+// C++ includes
+
+#include <functional>
+
+// Qt includes
+
+#include <QtGlobal>
+
+namespace DigikamBqmGmicQtPlugin
+{
+
+/**
+ * Process-wide limits shared by all G'MIC BQM tool instances, as the Batch Queue Manager
+ * runs one tool clone per image on its own thread pool.
+ * At most maxJobs() images are processed at once, and a new image only starts when its
+ * estimated memory footprint fits in what is left of the memory budget (an image is always
+ * admitted when nothing else is running, so that very large images are not locked out).
+ */
+class GmicBqmScheduler
+{
+
+public:
+
+    /**
+     * Set the limits. A null maxJobs means one job per core,
+     * a null memory budget (in MB) means no memory limit.
+     */
+    static void setLimits(int maxJobs, int memoryBudgetMB);
+
+    static int maxJobs();
+
+    /**
+     * Number of threads a job should use, so that concurrent jobs share the cores.
+     */
+    static int threadsPerJob();
+
+    /**
+     * Estimated memory footprint of processing an image with G'MIC.
+     */
+    static qint64 estimatedJobMemory(int width, int height, int channels);
+
+    /**
+     * Block until a job using this amount of memory can start, or until isCancelled() returns true.
+     * Return false if the wait was cancelled, in which case release() must not be called.
+     */
+    static bool acquire(qint64 memory, const std::function<bool()>& isCancelled);
+
+    static void release(qint64 memory);
+
+private:
+
+    // Disable
+    GmicBqmScheduler()  = delete;
+    ~GmicBqmScheduler() = delete;
+};
+
+} // namespace DigikamBqmGmicQtPlugin
@@ -29,6 +29,8 @@
 
 #include "gmicfilterwidget.h"
 #include "gmicbqmprocessor.h"
+#include "gmicbqmscheduler.h"
+#include "gmicbqmresultcache.h"
 #include "gmicqtcommon.h"
 #include "GmicQt.h"
 
@@ -83,8 +85,13 @@ BatchToolSettings GmicBqmTool::defaultSettings()
 {
     BatchToolSettings settings;
 
-    settings.insert(QLatin1String("GmicBqmToolCommand"), QString());
-    settings.insert(QLatin1String("GmicBqmToolPath"),    QString());
+    settings.insert(QLatin1String("GmicBqmToolCommand"),      QString());
+    settings.insert(QLatin1String("GmicBqmToolCommands"),     QStringList());
+    settings.insert(QLatin1String("GmicBqmToolPath"),         QString());
+    settings.insert(QLatin1String("GmicBqmToolMaxJobs"),      0);
+    settings.insert(QLatin1String("GmicBqmToolMemoryBudget"), 4096);
+    settings.insert(QLatin1String("GmicBqmToolResultCache"),  0);
+    settings.insert(QLatin1String("GmicBqmToolWorkers"),      false);
 
     return settings;
 }
@@ -96,6 +103,10 @@ void GmicBqmTool::slotAssignSettings2Widget()
     QString path      = settings().value(QLatin1String("GmicBqmToolPath")).toString();
 
     d->gmicWidget->setCurrentPath(path);
+    d->gmicWidget->setMaxJobs(settings().value(QLatin1String("GmicBqmToolMaxJobs")).toInt());
+    d->gmicWidget->setMemoryBudget(settings().value(QLatin1String("GmicBqmToolMemoryBudget")).toInt());
+    d->gmicWidget->setResultCacheSize(settings().value(QLatin1String("GmicBqmToolResultCache")).toInt());
+    d->gmicWidget->setUseWorkers(settings().value(QLatin1String("GmicBqmToolWorkers")).toBool());
 
     d->changeSettings = true;
 }
@@ -106,8 +117,13 @@ void GmicBqmTool::slotSettingsChanged()
     {
         BatchToolSettings settings;
 
-        settings.insert(QLatin1String("GmicBqmToolCommand"), d->gmicWidget->currentGmicChainedCommands());
-        settings.insert(QLatin1String("GmicBqmToolPath"),    d->gmicWidget->currentPath());
+        settings.insert(QLatin1String("GmicBqmToolCommand"),      d->gmicWidget->currentGmicChainedCommands());
+        settings.insert(QLatin1String("GmicBqmToolCommands"),     d->gmicWidget->currentGmicCommands());
+        settings.insert(QLatin1String("GmicBqmToolPath"),         d->gmicWidget->currentPath());
+        settings.insert(QLatin1String("GmicBqmToolMaxJobs"),      d->gmicWidget->maxJobs());
+        settings.insert(QLatin1String("GmicBqmToolMemoryBudget"), d->gmicWidget->memoryBudget());
+        settings.insert(QLatin1String("GmicBqmToolResultCache"),  d->gmicWidget->resultCacheSize());
+        settings.insert(QLatin1String("GmicBqmToolWorkers"),      d->gmicWidget->useWorkers());
 
         BatchTool::slotSettingsChanged(settings);
     }
@@ -134,13 +150,45 @@ bool GmicBqmTool::toolOperations()
         return false;
     }
 
+    // The Batch Queue Manager runs several images at once on its own threads:
+    // throttle them with the limits shared by all G'MIC tools.
+
+    GmicBqmScheduler::setLimits(settings().value(QLatin1String("GmicBqmToolMaxJobs")).toInt(),
+                                settings().value(QLatin1String("GmicBqmToolMemoryBudget")).toInt());
+
+    const qint64 memory = GmicBqmScheduler::estimatedJobMemory(image().width(),
+                                                               image().height(),
+                                                               image().hasAlpha() ? 4 : 3);
+
+    if (!GmicBqmScheduler::acquire(memory, [this]() { return isCancelled(); }))
+    {
+        qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "GmicBqmTool: cancelled while waiting for a processing slot.";
+
+        return false;
+    }
+
+    // Workflows saved before the chain stages were stored run the whole command as one stage.
+
+    QStringList stages = settings().value(QLatin1String("GmicBqmToolCommands")).toStringList();
+
+    if (stages.isEmpty())
+    {
+        stages << command;
+    }
+
+    GmicBqmResultCache::setMaxSize(settings().value(QLatin1String("GmicBqmToolResultCache")).toInt());
+
     d->gmicProcessor = new GmicBqmProcessor();
     d->gmicProcessor->setInputImage(image());
+    d->gmicProcessor->setThreadCount(GmicBqmScheduler::threadsPerJob());
+    d->gmicProcessor->setChainStages(stages);
+    d->gmicProcessor->setUseWorkers(settings().value(QLatin1String("GmicBqmToolWorkers")).toBool());
 
     if (!d->gmicProcessor->setProcessingCommand(command))
     {
         delete d->gmicProcessor;
         d->gmicProcessor = nullptr;
+        GmicBqmScheduler::release(memory);
         qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "GmicBqmTool: cannot setup G'MIC filter!";
 
         return false;
@@ -157,9 +205,12 @@ bool GmicBqmTool::toolOperations()
 
     loop.exec();
 
-    bool b   = d->gmicProcessor->processingComplete();
-    DImg out = d->gmicProcessor->outputImage();
-    image().putImageData(out.width(), out.height(), out.sixteenBit(), out.hasAlpha(), out.bits());
+    bool b = d->gmicProcessor->processingComplete();
+
+    if (b)
+    {
+        d->gmicProcessor->outputImage(image());
+    }
 
     FilterAction action = s_gmicQtFilterAction(
                                                command,
@@ -182,6 +233,7 @@ bool GmicBqmTool::toolOperations()
 
     delete d->gmicProcessor;
     d->gmicProcessor = nullptr;
+    GmicBqmScheduler::release(memory);
 
     return b;
 }
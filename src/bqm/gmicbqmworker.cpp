@@ -0,0 +1,365 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2026-10-17
+ * Description : digiKam Batch Queue Manager plugin for GmicQt.
+ *               Handle of a G'MIC worker process.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+#include "gmicbqmworker.h"
+
+// C++ includes
+
+#include <atomic>
+
+// Qt includes
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QProcess>
+#include <QSharedMemory>
+
+// digiKam includes
+
+#include "digikam_debug.h"
+
+// Local includes
+
+#include "GmicStdlib.h"
+#include "gmicbqmworkerprotocol.h"
+
+using namespace GmicQt;
+
+namespace DigikamBqmGmicQtPlugin
+{
+
+namespace
+{
+
+std::atomic<int> s_segmentCounter(0);
+
+/**
+ * Segment keys unique across the plugin processes and the jobs.
+ */
+QString segmentKey()
+{
+    return QString::fromLatin1("digikam-gmic-%1-%2").arg(QCoreApplication::applicationPid())
+                                                     .arg(++s_segmentCounter);
+}
+
+} // namespace
+
+class Q_DECL_HIDDEN GmicBqmWorker::Private
+{
+public:
+
+    Private() = default;
+
+public:
+
+    QString                        program;
+    QProcess*                      process   = nullptr;
+    QByteArray                     stdlib;              ///< Shallow copy, keeps the data pointer valid.
+
+    QByteArray                     buffer;              ///< Messages not parsed yet.
+    QSharedMemory                  input;
+    QString                        outputKey;
+    gmic_library::gmic_list<float> images;
+
+    bool                           busy      = false;
+    bool                           failed    = false;
+    bool                           tooLarge  = false;
+    float                          progress  = -1.0F;
+    QString                        errorMessage;
+};
+
+GmicBqmWorker::GmicBqmWorker(const QString& program)
+    : QObject(nullptr),
+      d      (new Private)
+{
+    d->program = program;
+}
+
+GmicBqmWorker::~GmicBqmWorker()
+{
+    if (d->process)
+    {
+        // Closing the pipe lets an idle worker exit by itself.
+
+        d->process->disconnect(this);
+        d->process->closeWriteChannel();
+
+        if (!d->process->waitForFinished(1000))
+        {
+            d->process->kill();
+            d->process->waitForFinished(1000);
+        }
+    }
+
+    delete d;
+}
+
+bool GmicBqmWorker::start()
+{
+    d->process = new QProcess(this);
+    d->process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+
+    connect(d->process, SIGNAL(readyReadStandardOutput()),
+            this, SLOT(slotReadyRead()));
+
+    connect(d->process, SIGNAL(finished(int,QProcess::ExitStatus)),
+            this, SLOT(slotProcessFinished()));
+
+    d->process->start(d->program, QStringList());
+
+    if (!d->process->waitForStarted())
+    {
+        qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "Cannot start G'MIC worker" << d->program
+                                           << d->process->errorString();
+
+        return false;
+    }
+
+    d->stdlib = GmicStdLib::current();
+
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream << d->stdlib;
+    d->process->write(GmicBqmWorkerProtocol::message(GmicBqmWorkerProtocol::StdLib, payload));
+
+    return true;
+}
+
+bool GmicBqmWorker::isRunning() const
+{
+    return (d->process && (d->process->state() == QProcess::Running));
+}
+
+QByteArray GmicBqmWorker::stdlib() const
+{
+    return d->stdlib;
+}
+
+bool GmicBqmWorker::run(const QString& command,
+                        const QString& environment,
+                        const gmic_library::gmic_list<float>& images)
+{
+    d->failed       = false;
+    d->tooLarge     = false;
+    d->progress     = -1.0F;
+    d->errorMessage.clear();
+
+    const qint64 bytes = GmicBqmWorkerProtocol::segmentBytes(images);
+
+    if (bytes > GmicBqmWorkerProtocol::MaxSegmentBytes)
+    {
+        d->tooLarge     = true;
+        d->errorMessage = QLatin1String("Images are too large for a shared memory segment.");
+
+        return false;
+    }
+
+    // The input segment only lives for the run, see finish().
+
+    d->input.setKey(segmentKey());
+
+    if (!d->input.create((int)bytes))
+    {
+        d->errorMessage = d->input.errorString();
+
+        return false;
+    }
+
+    GmicBqmWorkerProtocol::copyToSegment(images, d->input.data());
+
+    d->outputKey = segmentKey();
+
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream << d->input.key() << d->outputKey << environment << command;
+    GmicBqmWorkerProtocol::writeLayout(stream, images);
+
+    d->busy = true;
+    d->process->write(GmicBqmWorkerProtocol::message(GmicBqmWorkerProtocol::Run, payload));
+
+    return true;
+}
+
+void GmicBqmWorker::takeImages(gmic_library::gmic_list<float>& images)
+{
+    images.swap(d->images);
+    d->images.assign();
+}
+
+float GmicBqmWorker::progress() const
+{
+    return d->progress;
+}
+
+bool GmicBqmWorker::failed() const
+{
+    return d->failed;
+}
+
+bool GmicBqmWorker::tooLarge() const
+{
+    return d->tooLarge;
+}
+
+QString GmicBqmWorker::errorMessage() const
+{
+    return d->errorMessage;
+}
+
+void GmicBqmWorker::releaseSegments()
+{
+    if (d->input.isAttached())
+    {
+        d->input.detach();
+    }
+
+    if (isRunning())
+    {
+        // Written now, as an idle worker has no event loop to flush its pipe.
+
+        d->process->write(GmicBqmWorkerProtocol::message(GmicBqmWorkerProtocol::Release, QByteArray()));
+        d->process->waitForBytesWritten(1000);
+    }
+}
+
+void GmicBqmWorker::abort()
+{
+    if (isRunning())
+    {
+        d->process->kill();
+    }
+}
+
+void GmicBqmWorker::slotReadyRead()
+{
+    d->buffer.append(d->process->readAllStandardOutput());
+
+    while (d->buffer.size() >= GmicBqmWorkerProtocol::HeaderSize)
+    {
+        const int size = (int)GmicBqmWorkerProtocol::payloadSize(d->buffer.constData());
+
+        if (d->buffer.size() < (GmicBqmWorkerProtocol::HeaderSize + size))
+        {
+            return;
+        }
+
+        const char type          = d->buffer[0];
+        const QByteArray payload = d->buffer.mid(GmicBqmWorkerProtocol::HeaderSize, size);
+        d->buffer.remove(0, GmicBqmWorkerProtocol::HeaderSize + size);
+        QDataStream stream(payload);
+
+        switch (type)
+        {
+            case GmicBqmWorkerProtocol::Progress:
+            {
+                stream >> d->progress;
+                break;
+            }
+
+            case GmicBqmWorkerProtocol::Error:
+            {
+                QString message;
+                stream >> message;
+                finish(message.isEmpty() ? QLatin1String("G'MIC worker failed without error message.")
+                                         : message);
+                break;
+            }
+
+            case GmicBqmWorkerProtocol::TooLarge:
+            {
+                d->tooLarge = true;
+                finish(QLatin1String("Output images are too large for a shared memory segment."));
+                break;
+            }
+
+            case GmicBqmWorkerProtocol::Done:
+            {
+                QSharedMemory output(d->outputKey);
+                QString error;
+
+                if (!output.attach(QSharedMemory::ReadOnly))
+                {
+                    error = output.errorString();
+                }
+                else
+                {
+                    if (GmicBqmWorkerProtocol::readLayout(stream, d->images, output.size()))
+                    {
+                        GmicBqmWorkerProtocol::copyFromSegment(output.constData(), d->images);
+                    }
+                    else
+                    {
+                        error = QLatin1String("Malformed G'MIC worker reply.");
+                    }
+
+                    output.detach();
+                }
+
+                // The worker can free the output segment, whether it was read or not.
+
+                d->process->write(GmicBqmWorkerProtocol::message(GmicBqmWorkerProtocol::Release, QByteArray()));
+                finish(error);
+
+                break;
+            }
+
+            default:
+            {
+                qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "Unknown G'MIC worker message" << (int)type;
+                break;
+            }
+        }
+    }
+}
+
+void GmicBqmWorker::slotProcessFinished()
+{
+    qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC worker exited with code" << d->process->exitCode();
+
+    if (d->busy)
+    {
+        finish(QLatin1String("G'MIC worker stopped while processing (crashed or cancelled)."));
+    }
+}
+
+void GmicBqmWorker::finish(const QString& errorMessage)
+{
+    if (!d->busy)
+    {
+        return;
+    }
+
+    d->busy         = false;
+    d->failed       = !errorMessage.isEmpty();
+    d->errorMessage = errorMessage;
+
+    // The worker has read the input images, or will not.
+
+    if (d->input.isAttached())
+    {
+        d->input.detach();
+    }
+
+    if (d->failed)
+    {
+        d->images.assign();
+    }
+
+    Q_EMIT signalFinished();
+}
+
+} // namespace DigikamBqmGmicQtPlugin
+
+#include "moc_gmicbqmworker.cpp"
@@ -0,0 +1,112 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2026-10-17
+ * Description : digiKam Batch Queue Manager plugin for GmicQt.
+ *               Handle of a G'MIC worker process.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+#pragma once
+
+// Qt includes
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+
+namespace gmic_library
+{
+template <typename T> struct gmic_list;
+}
+
+namespace DigikamBqmGmicQtPlugin
+{
+
+/**
+ * A helper process running G'MIC commands with the stdlib already parsed,
+ * see gmicbqmworker_main.cpp and GmicBqmWorkerProtocol.
+ * A crash or a runaway allocation in a filter only takes the worker down,
+ * and a run is cancelled by killing the process.
+ */
+class GmicBqmWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    explicit GmicBqmWorker(const QString& program);
+    ~GmicBqmWorker()                                  override;
+
+    /**
+     * Start the process and send it the current G'MIC stdlib.
+     */
+    bool start();
+    bool isRunning()                            const;
+
+    /**
+     * The stdlib the worker was started with (shallow copy of GmicStdLib::current()).
+     */
+    QByteArray stdlib()                         const;
+
+    /**
+     * Run a command on a copy of the images. signalFinished() is emitted when done.
+     */
+    bool run(const QString& command,
+             const QString& environment,
+             const gmic_library::gmic_list<float>& images);
+
+    /**
+     * The images resulting from the last successful run.
+     */
+    void takeImages(gmic_library::gmic_list<float>& images);
+
+    float progress()                            const;
+    bool failed()                               const;
+    QString errorMessage()                      const;
+
+    /**
+     * The last run failed because its images do not fit in shared memory.
+     * The worker is still usable, the command must be run in the digiKam process.
+     */
+    bool tooLarge()                             const;
+
+    /**
+     * Detach the shared memory still held for the last run, by the plugin and the worker,
+     * before the worker goes idle.
+     */
+    void releaseSegments();
+
+public Q_SLOTS:
+
+    /**
+     * Kill the process. The worker cannot be used afterwards.
+     */
+    void abort();
+
+Q_SIGNALS:
+
+    void signalFinished();
+
+private Q_SLOTS:
+
+    void slotReadyRead();
+    void slotProcessFinished();
+
+private:
+
+    void finish(const QString& errorMessage);
+
+private:
+
+    class Private;
+    Private* const d = nullptr;
+};
+
+} // namespace DigikamBqmGmicQtPlugin
@@ -0,0 +1,289 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2026-10-17
+ * Description : digiKam Batch Queue Manager plugin for GmicQt.
+ *               Helper process running G'MIC commands for the plugin.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+// C++ includes
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Qt includes
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QSharedMemory>
+#include <QString>
+
+#ifdef Q_OS_WIN
+#   include <fcntl.h>
+#   include <io.h>
+#endif
+
+// Local includes
+
+#include "gmic.h"
+#include "gmicbqmworkerprotocol.h"
+
+using namespace DigikamBqmGmicQtPlugin;
+
+namespace
+{
+
+std::mutex s_outputMutex;
+
+bool readMessage(char& type, QByteArray& payload)
+{
+    char header[GmicBqmWorkerProtocol::HeaderSize];
+
+    if (std::fread(header, 1, sizeof(header), stdin) != sizeof(header))
+    {
+        return false;
+    }
+
+    type = header[0];
+    payload.resize((int)GmicBqmWorkerProtocol::payloadSize(header));
+
+    return (payload.isEmpty() ||
+            (std::fread(payload.data(), 1, payload.size(), stdin) == (size_t)payload.size()));
+}
+
+void writeMessage(char type, const QByteArray& payload)
+{
+    const QByteArray message = GmicBqmWorkerProtocol::message(type, payload);
+
+    std::lock_guard<std::mutex> lock(s_outputMutex);
+    std::fwrite(message.constData(), 1, message.size(), stdout);
+    std::fflush(stdout);
+}
+
+void writeError(const QString& error)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream << error;
+    writeMessage(GmicBqmWorkerProtocol::Error, payload);
+}
+
+/**
+ * Report the progress of the interpreter until the run is over.
+ */
+class ProgressReporter
+{
+public:
+
+    explicit ProgressReporter(const float* const progress)
+        : m_thread([this, progress]()
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+
+                while (!m_condition.wait_for(lock, std::chrono::milliseconds(250), [this]() { return m_done; }))
+                {
+                    QByteArray payload;
+                    QDataStream stream(&payload, QIODevice::WriteOnly);
+                    stream << *progress;
+                    writeMessage(GmicBqmWorkerProtocol::Progress, payload);
+                }
+            }
+        )
+    {
+    }
+
+    ~ProgressReporter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_done = true;
+        }
+
+        m_condition.notify_one();
+        m_thread.join();
+    }
+
+private:
+
+    std::mutex              m_mutex;
+    std::condition_variable m_condition;
+    bool                    m_done = false;
+    std::thread             m_thread;
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    Q_UNUSED(argc);
+    Q_UNUSED(argv);
+
+#ifdef Q_OS_WIN
+
+    _setmode(_fileno(stdin),  _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+
+#endif
+
+    // The standard output carries the messages to the plugin: G'MIC logs go to the error output.
+
+    gmic_library::cimg::output(stderr);
+
+    // The reference interpreter holds the parsed stdlib, each run starts from a reset copy of it.
+    // Command tables are only copied again after a new stdlib, or when a run changed them.
+
+    std::unique_ptr<gmic> reference;
+    gmic interpreter(nullptr, nullptr, false, nullptr, nullptr, 0.0f);
+    QSharedMemory output;
+    float progress     = -1.0f;
+    bool  abort        = false;
+    bool  keepCommands = false;
+    char  type         = 0;
+    QByteArray payload;
+
+    // Exits when the plugin closes the pipe.
+
+    while (readMessage(type, payload))
+    {
+        QDataStream stream(payload);
+
+        if (type == GmicBqmWorkerProtocol::StdLib)
+        {
+            QByteArray stdlib;
+            stream >> stdlib;
+            stdlib.append('\0');
+
+            reference.reset(new gmic(nullptr, nullptr, false, nullptr, nullptr, 0.0f));
+            reference->add_commands(gmic::decompress_stdlib().data());
+            reference->add_commands(stdlib.constData());
+            keepCommands = false;
+
+            continue;
+        }
+
+        if (type == GmicBqmWorkerProtocol::Release)
+        {
+            // The plugin has read the previous result.
+
+            if (output.isAttached())
+            {
+                output.detach();
+            }
+
+            continue;
+        }
+
+        if (type != GmicBqmWorkerProtocol::Run)
+        {
+            writeError(QString::fromLatin1("Unknown message type %1").arg((int)type));
+
+            continue;
+        }
+
+        // Not released by the plugin (which does not read a result twice).
+
+        if (output.isAttached())
+        {
+            output.detach();
+        }
+
+        QString inputKey, outputKey, environment, command;
+        gmic_list<float> images;
+        gmic_list<char>  names;
+
+        stream >> inputKey >> outputKey >> environment >> command;
+
+        if (!reference)
+        {
+            writeError(QString::fromLatin1("Malformed request"));
+
+            continue;
+        }
+
+        QSharedMemory input(inputKey);
+
+        if (!input.attach(QSharedMemory::ReadOnly))
+        {
+            writeError(QString::fromLatin1("Cannot attach input segment: %1").arg(input.errorString()));
+
+            continue;
+        }
+
+        // The layout is checked against the segment before reading the pixels.
+
+        if (!GmicBqmWorkerProtocol::readLayout(stream, images, input.size()))
+        {
+            input.detach();
+            writeError(QString::fromLatin1("Malformed request"));
+
+            continue;
+        }
+
+        GmicBqmWorkerProtocol::copyFromSegment(input.constData(), images);
+        input.detach();
+        names.assign(images._width);
+
+        try
+        {
+            progress = -1.0f;
+            interpreter.reset(*reference, &progress, &abort, keepCommands);
+            keepCommands = true;
+            ProgressReporter reporter(&progress);
+
+            if (!environment.isEmpty())
+            {
+                interpreter.run(environment.toLocal8Bit().constData(), 0.0f);
+            }
+
+            interpreter.set_variable("_host", '=', "digikam");
+            interpreter.set_variable("_tk", '=', "qt");
+            interpreter.run(QString(QLatin1String("skip 0 ") + command).toLocal8Bit().constData(), images, names);
+        }
+        catch (gmic_exception& e)
+        {
+            writeError(QString::fromLocal8Bit(e.what()));
+
+            continue;
+        }
+
+        const qint64 bytes = GmicBqmWorkerProtocol::segmentBytes(images);
+
+        if (bytes > GmicBqmWorkerProtocol::MaxSegmentBytes)
+        {
+            // The plugin runs the command again in its own process.
+
+            writeMessage(GmicBqmWorkerProtocol::TooLarge, QByteArray());
+
+            continue;
+        }
+
+        output.setKey(outputKey);
+
+        if (!output.create((int)bytes))
+        {
+            writeError(QString::fromLatin1("Cannot create output segment: %1").arg(output.errorString()));
+
+            continue;
+        }
+
+        GmicBqmWorkerProtocol::copyToSegment(images, output.data());
+
+        QByteArray layout;
+        QDataStream layoutStream(&layout, QIODevice::WriteOnly);
+        GmicBqmWorkerProtocol::writeLayout(layoutStream, images);
+        writeMessage(GmicBqmWorkerProtocol::Done, layout);
+    }
+
+    return 0;
+}
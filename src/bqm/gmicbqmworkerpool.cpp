@@ -0,0 +1,174 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2026-10-17
+ * Description : digiKam Batch Queue Manager plugin for GmicQt.
+ *               Pool of G'MIC worker processes.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+#include "gmicbqmworkerpool.h"
+
+// Qt includes
+
+#include <QCoreApplication>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QThread>
+
+// digiKam includes
+
+#include "digikam_debug.h"
+
+// Local includes
+
+#include "GmicStdlib.h"
+#include "gmicbqmscheduler.h"
+#include "gmicbqmworker.h"
+
+using namespace GmicQt;
+
+namespace DigikamBqmGmicQtPlugin
+{
+
+namespace
+{
+
+const char* const s_workerName = "digikam_gmic_worker";
+
+QMutex                s_mutex;
+QList<GmicBqmWorker*> s_idleWorkers;
+
+} // namespace
+
+QString GmicBqmWorkerPool::program()
+{
+    static const QString path = []()
+    {
+        QStringList dirs;
+        dirs << QCoreApplication::applicationDirPath();
+
+#ifdef GMIC_BQM_WORKER_DIR
+
+        dirs << QLatin1String(GMIC_BQM_WORKER_DIR);
+
+#endif
+
+        QString found = QStandardPaths::findExecutable(QLatin1String(s_workerName), dirs);
+
+        if (found.isEmpty())
+        {
+            found = QStandardPaths::findExecutable(QLatin1String(s_workerName));
+        }
+
+        return found;
+    }();
+
+    return path;
+}
+
+GmicBqmWorker* GmicBqmWorkerPool::acquire()
+{
+    GmicBqmWorker* worker   = nullptr;
+    const QByteArray stdlib = GmicStdLib::current();
+    QList<GmicBqmWorker*> stale;
+
+    {
+        QMutexLocker locker(&s_mutex);
+
+        while (!s_idleWorkers.isEmpty())
+        {
+            GmicBqmWorker* const idle = s_idleWorkers.takeLast();
+
+            // Idle workers have no thread affinity, and can be pulled to the calling thread.
+
+            idle->moveToThread(QThread::currentThread());
+
+            // Workers hold a copy of their stdlib: an unchanged data pointer means unchanged contents.
+
+            const QByteArray idleStdlib = idle->stdlib();
+
+            if (idle->isRunning()                              &&
+                (idleStdlib.constData() == stdlib.constData()) &&
+                (idleStdlib.size()      == stdlib.size()))
+            {
+                worker = idle;
+                break;
+            }
+
+            // Exited meanwhile, or started with an outdated stdlib.
+
+            stale << idle;
+        }
+    }
+
+    qDeleteAll(stale);
+
+    if (worker)
+    {
+        return worker;
+    }
+
+    if (program().isEmpty())
+    {
+        qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC worker" << s_workerName << "is not installed.";
+
+        return nullptr;
+    }
+
+    worker = new GmicBqmWorker(program());
+
+    if (!worker->start())
+    {
+        delete worker;
+
+        return nullptr;
+    }
+
+    return worker;
+}
+
+void GmicBqmWorkerPool::release(GmicBqmWorker* const worker)
+{
+    if (!worker)
+    {
+        return;
+    }
+
+    // Idle workers hold no shared memory, which the scheduler budget does not count.
+
+    worker->releaseSegments();
+
+    QMutexLocker locker(&s_mutex);
+
+    if (worker->isRunning() && (s_idleWorkers.size() < GmicBqmScheduler::maxJobs()))
+    {
+        worker->disconnect();
+        worker->moveToThread(nullptr);
+        s_idleWorkers << worker;
+
+        return;
+    }
+
+    locker.unlock();
+    delete worker;
+}
+
+void GmicBqmWorkerPool::discard(GmicBqmWorker* const worker)
+{
+    if (worker)
+    {
+        worker->abort();
+        delete worker;
+    }
+}
+
+} // namespace DigikamBqmGmicQtPlugin
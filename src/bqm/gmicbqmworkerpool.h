@@ -0,0 +1,66 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2026-10-17
+ * Description : digiKam Batch Queue Manager plugin for GmicQt.
+ *               Pool of G'MIC worker processes.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+#pragma once
+
+// Qt includes
+
+#include <QString>
+
+namespace DigikamBqmGmicQtPlugin
+{
+
+class GmicBqmWorker;
+
+/**
+ * Process-wide pool of idle G'MIC workers, so that the processes and their parsed stdlib
+ * are reused from one image to the next. Idle workers are started with the current stdlib,
+ * and at most GmicBqmScheduler::maxJobs() of them are kept.
+ * The Batch Queue Manager runs the jobs on its own threads: an acquired worker belongs to
+ * the calling thread until it is released or discarded from that same thread.
+ */
+class GmicBqmWorkerPool
+{
+
+public:
+
+    /**
+     * Path of the worker executable, or a null string if it is not installed.
+     */
+    static QString program();
+
+    /**
+     * Return an idle worker or start a new one, or nullptr if no worker can be started.
+     */
+    static GmicBqmWorker* acquire();
+
+    /**
+     * Give back a worker after a successful run.
+     */
+    static void release(GmicBqmWorker* const worker);
+
+    /**
+     * Delete a worker after a failed or cancelled run.
+     */
+    static void discard(GmicBqmWorker* const worker);
+
+private:
+
+    // Disable
+    GmicBqmWorkerPool()  = delete;
+    ~GmicBqmWorkerPool() = delete;
+};
+
+} // namespace DigikamBqmGmicQtPlugin
@@ -0,0 +1,226 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2026-10-17
+ * Description : digiKam Batch Queue Manager plugin for GmicQt.
+ *               Messages exchanged with the G'MIC worker processes.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+#pragma once
+
+// C++ includes
+
+#include <climits>
+#include <cstring>
+
+// Qt includes
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QList>
+
+// Local includes
+
+#include "gmic.h"
+
+/**
+ * The plugin and a worker talk through the standard input and output of the worker.
+ * A message is its type (one byte), the size of its payload (quint32, big endian)
+ * and the payload, serialized with QDataStream.
+ * The pixels never go through the pipe: they are exchanged through shared memory
+ * segments, laid out as the raw float buffers of the images one after the other.
+ *
+ * Plugin to worker:
+ *   StdLib:   QByteArray stdlib, parsed once for all the runs of the worker.
+ *   Run:      QString input segment key, QString output segment key,
+ *             QString environment, QString command, image layout.
+ *   Release:  no payload, the plugin has copied the images of the output segment.
+ *
+ * Worker to plugin:
+ *   Progress: float progress, as reported by the interpreter.
+ *   Done:     image layout, the pixels are in the output segment.
+ *   TooLarge: no payload, the output images do not fit in a segment.
+ *   Error:    QString error message.
+ *
+ * The worker keeps the output segment attached until the Release message,
+ * so that the plugin can attach to it meanwhile. The plugin detaches the input
+ * segment when the run is over, so that idle workers do not hold shared memory.
+ * A segment holds at most MaxSegmentBytes (QSharedMemory sizes are int): larger
+ * images are processed in the plugin process instead.
+ */
+namespace DigikamBqmGmicQtPlugin
+{
+
+namespace GmicBqmWorkerProtocol
+{
+
+enum MessageType
+{
+    StdLib   = 'L',
+    Run      = 'R',
+    Release  = 'F',
+    Progress = 'P',
+    Done     = 'D',
+    TooLarge = 'T',
+    Error    = 'E'
+};
+
+const int    HeaderSize      = 5;
+const qint64 MaxSegmentBytes = INT_MAX;
+
+inline QByteArray message(char type, const QByteArray& payload)
+{
+    QByteArray header(HeaderSize, Qt::Uninitialized);
+    const quint32 size = payload.size();
+    header[0]          = type;
+    header[1]          = (char)(size >> 24);
+    header[2]          = (char)(size >> 16);
+    header[3]          = (char)(size >>  8);
+    header[4]          = (char)size;
+
+    return (header + payload);
+}
+
+inline quint32 payloadSize(const char* const header)
+{
+    const uchar* const h = reinterpret_cast<const uchar*>(header);
+
+    return (((quint32)h[1] << 24) | ((quint32)h[2] << 16) | ((quint32)h[3] << 8) | (quint32)h[4]);
+}
+
+inline void writeLayout(QDataStream& stream, const gmic_library::gmic_list<float>& images)
+{
+    stream << (quint32)images._width;
+
+    for (unsigned int i = 0 ; i < images._width ; ++i)
+    {
+        stream << (quint32)images[i]._width << (quint32)images[i]._height
+               << (quint32)images[i]._depth << (quint32)images[i]._spectrum;
+    }
+}
+
+/**
+ * Allocate the images described by a layout, which must fit in a segment of segmentBytes.
+ * Return false on malformed data, before allocating anything.
+ */
+inline bool readLayout(QDataStream& stream, gmic_library::gmic_list<float>& images, qint64 segmentBytes)
+{
+    quint32 count = 0;
+    stream >> count;
+
+    if ((stream.status() != QDataStream::Ok) || (count > 1024))
+    {
+        return false;
+    }
+
+    QList<quint32> sizes;
+    qint64 bytes = 0;
+
+    for (unsigned int i = 0 ; i < count ; ++i)
+    {
+        quint32 w = 0, h = 0, d = 0, s = 0;
+        stream >> w >> h >> d >> s;
+
+        if (stream.status() != QDataStream::Ok)
+        {
+            return false;
+        }
+
+        // Checked one dimension at a time, so that the product cannot overflow.
+
+        qint64 imageBytes = sizeof(float);
+
+        for (const quint32 dimension : { w, h, d, s })
+        {
+            imageBytes *= dimension;
+
+            if (imageBytes > segmentBytes)
+            {
+                return false;
+            }
+        }
+
+        bytes += imageBytes;
+
+        if (bytes > segmentBytes)
+        {
+            return false;
+        }
+
+        sizes << w << h << d << s;
+    }
+
+    images.assign(count);
+
+    for (unsigned int i = 0 ; i < count ; ++i)
+    {
+        images[i].assign(sizes[4 * i], sizes[4 * i + 1], sizes[4 * i + 2], sizes[4 * i + 3]);
+    }
+
+    return true;
+}
+
+inline qint64 layoutBytes(const gmic_library::gmic_list<float>& images)
+{
+    qint64 bytes = 0;
+
+    for (unsigned int i = 0 ; i < images._width ; ++i)
+    {
+        bytes += (qint64)images[i].size() * sizeof(float);
+    }
+
+    return bytes;
+}
+
+/**
+ * The size of the segment holding the images, a segment cannot be empty.
+ */
+inline qint64 segmentBytes(const gmic_library::gmic_list<float>& images)
+{
+    return qMax((qint64)1, layoutBytes(images));
+}
+
+inline void copyToSegment(const gmic_library::gmic_list<float>& images, void* const segment)
+{
+    char* data = static_cast<char*>(segment);
+
+    for (unsigned int i = 0 ; i < images._width ; ++i)
+    {
+        const size_t bytes = images[i].size() * sizeof(float);
+
+        if (bytes)
+        {
+            std::memcpy(data, images[i]._data, bytes);
+        }
+
+        data += bytes;
+    }
+}
+
+inline void copyFromSegment(const void* const segment, gmic_library::gmic_list<float>& images)
+{
+    const char* data = static_cast<const char*>(segment);
+
+    for (unsigned int i = 0 ; i < images._width ; ++i)
+    {
+        const size_t bytes = images[i].size() * sizeof(float);
+
+        if (bytes)
+        {
+            std::memcpy(images[i]._data, data, bytes);
+        }
+
+        data += bytes;
+    }
+}
+
+} // namespace GmicBqmWorkerProtocol
+
+} // namespace DigikamBqmGmicQtPlugin
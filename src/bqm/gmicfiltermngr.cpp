@@ -22,12 +22,17 @@ GmicFilterManager::GmicFilterManager(const QString& file, QObject* const parent)
       d      (new Private)
 {
     d->commandsFile = file;
+
+    const QFileInfo info(file);
+    d->store        = new GmicFilterStore(info.absolutePath() + QLatin1Char('/') +
+                                          info.completeBaseName() + QLatin1String(".journal"));
     load();
 }
 
 GmicFilterManager::~GmicFilterManager()
 {
     delete d->commandRootNode;
+    delete d->store;
     delete d;
 }
 
@@ -42,9 +47,29 @@ void GmicFilterManager::load()
         return;
     }
 
-    qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "Loading G'MIC filters from" << d->commandsFile;
     d->loaded = true;
 
+    if (d->store->exists())
+    {
+        qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "Loading G'MIC filters from" << d->store->fileName();
+
+        d->commandRootNode = d->store->read(d->currentPath);
+
+        if (!d->store->errorString().isEmpty())
+        {
+            QMessageBox::warning(nullptr, QObject::tr("Loading Filters"),
+                                 QObject::tr("Error when loading G'MIC filters from %1:\n%2")
+                                      .arg(d->store->fileName())
+                                      .arg(d->store->errorString()));
+        }
+
+        return;
+    }
+
+    // First run with the journal: migrate the XML file saved by previous versions, which is left untouched.
+
+    qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "Loading G'MIC filters from" << d->commandsFile;
+
     GmicXmlReader reader;
 
     d->commandRootNode = reader.read(d->commandsFile, d->currentPath);
@@ -56,7 +81,11 @@ void GmicFilterManager::load()
                                   .arg(reader.lineNumber())
                                   .arg(reader.columnNumber())
                                   .arg(reader.errorString()));
+
+        return;
     }
+
+    save();
 }
 
 void GmicFilterManager::save()
@@ -66,13 +95,53 @@ void GmicFilterManager::save()
         return;
     }
 
-    qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "Saving G'MIC Filters to" << d->commandsFile;
+    qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "Saving G'MIC Filters to" << d->store->fileName();
 
-    GmicXmlWriter writer;
+    if (!d->store->write(d->commandRootNode, d->currentPath))
+    {
+        qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "Error saving G'MIC filters to" << d->store->fileName()
+                                           << d->store->errorString();
+    }
+}
+
+int GmicFilterManager::pendingChildren(const GmicFilterNode* const node) const
+{
+    return d->store->pendingChildren(node);
+}
+
+void GmicFilterManager::fetchChildren(GmicFilterNode* const node)
+{
+    if (d->store->pendingChildren(node) == 0)
+    {
+        return;
+    }
+
+    const QList<GmicFilterNode*> children = d->store->readChildren(node);
+
+    if (children.isEmpty())
+    {
+        return;
+    }
 
-    if (!writer.write(d->commandsFile, d->commandRootNode, d->currentPath))
+    Q_EMIT signalChildrenAboutToBeFetched(node, children.count());
+
+    for (GmicFilterNode* const child : children)
     {
-        qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "Error saving G'MIC filters to" << d->commandsFile;
+        node->add(child);
+    }
+
+    Q_EMIT signalChildrenFetched(node);
+}
+
+void GmicFilterManager::fetchAll(GmicFilterNode* const node)
+{
+    fetchChildren(node);
+
+    const QList<GmicFilterNode*> children = node->children();
+
+    for (GmicFilterNode* const child : children)
+    {
+        fetchAll(child);
     }
 }
 
@@ -86,6 +155,10 @@ void GmicFilterManager::addEntry(GmicFilterNode* const parent,
 
     Q_ASSERT(parent);
 
+    // The row is relative to the children of the folder once loaded.
+
+    fetchChildren(parent);
+
     InsertGmicFilter* const command = new InsertGmicFilter(this, parent, node, row);
     d->commands.push(command);
 }
@@ -99,6 +172,10 @@ void GmicFilterManager::removeEntry(GmicFilterNode* const node)
 
     Q_ASSERT(node);
 
+    // The removed node is kept by the undo stack, with its whole sub-tree.
+
+    fetchAll(node);
+
     GmicFilterNode* const parent    = node->parent();
     int row                         = parent->children().indexOf(node);
     RemoveGmicFilter* const command = new RemoveGmicFilter(this, parent, row);
@@ -221,6 +298,8 @@ void GmicFilterManager::slotExportFilters()
         return;
     }
 
+    fetchAll(d->commandRootNode);
+
     GmicXmlWriter writer;
 
     if (!writer.write(fileName, d->commandRootNode, d->currentPath))
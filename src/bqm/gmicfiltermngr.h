@@ -163,7 +163,10 @@ public:
 //---------------------------------------------------------------------------------
 
 /**
- *  Gmic Filter manager, owner of the commands, loads, saves and basic tasks
+ *  Gmic Filter manager, owner of the commands, loads, saves and basic tasks.
+ *  The commands are stored in a GmicFilterStore journal next to the XML file given to the
+ *  constructor, which is only read to migrate the filters saved by previous versions.
+ *  The children of the folders are loaded on demand with fetchChildren().
  */
 class GmicFilterManager : public QObject
 {
@@ -193,6 +196,17 @@ public:
     GmicFilterModel* commandsModel();
     QUndoStack*      undoRedoStack()    const;
 
+    /**
+     * Return the number of children of a folder not loaded yet.
+     */
+    int pendingChildren(const GmicFilterNode* const node) const;
+
+    /**
+     * Load the children of a folder, or of all the folders below a node.
+     */
+    void fetchChildren(GmicFilterNode* const node);
+    void fetchAll(GmicFilterNode* const node);
+
     void save();
     void load();
 
@@ -201,6 +215,8 @@ Q_SIGNALS:
     void signalEntryAdded(GmicFilterNode* item);
     void signalEntryRemoved(GmicFilterNode* parent, int row, GmicFilterNode* item);
     void signalEntryChanged(GmicFilterNode* item);
+    void signalChildrenAboutToBeFetched(GmicFilterNode* parent, int count);
+    void signalChildrenFetched(GmicFilterNode* parent);
 
 public Q_SLOTS:
 
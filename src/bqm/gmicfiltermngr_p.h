@@ -20,6 +20,7 @@
 
 #include <QBuffer>
 #include <QFile>
+#include <QFileInfo>
 #include <QMimeData>
 #include <QDragEnterEvent>
 #include <QIcon>
@@ -41,6 +42,7 @@
 
 #include "gmicfilternode.h"
 #include "gmicfiltermodel.h"
+#include "gmicfilterstore.h"
 #include "gmicqtcommon.h"
 
 using namespace Digikam;
@@ -77,6 +79,7 @@ public:
     bool             loaded             = false;
     GmicFilterNode*  commandRootNode    = nullptr;
     GmicFilterModel* commandModel       = nullptr;
+    GmicFilterStore* store              = nullptr;
     QUndoStack       commands;
     QString          commandsFile;
     QString          currentPath;
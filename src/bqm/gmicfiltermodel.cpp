@@ -64,6 +64,12 @@ GmicFilterModel::GmicFilterModel(GmicFilterManager* const mngr, QObject* const p
 
     connect(d->manager, SIGNAL(signalEntryChanged(GmicFilterNode*)),
             this, SLOT(slotEntryChanged(GmicFilterNode*)));
+
+    connect(d->manager, SIGNAL(signalChildrenAboutToBeFetched(GmicFilterNode*,int)),
+            this, SLOT(slotChildrenAboutToBeFetched(GmicFilterNode*,int)));
+
+    connect(d->manager, SIGNAL(signalChildrenFetched(GmicFilterNode*)),
+            this, SLOT(slotChildrenFetched(GmicFilterNode*)));
 }
 
 GmicFilterModel::~GmicFilterModel()
@@ -120,6 +126,16 @@ void GmicFilterModel::slotEntryChanged(GmicFilterNode* item)
     Q_EMIT dataChanged(idx, idx);
 }
 
+void GmicFilterModel::slotChildrenAboutToBeFetched(GmicFilterNode* parent, int count)
+{
+    beginInsertRows(index(parent), 0, count - 1);
+}
+
+void GmicFilterModel::slotChildrenFetched(GmicFilterNode* /*parent*/)
+{
+    endInsertRows();
+}
+
 bool GmicFilterModel::removeRows(int row, int count, const QModelIndex& parent)
 {
     if ((row < 0) || (count <= 0) || ((row + count) > rowCount(parent)))
@@ -357,6 +373,16 @@ bool GmicFilterModel::hasChildren(const QModelIndex& parent) const
            );
 }
 
+bool GmicFilterModel::canFetchMore(const QModelIndex& parent) const
+{
+    return (d->manager->pendingChildren(node(parent)) > 0);
+}
+
+void GmicFilterModel::fetchMore(const QModelIndex& parent)
+{
+    d->manager->fetchChildren(node(parent));
+}
+
 Qt::ItemFlags GmicFilterModel::flags(const QModelIndex& index) const
 {
     if (!index.isValid())
@@ -410,7 +436,8 @@ QMimeData* GmicFilterModel::mimeData(const QModelIndexList& indexes) const
         QBuffer buffer(&encodedData);
         buffer.open(QBuffer::ReadWrite);
         GmicXmlWriter writer;
-        const GmicFilterNode* const parentNode = node(id);
+        GmicFilterNode* const parentNode = node(id);
+        d->manager->fetchAll(parentNode);
         writer.write(&buffer, parentNode, QString());
         stream << encodedData;
     }
@@ -65,6 +65,8 @@ public:
     QMimeData* mimeData(const QModelIndexList& indexes)                 const override;
     QStringList mimeTypes()                                             const override;
     bool hasChildren(const QModelIndex& parent = QModelIndex())         const override;
+    bool canFetchMore(const QModelIndex& parent)                        const override;
+    void fetchMore(const QModelIndex& parent)                                 override;
     GmicFilterNode* node(const QModelIndex& index)                      const;
     QModelIndex index(GmicFilterNode* node)                             const;
 
@@ -82,6 +84,8 @@ public Q_SLOTS:
     void slotEntryAdded(GmicFilterNode* item);
     void slotEntryRemoved(GmicFilterNode* parent, int row, GmicFilterNode* item);
     void slotEntryChanged(GmicFilterNode* item);
+    void slotChildrenAboutToBeFetched(GmicFilterNode* parent, int count);
+    void slotChildrenFetched(GmicFilterNode* parent);
 
 private:
 
@@ -116,6 +116,16 @@ void GmicFilterNode::remove(GmicFilterNode* const child)
     d->children.removeAll(child);
 }
 
+quint32 GmicFilterNode::id() const
+{
+    return d->id;
+}
+
+void GmicFilterNode::setId(quint32 id)
+{
+    d->id = id;
+}
+
 } // namespace DigikamBqmGmicQtPlugin
 
 #include "moc_gmicfilternode.cpp"
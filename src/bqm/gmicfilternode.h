@@ -59,6 +59,12 @@ public:
     void add(GmicFilterNode* const child, int offset = -1);
     void remove(GmicFilterNode* const child);
 
+    /**
+     * Identifier of the node in the GmicFilterStore journal, 0 if not stored yet.
+     */
+    quint32 id()                                 const;
+    void    setId(quint32 id);
+
 public:
 
     QMap<QString, QVariant> commands;         ///< Map of filter name and filter command
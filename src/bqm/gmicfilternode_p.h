@@ -43,6 +43,7 @@ public:
 
     GmicFilterNode*        parent    = nullptr;
     Type                   type      = GmicFilterNode::Root;
+    quint32                id        = 0;
     QList<GmicFilterNode*> children;
 };
 
@@ -0,0 +1,1013 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2026-10-17
+ * Description : digiKam Batch Queue Manager plugin for GmicQt.
+ *               Journaled storage of the G'MIC filters tree.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+#include "gmicfilterstore.h"
+
+// Qt includes
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QLockFile>
+#include <QObject>
+#include <QPair>
+#include <QQueue>
+#include <QSaveFile>
+#include <QSet>
+#include <QVariant>
+#include <QVector>
+
+// digiKam includes
+
+#include "digikam_debug.h"
+
+// Local includes
+
+#include "gmicfilternode.h"
+
+namespace DigikamBqmGmicQtPlugin
+{
+
+namespace
+{
+
+const quint32 s_magic       = 0x474D4346;       // "GMCF"
+const quint32 s_version     = 2;
+const qint64  s_headerSize  = 12;               ///< Magic, version and generation.
+const qint64  s_recordSize  = 9;                ///< Kind, identifier and size of the payload.
+const qint64  s_minCompact  = 1024 * 1024;      ///< Smaller journals are never compacted.
+const quint32 s_rootId      = 0;                ///< The root node has no record of its own.
+const int     s_lockTimeout = 10000;            ///< Time to wait for another instance, in ms.
+
+enum RecordKind
+{
+    NodeRecord   = 'N',
+    OrderRecord  = 'O',
+    PathRecord   = 'P',
+    CommitRecord = 'C'
+};
+
+struct NodeEntry
+{
+    qint64  offset = -1;                        ///< Offset of the payload, -1 if not written yet.
+    quint32 size   = 0;
+};
+
+typedef QPair<quint32, QByteArray> NodeChange;
+
+struct OrderChange
+{
+    quint32          id = 0;
+    QVector<quint32> children;                  ///< Children in the tree.
+    QVector<quint32> order;                     ///< Children written, with the ones added by another store.
+};
+
+bool isFolder(const GmicFilterNode* const node)
+{
+    return (
+            (node->type() == GmicFilterNode::Root)   ||
+            (node->type() == GmicFilterNode::Folder) ||
+            (node->type() == GmicFilterNode::RootFolder)
+           );
+}
+
+/**
+ * Nodes created in this session have no identifier until they are written.
+ */
+bool isStored(const GmicFilterNode* const node)
+{
+    return ((node->id() != s_rootId) || (node->type() == GmicFilterNode::Root));
+}
+
+QByteArray header(quint32 generation)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << s_magic << s_version << generation;
+
+    return data;
+}
+
+QByteArray nodePayload(const GmicFilterNode* const node)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << (qint32)node->type() << node->title << node->desc << node->dateAdded
+           << node->expanded << node->commands;
+
+    return payload;
+}
+
+/**
+ * Return a new node without parent, or nullptr if the payload is not valid.
+ */
+GmicFilterNode* nodeFromPayload(const QByteArray& payload)
+{
+    QDataStream stream(payload);
+    stream.setVersion(QDataStream::Qt_5_0);
+
+    qint32 type = -1;
+    stream >> type;
+
+    if ((stream.status() != QDataStream::Ok) ||
+        (type < GmicFilterNode::Folder)      ||
+        (type > GmicFilterNode::RootFolder))
+    {
+        return nullptr;
+    }
+
+    GmicFilterNode* const node = new GmicFilterNode((GmicFilterNode::Type)type);
+    stream >> node->title >> node->desc >> node->dateAdded >> node->expanded >> node->commands;
+
+    if (stream.status() != QDataStream::Ok)
+    {
+        delete node;
+
+        return nullptr;
+    }
+
+    if (node->type() == GmicFilterNode::RootFolder)
+    {
+        node->title = QObject::tr("My G'MIC Filters");
+    }
+
+    return node;
+}
+
+QByteArray orderPayload(const QVector<quint32>& children)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << children;
+
+    return payload;
+}
+
+QByteArray pathPayload(const QString& currentPath)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << currentPath;
+
+    return payload;
+}
+
+QByteArray record(RecordKind kind, quint32 id, const QByteArray& payload)
+{
+    QByteArray data;
+    QDataStream stream(&data, QIODevice::WriteOnly);
+    stream << (quint8)kind << id << (quint32)payload.size();
+    data.append(payload);
+
+    return data;
+}
+
+} // namespace
+
+class Q_DECL_HIDDEN GmicFilterStore::Private
+{
+public:
+
+    Private() = default;
+
+    void clear()
+    {
+        validSize  = 0;
+        fileSize   = -1;
+        generation = 0;
+        nextId     = 1;
+        readOnly   = false;
+        nodes.clear();
+        orders.clear();
+        journalPath.clear();
+        payloads.clear();
+        loadedOrders.clear();
+        pending.clear();
+        unreadable.clear();
+        currentPath.clear();
+        errorString.clear();
+    }
+
+    bool lock(QLockFile& lockFile)
+    {
+        if (!lockFile.tryLock(s_lockTimeout))
+        {
+            errorString = QObject::tr("The file %1 is locked by another process.").arg(fileName);
+
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * Index the committed records of the journal. The nodes and folders created in the tree
+     * are left untouched. On error, the store becomes read-only as the index is not reliable anymore.
+     */
+    bool index()
+    {
+        nodes.clear();
+        orders.clear();
+        journalPath.clear();
+        validSize  = 0;
+        fileSize   = -1;
+        generation = 0;
+
+        QFile file(fileName);
+
+        if (!file.exists())
+        {
+            return true;
+        }
+
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            errorString = file.errorString();
+            readOnly    = true;
+
+            return false;
+        }
+
+        fileSize = file.size();
+
+        if (fileSize == 0)
+        {
+            return true;
+        }
+
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_5_0);
+
+        quint32 magic   = 0;
+        quint32 version = 0;
+        stream >> magic >> version >> generation;
+
+        if ((magic != s_magic) || (version != s_version))
+        {
+            errorString = QObject::tr("The file is not a G'MIC filters journal version %1.")
+                              .arg(s_version);
+            readOnly    = true;
+
+            return false;
+        }
+
+        // Records are applied at their commit record: a save interrupted by a crash is ignored.
+
+        QHash<quint32, NodeEntry>         batchNodes;
+        QHash<quint32, QVector<quint32> > batchOrders;
+        QString                           batchPath;
+        bool                              hasPath = false;
+        bool                              valid   = true;
+        validSize                                 = s_headerSize;
+
+        while (valid && !stream.atEnd())
+        {
+            quint8  kind = 0;
+            quint32 id   = 0;
+            quint32 size = 0;
+            stream >> kind >> id >> size;
+
+            const qint64 offset = file.pos();
+
+            if ((stream.status() != QDataStream::Ok) || ((offset + size) > fileSize))
+            {
+                break;
+            }
+
+            switch (kind)
+            {
+                case NodeRecord:
+                {
+                    NodeEntry entry;
+                    entry.offset = offset;
+                    entry.size   = size;
+                    batchNodes.insert(id, entry);
+                    valid        = (stream.skipRawData(size) == (int)size);
+                    break;
+                }
+
+                case OrderRecord:
+                case PathRecord:
+                {
+                    QByteArray payload(size, Qt::Uninitialized);
+                    valid = (stream.readRawData(payload.data(), size) == (int)size);
+
+                    QDataStream fields(payload);
+                    fields.setVersion(QDataStream::Qt_5_0);
+
+                    if (kind == OrderRecord)
+                    {
+                        QVector<quint32> children;
+                        fields >> children;
+                        batchOrders.insert(id, children);
+                    }
+                    else
+                    {
+                        fields >> batchPath;
+                        hasPath = true;
+                    }
+
+                    valid &= (fields.status() == QDataStream::Ok);
+                    break;
+                }
+
+                case CommitRecord:
+                {
+                    for (auto it = batchNodes.constBegin() ; it != batchNodes.constEnd() ; ++it)
+                    {
+                        nodes.insert(it.key(), it.value());
+                        nextId = qMax(nextId, it.key() + 1);
+                    }
+
+                    for (auto it = batchOrders.constBegin() ; it != batchOrders.constEnd() ; ++it)
+                    {
+                        orders.insert(it.key(), it.value());
+                    }
+
+                    if (hasPath)
+                    {
+                        journalPath = batchPath;
+                    }
+
+                    batchNodes.clear();
+                    batchOrders.clear();
+                    hasPath   = false;
+                    validSize = file.pos();
+                    break;
+                }
+
+                default:
+                {
+                    valid = false;
+                    break;
+                }
+            }
+
+            valid &= (stream.status() == QDataStream::Ok) && (file.pos() == (offset + size));
+        }
+
+        if (validSize != fileSize)
+        {
+            qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "Ignoring" << (fileSize - validSize)
+                                               << "bytes of incomplete records in" << fileName;
+        }
+
+        return true;
+    }
+
+    /**
+     * Index the journal again if another store changed it since the last access: appended
+     * records change its size, and a compaction or the removal of incomplete records its generation.
+     */
+    bool refresh()
+    {
+        QFile file(fileName);
+        const qint64 size = file.exists() ? file.size() : -1;
+
+        if (size == fileSize)
+        {
+            if (size <= 0)
+            {
+                return true;
+            }
+
+            QDataStream stream(&file);
+            quint32 magic   = 0;
+            quint32 version = 0;
+            quint32 current = 0;
+
+            if (file.open(QIODevice::ReadOnly))
+            {
+                stream >> magic >> version >> current;
+            }
+
+            if ((stream.status() == QDataStream::Ok) && (magic == s_magic) &&
+                (version == s_version) && (current == generation))
+            {
+                return true;
+            }
+        }
+
+        qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "G'MIC filters journal" << fileName << "changed, indexing it again";
+
+        return index();
+    }
+
+    bool isPending(const GmicFilterNode* const node) const
+    {
+        return (isStored(node) && pending.contains(node->id()) && !unreadable.contains(node->id()));
+    }
+
+    /**
+     * Create the children of a pending folder. If one of them cannot be read, none is returned:
+     * the folder is left pending, so that its contents are never written back from a partial read.
+     */
+    QList<GmicFilterNode*> createChildren(quint32 id)
+    {
+        QList<GmicFilterNode*> created;
+        QVector<quint32> loaded;
+        const QVector<quint32> children = orders.value(id);
+        QFile file(fileName);
+        bool valid                      = file.open(QIODevice::ReadOnly);
+
+        for (const quint32 child : children)
+        {
+            if (!valid)
+            {
+                break;
+            }
+
+            if (!nodes.contains(child))
+            {
+                continue;
+            }
+
+            const NodeEntry entry = nodes.value(child);
+            QByteArray payload;
+            valid                 = file.seek(entry.offset);
+
+            if (valid)
+            {
+                payload = file.read(entry.size);
+                valid   = (payload.size() == (int)entry.size);
+            }
+
+            GmicFilterNode* const node = valid ? nodeFromPayload(payload) : nullptr;
+            valid                      = (node != nullptr);
+
+            if (valid)
+            {
+                node->setId(child);
+                created << node;
+                loaded  << child;
+                payloads.insert(child, payload);
+
+                if (isFolder(node) && !orders.value(child).isEmpty())
+                {
+                    pending.insert(child);
+                }
+            }
+        }
+
+        if (!valid)
+        {
+            errorString = QObject::tr("Cannot read the contents of a folder from %1.").arg(fileName);
+            qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "Cannot read the children of folder" << id
+                                               << "from" << fileName << file.errorString();
+
+            for (GmicFilterNode* const node : qAsConst(created))
+            {
+                payloads.remove(node->id());
+                pending.remove(node->id());
+            }
+
+            qDeleteAll(created);
+            unreadable.insert(id);
+
+            return QList<GmicFilterNode*>();
+        }
+
+        pending.remove(id);
+        loadedOrders.insert(id, loaded);
+
+        return created;
+    }
+
+    /**
+     * Collect the nodes and folder contents which differ from the journal.
+     * The nodes which get an identifier are added to 'newNodes'.
+     */
+    void collect(GmicFilterNode* const node,
+                 QList<NodeChange>& changedNodes,
+                 QList<OrderChange>& changedOrders,
+                 QList<GmicFilterNode*>& newNodes)
+    {
+        if (node->type() != GmicFilterNode::Root)
+        {
+            if (!isStored(node))
+            {
+                node->setId(nextId++);
+                newNodes << node;
+            }
+
+            const QByteArray payload = nodePayload(node);
+
+            if (!nodes.contains(node->id()) || (payloads.value(node->id()) != payload))
+            {
+                changedNodes << NodeChange(node->id(), payload);
+            }
+        }
+
+        // The contents of a folder can only change once its children were created.
+
+        if (!isFolder(node) || pending.contains(node->id()))
+        {
+            return;
+        }
+
+        QVector<quint32> children;
+        const QList<GmicFilterNode*> childNodes = node->children();
+
+        for (GmicFilterNode* const child : childNodes)
+        {
+            collect(child, changedNodes, changedOrders, newNodes);
+            children << child->id();
+        }
+
+        // Compare with the contents as created, to keep the changes made by another store
+        // to the folders which were not modified here. In a modified folder, the children
+        // added by another store are kept after the ones of the tree.
+
+        const QVector<quint32> loaded = loadedOrders.value(node->id());
+
+        if ((loaded != children) || (!orders.contains(node->id()) && !children.isEmpty()))
+        {
+            OrderChange change;
+            change.id       = node->id();
+            change.children = children;
+            change.order    = children;
+
+            const QVector<quint32> order = orders.value(node->id());
+
+            for (const quint32 id : order)
+            {
+                if (!loaded.contains(id) && !children.contains(id))
+                {
+                    change.order << id;
+                }
+            }
+
+            changedOrders << change;
+        }
+    }
+
+    /**
+     * Size of the records reachable from the root, the others are outdated.
+     */
+    qint64 liveSize() const
+    {
+        qint64 size = s_headerSize;
+        QQueue<quint32> folders;
+        folders.enqueue(s_rootId);
+
+        while (!folders.isEmpty())
+        {
+            const quint32 id = folders.dequeue();
+
+            if (!orders.contains(id))
+            {
+                continue;
+            }
+
+            const QVector<quint32> children = orders.value(id);
+            size                           += s_recordSize + 4 + 4 * children.size();
+
+            for (const quint32 child : children)
+            {
+                if (nodes.contains(child))
+                {
+                    size += s_recordSize + nodes.value(child).size;
+                    folders.enqueue(child);
+                }
+            }
+        }
+
+        return size;
+    }
+
+    /**
+     * Write a new journal made of the header and of 'batch'.
+     */
+    bool create(const QByteArray& batch)
+    {
+        QSaveFile file(fileName);
+        const QByteArray data = header(generation + 1) + batch;
+
+        if (!file.open(QIODevice::WriteOnly) || (file.write(data) != data.size()) || !file.commit())
+        {
+            errorString = file.errorString();
+
+            return false;
+        }
+
+        ++generation;
+
+        return true;
+    }
+
+    /**
+     * Append 'batch' to the journal, after its last commit.
+     */
+    bool append(const QByteArray& batch)
+    {
+        QFile file(fileName);
+
+        if (!file.open(QIODevice::ReadWrite))
+        {
+            errorString = file.errorString();
+
+            return false;
+        }
+
+        if (file.size() != validSize)
+        {
+            // Drop the records of an interrupted save. The next generation tells the other
+            // stores that the journal did not only grow.
+
+            QDataStream stream(&file);
+
+            if (!file.resize(validSize) || !file.seek(8))
+            {
+                errorString = file.errorString();
+
+                return false;
+            }
+
+            stream << (generation + 1);
+
+            if (stream.status() != QDataStream::Ok)
+            {
+                errorString = file.errorString();
+
+                return false;
+            }
+
+            ++generation;
+        }
+
+        if (!file.seek(validSize) || (file.write(batch) != batch.size()) || !file.flush())
+        {
+            errorString = file.errorString();
+
+            return false;
+        }
+
+        return true;
+    }
+
+public:
+
+    QString                           fileName;
+    QString                           errorString;
+    qint64                            validSize  = 0;       ///< Size of the journal up to its last commit.
+    qint64                            fileSize   = -1;      ///< Size of the journal when last accessed, -1 if none.
+    quint32                           generation = 0;       ///< Increased each time the journal is not only appended.
+    bool                              readOnly   = false;   ///< Never overwrite a journal which cannot be read.
+    quint32                           nextId     = 1;
+
+    // Index of the journal.
+
+    QHash<quint32, NodeEntry>         nodes;
+    QHash<quint32, QVector<quint32> > orders;               ///< Children of the folders.
+    QString                           journalPath;
+
+    // State of the tree as last read or written.
+
+    QHash<quint32, QByteArray>        payloads;             ///< Payloads of the created nodes.
+    QHash<quint32, QVector<quint32> > loadedOrders;         ///< Children of the created folders.
+    QSet<quint32>                     pending;              ///< Folders with children not created yet.
+    QSet<quint32>                     unreadable;           ///< Pending folders which failed to be read.
+    QString                           currentPath;
+};
+
+GmicFilterStore::GmicFilterStore(const QString& fileName)
+    : d(new Private)
+{
+    d->fileName = fileName;
+}
+
+GmicFilterStore::~GmicFilterStore()
+{
+    delete d;
+}
+
+QString GmicFilterStore::fileName() const
+{
+    return d->fileName;
+}
+
+bool GmicFilterStore::exists() const
+{
+    return QFile::exists(d->fileName);
+}
+
+QString GmicFilterStore::errorString() const
+{
+    return d->errorString;
+}
+
+GmicFilterNode* GmicFilterStore::read(QString& currentPath)
+{
+    d->clear();
+
+    GmicFilterNode* const root = new GmicFilterNode(GmicFilterNode::Root);
+    QLockFile lockFile(d->fileName + QLatin1String(".lock"));
+
+    if (!d->lock(lockFile))
+    {
+        // The tree below would replace the journal at the next save.
+
+        d->readOnly = true;
+    }
+    else if (d->index())
+    {
+        d->currentPath = d->journalPath;
+
+        if (d->orders.contains(s_rootId))
+        {
+            d->pending.insert(s_rootId);
+
+            const QList<GmicFilterNode*> children = d->createChildren(s_rootId);
+
+            for (GmicFilterNode* const child : children)
+            {
+                root->add(child);
+            }
+        }
+    }
+
+    if (root->children().isEmpty())
+    {
+        GmicFilterNode* const folder = new GmicFilterNode(GmicFilterNode::RootFolder, root);
+        folder->title                = QObject::tr("My G'MIC Filters");
+    }
+
+    currentPath = d->currentPath;
+
+    return root;
+}
+
+int GmicFilterStore::pendingChildren(const GmicFilterNode* const node) const
+{
+    if (!d->isPending(node))
+    {
+        return 0;
+    }
+
+    int count                       = 0;
+    const QVector<quint32> children = d->orders.value(node->id());
+
+    for (const quint32 child : children)
+    {
+        if (d->nodes.contains(child))
+        {
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+QList<GmicFilterNode*> GmicFilterStore::readChildren(const GmicFilterNode* const node)
+{
+    if (!d->isPending(node))
+    {
+        return QList<GmicFilterNode*>();
+    }
+
+    QLockFile lockFile(d->fileName + QLatin1String(".lock"));
+
+    if (!d->lock(lockFile) || !d->refresh())
+    {
+        qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "Cannot read G'MIC filters from" << d->fileName
+                                           << d->errorString;
+
+        return QList<GmicFilterNode*>();
+    }
+
+    return d->createChildren(node->id());
+}
+
+bool GmicFilterStore::write(GmicFilterNode* const root, const QString& currentPath)
+{
+    if (!root || d->readOnly)
+    {
+        return false;
+    }
+
+    QLockFile lockFile(d->fileName + QLatin1String(".lock"));
+
+    if (!d->lock(lockFile) || !d->refresh())
+    {
+        return false;
+    }
+
+    QList<NodeChange>      changedNodes;
+    QList<OrderChange>     changedOrders;
+    QList<GmicFilterNode*> newNodes;
+    d->collect(root, changedNodes, changedOrders, newNodes);
+
+    const bool pathChanged = (currentPath != d->currentPath);
+
+    if (changedNodes.isEmpty() && changedOrders.isEmpty() && !pathChanged && (d->validSize > 0))
+    {
+        return true;
+    }
+
+    const bool create = (d->validSize == 0);
+    const qint64 base = create ? s_headerSize : d->validSize;
+    QByteArray batch;
+    QList<NodeEntry> entries;
+
+    for (const NodeChange& change : qAsConst(changedNodes))
+    {
+        NodeEntry entry;
+        entry.offset = base + batch.size() + s_recordSize;
+        entry.size   = change.second.size();
+        entries << entry;
+        batch.append(record(NodeRecord, change.first, change.second));
+    }
+
+    for (const OrderChange& change : qAsConst(changedOrders))
+    {
+        batch.append(record(OrderRecord, change.id, orderPayload(change.order)));
+    }
+
+    if (pathChanged)
+    {
+        batch.append(record(PathRecord, s_rootId, pathPayload(currentPath)));
+    }
+
+    batch.append(record(CommitRecord, s_rootId, QByteArray()));
+
+    if (!(create ? d->create(batch) : d->append(batch)))
+    {
+        // The changes are collected again at the next save.
+
+        for (GmicFilterNode* const node : qAsConst(newNodes))
+        {
+            node->setId(s_rootId);
+        }
+
+        return false;
+    }
+
+    for (int i = 0 ; i < changedNodes.size() ; ++i)
+    {
+        d->nodes.insert(changedNodes.at(i).first, entries.at(i));
+        d->payloads.insert(changedNodes.at(i).first, changedNodes.at(i).second);
+    }
+
+    for (const OrderChange& change : qAsConst(changedOrders))
+    {
+        d->orders.insert(change.id, change.order);
+        d->loadedOrders.insert(change.id, change.children);
+    }
+
+    if (pathChanged)
+    {
+        d->currentPath = currentPath;
+        d->journalPath = currentPath;
+    }
+
+    d->validSize = base + batch.size();
+    d->fileSize  = d->validSize;
+
+    if ((d->validSize > s_minCompact) && (d->validSize > 2 * d->liveSize()) && !compact())
+    {
+        // The journal is still valid, only larger than needed.
+
+        qCWarning(DIGIKAM_DPLUGIN_BQM_LOG) << "Cannot compact G'MIC filters journal" << d->fileName
+                                           << d->errorString;
+    }
+
+    return true;
+}
+
+bool GmicFilterStore::compact()
+{
+    // Rebuild the journal from the records reachable from the root. The caller holds the lock
+    // and the index is up to date: a record which cannot be read aborts the compaction.
+
+    QFile current(d->fileName);
+    QByteArray journal;
+
+    if (current.open(QIODevice::ReadOnly))
+    {
+        journal = current.read(d->validSize);
+        current.close();
+    }
+
+    if (journal.size() != d->validSize)
+    {
+        d->errorString = current.errorString();
+
+        return false;
+    }
+
+    QByteArray data = header(d->generation + 1);
+
+    QHash<quint32, NodeEntry>         nodes;
+    QHash<quint32, QVector<quint32> > orders;
+    QQueue<quint32>                   folders;
+    folders.enqueue(s_rootId);
+
+    while (!folders.isEmpty())
+    {
+        const quint32 id = folders.dequeue();
+
+        if (!d->orders.contains(id))
+        {
+            continue;
+        }
+
+        QVector<quint32> children;
+        const QVector<quint32> order = d->orders.value(id);
+
+        for (const quint32 child : order)
+        {
+            if (!d->nodes.contains(child) || nodes.contains(child))
+            {
+                continue;
+            }
+
+            const NodeEntry old = d->nodes.value(child);
+
+            if ((old.offset < s_headerSize) || ((old.offset + old.size) > journal.size()))
+            {
+                d->errorString = QObject::tr("The file %1 contains an invalid record.").arg(d->fileName);
+
+                return false;
+            }
+
+            NodeEntry entry;
+            entry.offset = data.size() + s_recordSize;
+            entry.size   = old.size;
+            nodes.insert(child, entry);
+            data.append(record(NodeRecord, child, journal.mid((int)old.offset, (int)old.size)));
+            children << child;
+            folders.enqueue(child);
+        }
+
+        orders.insert(id, children);
+        data.append(record(OrderRecord, id, orderPayload(children)));
+    }
+
+    data.append(record(PathRecord, s_rootId, pathPayload(d->journalPath)));
+    data.append(record(CommitRecord, s_rootId, QByteArray()));
+
+    QSaveFile file(d->fileName);
+
+    if (!file.open(QIODevice::WriteOnly) || (file.write(data) != data.size()) || !file.commit())
+    {
+        d->errorString = file.errorString();
+
+        return false;
+    }
+
+    qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "Compacted G'MIC filters journal" << d->fileName
+                                     << "to" << data.size() << "bytes";
+
+    // Forget the nodes which are not in the tree anymore.
+
+    for (auto it = d->payloads.begin() ; it != d->payloads.end() ; )
+    {
+        if (nodes.contains(it.key()))
+        {
+            ++it;
+        }
+        else
+        {
+            it = d->payloads.erase(it);
+        }
+    }
+
+    for (auto it = d->pending.begin() ; it != d->pending.end() ; )
+    {
+        if ((*it == s_rootId) || nodes.contains(*it))
+        {
+            ++it;
+        }
+        else
+        {
+            it = d->pending.erase(it);
+        }
+    }
+
+    d->nodes     = nodes;
+    d->orders    = orders;
+    d->validSize = data.size();
+    d->fileSize  = d->validSize;
+    ++d->generation;
+
+    return true;
+}
+
+} // namespace DigikamBqmGmicQtPlugin
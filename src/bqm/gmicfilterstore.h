@@ -0,0 +1,90 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2026-10-17
+ * Description : digiKam Batch Queue Manager plugin for GmicQt.
+ *               Journaled storage of the G'MIC filters tree.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+#pragma once
+
+// Qt includes
+
+#include <QList>
+#include <QString>
+
+namespace DigikamBqmGmicQtPlugin
+{
+
+class GmicFilterNode;
+
+/**
+ * Binary journal of the G'MIC filters tree, an alternative to the XML file for large libraries.
+ * The file is a sequence of records: one per node (title, comment, commands...), one per folder
+ * listing the identifiers of its children, and the current path. A save appends only the records
+ * which changed since the last one, followed by a commit record, and the journal is compacted
+ * when it holds more outdated records than current ones.
+ * Reading the journal only indexes the records: the nodes of a folder are created on demand
+ * with readChildren().
+ * Several stores can share the same journal: each access holds a lock file, and a store indexes
+ * the journal again when another one changed it since its last access.
+ */
+class GmicFilterStore
+{
+
+public:
+
+    explicit GmicFilterStore(const QString& fileName);
+    ~GmicFilterStore();
+
+    QString fileName()                                                 const;
+    bool exists()                                                      const;
+
+    /**
+     * Index the journal and return the root node with its first level of children.
+     * On error, an empty tree is returned and errorString() is set.
+     */
+    GmicFilterNode* read(QString& currentPath);
+
+    /**
+     * Return the number of children of a folder not created yet.
+     */
+    int pendingChildren(const GmicFilterNode* const node)              const;
+
+    /**
+     * Create the children of a folder from the journal, without adding them to the folder.
+     * If they cannot be read, an empty list is returned, and the folder is left as it is
+     * in the journal: pendingChildren() returns 0 and write() does not change its contents.
+     */
+    QList<GmicFilterNode*> readChildren(const GmicFilterNode* const node);
+
+    /**
+     * Append the changes of the tree since the last read or write.
+     * The nodes which were never stored get their identifier here.
+     */
+    bool write(GmicFilterNode* const root, const QString& currentPath);
+
+    QString errorString()                                              const;
+
+private:
+
+    bool compact();
+
+    // Disable
+    GmicFilterStore(const GmicFilterStore&)            = delete;
+    GmicFilterStore& operator=(const GmicFilterStore&) = delete;
+
+private:
+
+    class Private;
+    Private* const d = nullptr;
+};
+
+} // namespace DigikamBqmGmicQtPlugin
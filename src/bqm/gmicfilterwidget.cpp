@@ -26,6 +26,9 @@
 #include <QObject>
 #include <QApplication>
 #include <QGridLayout>
+#include <QLabel>
+#include <QSpinBox>
+#include <QCheckBox>
 
 // digiKam includes
 
@@ -72,6 +75,10 @@ public:
     QAction*              edit             = nullptr;
     QAction*              importdb         = nullptr;
     QAction*              exportdb         = nullptr;
+    QSpinBox*             maxJobs          = nullptr;
+    QSpinBox*             memoryBudget     = nullptr;
+    QSpinBox*             resultCacheSize  = nullptr;
+    QCheckBox*            useWorkers       = nullptr;
     DPluginBqm*           plugin           = nullptr;
 };
 
@@ -146,13 +153,55 @@ GmicFilterWidget::GmicFilterWidget(QWidget* const parent)
     d->search           = new SearchTextBar(this, QLatin1String("DigikamGmicFilterSearchBar"));
     d->search->setObjectName(QLatin1String("search"));
 
+    // ---
+
+    QLabel* const jobsLabel   = new QLabel(tr("Concurrent images:"), this);
+    d->maxJobs                = new QSpinBox(this);
+    d->maxJobs->setRange(0, 256);
+    d->maxJobs->setSpecialValueText(tr("Auto"));
+    d->maxJobs->setToolTip(tr("Maximum number of images processed at the same time.\n"
+                              "Auto processes one image per core. Each image uses a share of the cores."));
+    jobsLabel->setBuddy(d->maxJobs);
+
+    QLabel* const budgetLabel = new QLabel(tr("Memory budget:"), this);
+    d->memoryBudget           = new QSpinBox(this);
+    d->memoryBudget->setRange(0, 1024 * 1024);
+    d->memoryBudget->setSingleStep(512);
+    d->memoryBudget->setSuffix(tr(" MB"));
+    d->memoryBudget->setSpecialValueText(tr("Unlimited"));
+    d->memoryBudget->setToolTip(tr("Memory shared by the images processed at the same time.\n"
+                                   "Large images wait until enough memory is available."));
+    budgetLabel->setBuddy(d->memoryBudget);
+
+    QLabel* const cacheLabel  = new QLabel(tr("Result cache:"), this);
+    d->resultCacheSize        = new QSpinBox(this);
+    d->resultCacheSize->setRange(0, 1024 * 1024);
+    d->resultCacheSize->setSingleStep(1024);
+    d->resultCacheSize->setSuffix(tr(" MB"));
+    d->resultCacheSize->setSpecialValueText(tr("Disabled"));
+    d->resultCacheSize->setToolTip(tr("Disk space used to keep the result of each stage of the chain.\n"
+                                      "When the queue runs again, only the stages which changed are computed.\n"
+                                      "With the cache, each stage of the chain runs as a separate G'MIC command."));
+    cacheLabel->setBuddy(d->resultCacheSize);
+
+    d->useWorkers             = new QCheckBox(tr("Run filters in separate processes"), this);
+    d->useWorkers->setToolTip(tr("Process the images in helper processes instead of the digiKam process.\n"
+                                 "A filter crashing or running out of memory only stops the current image."));
+
     QGridLayout* const grid = new QGridLayout(this);
-    grid->addWidget(d->tree,      0, 0, 1, 6);
-    grid->addWidget(d->addButton, 1, 0, 1, 1);
-    grid->addWidget(d->remButton, 1, 1, 1, 1);
-    grid->addWidget(d->edtButton, 1, 2, 1, 1);
-    grid->addWidget(d->dbButton,  1, 3, 1, 1);
-    grid->addWidget(d->search,    1, 5, 1, 1);
+    grid->addWidget(d->tree,             0, 0, 1, 6);
+    grid->addWidget(d->addButton,        1, 0, 1, 1);
+    grid->addWidget(d->remButton,        1, 1, 1, 1);
+    grid->addWidget(d->edtButton,        1, 2, 1, 1);
+    grid->addWidget(d->dbButton,         1, 3, 1, 1);
+    grid->addWidget(d->search,           1, 5, 1, 1);
+    grid->addWidget(jobsLabel,           2, 0, 1, 4);
+    grid->addWidget(d->maxJobs,          2, 5, 1, 1);
+    grid->addWidget(budgetLabel,         3, 0, 1, 4);
+    grid->addWidget(d->memoryBudget,     3, 5, 1, 1);
+    grid->addWidget(cacheLabel,          4, 0, 1, 4);
+    grid->addWidget(d->resultCacheSize,  4, 5, 1, 1);
+    grid->addWidget(d->useWorkers,       5, 0, 1, 6);
     grid->setColumnStretch(4, 2);
     grid->setColumnStretch(5, 8);
 
@@ -165,7 +214,7 @@ GmicFilterWidget::GmicFilterWidget(QWidget* const parent)
     d->tree->header()->setSectionResizeMode(QHeaderView::Stretch);
 
     connect(d->search, SIGNAL(textChanged(QString)),
-            d->proxyModel, SLOT(setFilterFixedString(QString)));
+            this, SLOT(slotSearchTextChanged(QString)));
 
     connect(d->proxyModel, SIGNAL(signalFilterAccepts(bool)),
             d->search, SLOT(slotSearchResult(bool)));
@@ -200,6 +249,18 @@ GmicFilterWidget::GmicFilterWidget(QWidget* const parent)
     connect(d->tree, SIGNAL(customContextMenuRequested(QPoint)),
             this, SLOT(slotCustomContextMenuRequested(QPoint)));
 
+    connect(d->maxJobs, SIGNAL(valueChanged(int)),
+            this, SIGNAL(signalSettingsChanged()));
+
+    connect(d->memoryBudget, SIGNAL(valueChanged(int)),
+            this, SIGNAL(signalSettingsChanged()));
+
+    connect(d->resultCacheSize, SIGNAL(valueChanged(int)),
+            this, SIGNAL(signalSettingsChanged()));
+
+    connect(d->useWorkers, SIGNAL(toggled(bool)),
+            this, SIGNAL(signalSettingsChanged()));
+
     readSettings();
 }
 
@@ -246,6 +307,8 @@ bool GmicFilterWidget::saveExpandedNodes(const QModelIndex& parent)
 
 void GmicFilterWidget::expandNodes(GmicFilterNode* const node)
 {
+    d->manager->fetchChildren(node);
+
     for (int i = 0 ; i < node->children().count() ; ++i)
     {
         GmicFilterNode* const childNode = node->children().value(i);
@@ -444,6 +507,18 @@ void GmicFilterWidget::slotEdit()
     }
 }
 
+void GmicFilterWidget::slotSearchTextChanged(const QString& text)
+{
+    // The search must see the filters of the folders not loaded yet.
+
+    if (!text.isEmpty())
+    {
+        d->manager->fetchAll(d->manager->commands());
+    }
+
+    d->proxyModel->setFilterFixedString(text);
+}
+
 void GmicFilterWidget::openPropertiesDialog(bool editMode, bool isFilter)
 {
     QModelIndex index = d->tree->currentIndex();
@@ -505,7 +580,12 @@ QMap<QString, QVariant> GmicFilterWidget::currentGmicFilters() const
 
 QString GmicFilterWidget::currentGmicChainedCommands() const
 {
-    QString chained;
+    return currentGmicCommands().join(QLatin1Char(' ')).trimmed();
+}
+
+QStringList GmicFilterWidget::currentGmicCommands() const
+{
+    QStringList commands;
     QMap<QString, QVariant> filters = currentGmicFilters();
 
     if (!filters.isEmpty())
@@ -514,12 +594,11 @@ QString GmicFilterWidget::currentGmicChainedCommands() const
 
         for (const QVariant& v : qAsConst(lst))
         {
-            chained.append(QLatin1Char(' '));
-            chained.append(v.toString());
+            commands.append(v.toString());
         }
     }
 
-    return chained.trimmed();
+    return commands;
 }
 
 QString GmicFilterWidget::currentPath() const
@@ -598,6 +677,7 @@ void GmicFilterWidget::setCurrentPath(const QString& path)
 
     for (const QString& title : qAsConst(hierarchy))
     {
+        d->manager->fetchChildren(node);
         children = node->children();
         qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "Title:" << title;
 
@@ -632,6 +712,46 @@ void GmicFilterWidget::setCurrentPath(const QString& path)
     d->tree->setCurrentIndex(d->proxyModel->mapFromSource(idx));
 }
 
+int GmicFilterWidget::maxJobs() const
+{
+    return d->maxJobs->value();
+}
+
+void GmicFilterWidget::setMaxJobs(int jobs)
+{
+    d->maxJobs->setValue(jobs);
+}
+
+int GmicFilterWidget::memoryBudget() const
+{
+    return d->memoryBudget->value();
+}
+
+void GmicFilterWidget::setMemoryBudget(int megabytes)
+{
+    d->memoryBudget->setValue(megabytes);
+}
+
+int GmicFilterWidget::resultCacheSize() const
+{
+    return d->resultCacheSize->value();
+}
+
+void GmicFilterWidget::setResultCacheSize(int megabytes)
+{
+    d->resultCacheSize->setValue(megabytes);
+}
+
+bool GmicFilterWidget::useWorkers() const
+{
+    return d->useWorkers->isChecked();
+}
+
+void GmicFilterWidget::setUseWorkers(bool useWorkers)
+{
+    d->useWorkers->setChecked(useWorkers);
+}
+
 } // namespace DigikamBqmGmicQtPlugin
 
 #include "moc_gmicfilterwidget.cpp"
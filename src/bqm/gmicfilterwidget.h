@@ -18,6 +18,7 @@
 
 #include <QMap>
 #include <QString>
+#include <QStringList>
 #include <QWidget>
 #include <QDialog>
 #include <QTreeView>
@@ -53,6 +54,32 @@ public:
 
     QString currentGmicChainedCommands()            const;
 
+    /**
+     * The commands of the current chain, one per stage.
+     */
+    QStringList currentGmicCommands()               const;
+
+    /**
+     * Limits of concurrent processing, see GmicBqmScheduler. Null values mean automatic.
+     */
+    int maxJobs()                                   const;
+    void setMaxJobs(int jobs);
+
+    int memoryBudget()                              const;
+    void setMemoryBudget(int megabytes);
+
+    /**
+     * Size of the result cache in MB, see GmicBqmResultCache. A null size disables the cache.
+     */
+    int resultCacheSize()                           const;
+    void setResultCacheSize(int megabytes);
+
+    /**
+     * Run G'MIC in worker processes, see GmicBqmWorkerPool.
+     */
+    bool useWorkers()                               const;
+    void setUseWorkers(bool useWorkers);
+
 Q_SIGNALS:
 
     void signalSettingsChanged();
@@ -66,6 +93,7 @@ private Q_SLOTS:
     void slotAddFolder();
     void slotAddSeparator();
     void slotEdit();
+    void slotSearchTextChanged(const QString&);
 
 private:
 
@@ -15,6 +15,12 @@
 // Qt includes
 
 #include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSize>
 #include <QTextStream>
 #include <QStringList>
 
@@ -40,6 +46,77 @@ extern BqmInfoIface* s_infoIface;
 using namespace DigikamBqmGmicQtPlugin;
 using namespace DigikamGmicQtPluginCommon;
 
+namespace
+{
+
+/**
+ * Decoded previews of the last queue items, keyed by path and modification time.
+ * GmicQt asks for the image size and the cropped images on each preview refresh,
+ * zoom or pan, which would otherwise decode the file from disk every time.
+ */
+struct PreviewCacheEntry
+{
+    QString   path;
+    QDateTime lastModified;
+    DImg      image;
+    QSize     extent;
+};
+
+const int                s_previewCacheMaxSize = 4;
+QMutex                   s_previewCacheMutex;
+QList<PreviewCacheEntry> s_previewCache;                ///< Most recently used first.
+
+PreviewCacheEntry cachedPreview(const QString& path)
+{
+    const QDateTime lastModified = QFileInfo(path).lastModified();
+
+    {
+        QMutexLocker locker(&s_previewCacheMutex);
+
+        for (int i = 0 ; i < s_previewCache.size() ; ++i)
+        {
+            if ((s_previewCache[i].path == path) && (s_previewCache[i].lastModified == lastModified))
+            {
+                s_previewCache.move(i, 0);
+
+                return s_previewCache.first();
+            }
+        }
+    }
+
+    // Decoded without holding the lock.
+
+    PreviewCacheEntry entry;
+    entry.path         = path;
+    entry.lastModified = lastModified;
+    entry.image        = PreviewLoadThread::loadFastSynchronously(path, 1024);
+    entry.extent       = entry.image.size();
+
+    if (!entry.image.isNull())
+    {
+        QMutexLocker locker(&s_previewCacheMutex);
+
+        for (int i = s_previewCache.size() - 1 ; i >= 0 ; --i)
+        {
+            if (s_previewCache[i].path == path)
+            {
+                s_previewCache.removeAt(i);
+            }
+        }
+
+        s_previewCache.prepend(entry);
+
+        while (s_previewCache.size() > s_previewCacheMaxSize)
+        {
+            s_previewCache.removeLast();
+        }
+    }
+
+    return entry;
+}
+
+} // namespace
+
 /**
  * GMic-Qt plugin functions
  * See documentation from GmicQtHost.h for details.
@@ -61,10 +138,9 @@ void getImageSize(int* width,
 
     if (!list.isEmpty())
     {
-        DImg img = PreviewLoadThread::loadFastSynchronously(list.first().info.filePath(),
-                                                            1024);
-        *width   = img.width();
-        *height  = img.height();
+        const QSize extent = cachedPreview(list.first().info.filePath()).extent;
+        *width             = extent.width();
+        *height            = extent.height();
     }
     else
     {
@@ -111,8 +187,7 @@ void getCroppedImages(cimg_library::CImgList<gmic_pixel_type>& images,
         return;
     }
 
-    DImg input_image       = PreviewLoadThread::loadFastSynchronously(list.first().info.filePath(),
-                                                                      1024);
+    DImg input_image       = cachedPreview(list.first().info.filePath()).image;
     const bool entireImage = (
                               (x      < 0.0) &&
                               (y      < 0.0) &&
@@ -153,7 +228,7 @@ void getCroppedImages(cimg_library::CImgList<gmic_pixel_type>& images,
                                           static_cast<int>(1 + std::ceil(height * input_image.height()))
                                          );
 
-    GMicQtImageConverter::convertDImgtoCImg(input_image.copy(ix, iy, iw, ih), images[0]);
+    GMicQtImageConverter::convertDImgtoCImg(input_image, images[0], QRect(ix, iy, iw, ih));
 }
 
 void applyColorProfile(cimg_library::CImg<gmic_pixel_type>& images) // cppcheck-suppress constParameterReference
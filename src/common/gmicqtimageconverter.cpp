@@ -14,14 +14,46 @@
 
 #include "gmicqtimageconverter.h"
 
+// C++ includes
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#   include <emmintrin.h>
+#   define GMICQT_CONVERTER_SSE2 1
+#endif
+
+/**
+ * AVX2 kernels are built for all x86 targets with GCC and Clang, and only used
+ * when the CPU supports them (checked once at run time).
+ * Other compilers only build them when AVX2 is enabled at compile time (/arch:AVX2).
+ */
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#   define GMICQT_CONVERTER_AVX2 1
+#   define GMICQT_AVX2_TARGET
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#   include <immintrin.h>
+#   define GMICQT_CONVERTER_AVX2 1
+#   define GMICQT_CONVERTER_AVX2_DISPATCH 1
+#   define GMICQT_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+// Qt includes
+
+#include <QThread>
+
 // digiKam includes
 
 #include "digikam_debug.h"
 
-namespace DigikamGmicQtPluginCommon
+namespace
 {
 
-inline unsigned char GMicQtImageConverter::float2ucharBounded(const float& in)
+inline unsigned char float2ucharBounded(const float& in)
 {
     return (
             (in < 0.0f) ? 0
@@ -30,7 +62,7 @@ inline unsigned char GMicQtImageConverter::float2ucharBounded(const float& in)
            );
 }
 
-inline unsigned short GMicQtImageConverter::float2ushortBounded(const float& in)
+inline unsigned short float2ushortBounded(const float& in)
 {
     return (
             (in < 0.0f) ? 0
@@ -39,253 +71,414 @@ inline unsigned short GMicQtImageConverter::float2ushortBounded(const float& in)
            );
 }
 
-void GMicQtImageConverter::convertCImgtoDImg(const cimg_library::CImg<float>& in,
-                                             DImg& out, bool sixteenBit)
+#if defined(GMICQT_CONVERTER_AVX2)
+
+bool cpuHasAVX2()
 {
-    Q_ASSERT_X(
-               (in.spectrum() <= 4),
-               "GMicQtImageConverter::convertCImgtoDImg()",
-               QString::fromLatin1("bad input spectrum (%1)").arg(in.spectrum()).toLatin1().data()
-              );
 
-    bool alpha = ((in.spectrum() == 4) || (in.spectrum() == 2));
-    out        = DImg(in.width(), in.height(), sixteenBit, alpha);
+#   if defined(GMICQT_CONVERTER_AVX2_DISPATCH)
+
+    __builtin_cpu_init();
+
+    return __builtin_cpu_supports("avx2");
+
+#   else
+
+    return true;
+
+#   endif
+
+}
+
+const bool s_hasAVX2 = cpuHasAVX2();
+
+#endif
+
+/**
+ * Below this number of pixels, conversions run in the calling thread only.
+ */
+const int s_parallelMinPixels = 256 * 1024;
+
+/**
+ * Run rowFunc(y0, y1) on contiguous bands of rows, in parallel for large images.
+ */
+void parallelRows(int width, int height, const std::function<void(int, int)>& rowFunc)
+{
+    const int maxThreads = std::max(1, QThread::idealThreadCount());
+    const int nbThreads  = ((width * height) < s_parallelMinPixels) ? 1
+                                                                    : std::min(maxThreads, height);
 
-    if      (in.spectrum() == 4) // RGB + Alpha
+    if (nbThreads <= 1)
     {
-        qCDebug(DIGIKAM_DPLUGIN_LOG) << "GMicQt: convert CImg to DImg: RGB+Alpha image"
-                                     << "(" << (sixteenBit+1) * 8 << "bits)";
+        rowFunc(0, height);
 
-        const float* srcR = in.data(0, 0, 0, 0);
-        const float* srcG = in.data(0, 0, 0, 1);
-        const float* srcB = in.data(0, 0, 0, 2);
-        const float* srcA = in.data(0, 0, 0, 3);
-        int height        = out.height();
+        return;
+    }
 
-        for (int y = 0 ; y < height ; ++y)
-        {
-            int n = in.width();
+    std::vector<std::thread> threads;
+    threads.reserve(nbThreads - 1);
 
-            if (sixteenBit)
-            {
-                unsigned short* dst = reinterpret_cast<unsigned short*>(out.scanLine(y));
+    for (int t = 1 ; t < nbThreads ; ++t)
+    {
+        threads.emplace_back(rowFunc, (height * t) / nbThreads, (height * (t + 1)) / nbThreads);
+    }
 
-                while (n--)
-                {
-                    dst[2] = float2ushortBounded(*srcR++) * 256;
-                    dst[1] = float2ushortBounded(*srcG++) * 256;
-                    dst[0] = float2ushortBounded(*srcB++) * 256;
-                    dst[3] = float2ushortBounded(*srcA++) * 256;
-                    dst   += 4;
-                }
-            }
-            else
-            {
-                unsigned char* dst = out.scanLine(y);
+    rowFunc(0, height / nbThreads);
 
-                while (n--)
-                {
-                    dst[2] = float2ucharBounded(*srcR++);
-                    dst[1] = float2ucharBounded(*srcG++);
-                    dst[0] = float2ucharBounded(*srcB++);
-                    dst[3] = float2ucharBounded(*srcA++);
-                    dst   += 4;
-                }
-            }
-        }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+// --- Planar float rows -> interleaved BGRA DImg rows -------------------------------------------------
+
+#if defined(GMICQT_CONVERTER_AVX2)
+
+/**
+ * AVX2 part of rowToBGRA8(), return the number of pixels converted.
+ */
+GMICQT_AVX2_TARGET
+int rowToBGRA8AVX2(const float* srcR, const float* srcG, const float* srcB, const float* srcA,
+                   unsigned char* dst, int n)
+{
+    int x = 0;
+
+    const __m256  zero8 = _mm256_setzero_ps();
+    const __m256  max8  = _mm256_set1_ps(255.0F);
+    const __m256i opaq8 = _mm256_set1_epi32(0xFF);
+
+    for ( ; x + 8 <= n ; x += 8)
+    {
+        const __m256i r = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(srcR + x), zero8), max8));
+        const __m256i g = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(srcG + x), zero8), max8));
+        const __m256i b = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(srcB + x), zero8), max8));
+        const __m256i a = srcA ? _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(srcA + x), zero8), max8))
+                               : opaq8;
+        const __m256i p = _mm256_or_si256(_mm256_or_si256(b, _mm256_slli_epi32(g, 8)),
+                                          _mm256_or_si256(_mm256_slli_epi32(r, 16), _mm256_slli_epi32(a, 24)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 4 * x), p);
     }
-    else if (in.spectrum() == 3) // RGB
+
+    return x;
+}
+
+#endif
+
+/**
+ * Convert one row of planar float channels to interleaved 8-bit BGRA.
+ * Gray images use the same plane for R, G and B, and images without alpha use a null alpha plane.
+ * Values are clamped to [0,255] then truncated, as float2ucharBounded() does.
+ */
+void rowToBGRA8(const float* srcR, const float* srcG, const float* srcB, const float* srcA,
+                unsigned char* dst, int n)
+{
+    int x = 0;
+
+#if defined(GMICQT_CONVERTER_AVX2)
+
+    if (s_hasAVX2)
     {
-        qCDebug(DIGIKAM_DPLUGIN_LOG) << "GMicQt: convert CImg to DImg: RGB image"
-                                     << "(" << (sixteenBit+1) * 8 << "bits)";
+        x = rowToBGRA8AVX2(srcR, srcG, srcB, srcA, dst, n);
+    }
 
-        const float* srcR = in.data(0, 0, 0, 0);
-        const float* srcG = in.data(0, 0, 0, 1);
-        const float* srcB = in.data(0, 0, 0, 2);
-        int height        = out.height();
+#endif
 
-        for (int y = 0 ; y < height ; ++y)
-        {
-            int n = in.width();
+#if defined(GMICQT_CONVERTER_SSE2)
 
-            if (sixteenBit)
-            {
-                unsigned short* dst = reinterpret_cast<unsigned short*>(out.scanLine(y));
+    const __m128  zero4 = _mm_setzero_ps();
+    const __m128  max4  = _mm_set1_ps(255.0F);
+    const __m128i opaq4 = _mm_set1_epi32(0xFF);
 
-                while (n--)
-                {
-                    dst[2] = float2ushortBounded(*srcR++) * 256;
-                    dst[1] = float2ushortBounded(*srcG++) * 256;
-                    dst[0] = float2ushortBounded(*srcB++) * 256;
-                    dst[3] = 0xFFFF;
-                    dst   += 4;
-                }
-            }
-            else
-            {
-                unsigned char* dst = out.scanLine(y);
+    for ( ; x + 4 <= n ; x += 4)
+    {
+        const __m128i r = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(srcR + x), zero4), max4));
+        const __m128i g = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(srcG + x), zero4), max4));
+        const __m128i b = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(srcB + x), zero4), max4));
+        const __m128i a = srcA ? _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(srcA + x), zero4), max4))
+                               : opaq4;
+        const __m128i p = _mm_or_si128(_mm_or_si128(b, _mm_slli_epi32(g, 8)),
+                                       _mm_or_si128(_mm_slli_epi32(r, 16), _mm_slli_epi32(a, 24)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * x), p);
+    }
 
-                while (n--)
-                {
-                    dst[2] = float2ucharBounded(*srcR++);
-                    dst[1] = float2ucharBounded(*srcG++);
-                    dst[0] = float2ucharBounded(*srcB++);
-                    dst[3] = 0xFF;
-                    dst   += 4;
-                }
-            }
+#endif
+
+    for ( ; x < n ; ++x)
+    {
+        unsigned char* const d = dst + 4 * x;
+        d[2]                   = float2ucharBounded(srcR[x]);
+        d[1]                   = float2ucharBounded(srcG[x]);
+        d[0]                   = float2ucharBounded(srcB[x]);
+        d[3]                   = srcA ? float2ucharBounded(srcA[x]) : 0xFF;
+    }
+}
+
+/**
+ * Convert one row of planar float channels to interleaved 16-bit BGRA.
+ * Values are clamped to [0,65535], truncated and multiplied by 256 (modulo 2^16),
+ * as float2ushortBounded() * 256 does.
+ */
+void rowToBGRA16(const float* srcR, const float* srcG, const float* srcB, const float* srcA,
+                 unsigned short* dst, int n)
+{
+    int x = 0;
+
+#if defined(GMICQT_CONVERTER_SSE2)
+
+    const __m128  zero4 = _mm_setzero_ps();
+    const __m128  max4  = _mm_set1_ps(65535.0F);
+    const __m128i low16 = _mm_set1_epi32(0xFFFF);
+    const __m128i opaq4 = _mm_set1_epi32(0xFFFF);
+
+    for ( ; x + 4 <= n ; x += 4)
+    {
+        const __m128i r  = _mm_and_si128(_mm_slli_epi32(_mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(srcR + x), zero4), max4)), 8), low16);
+        const __m128i g  = _mm_and_si128(_mm_slli_epi32(_mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(srcG + x), zero4), max4)), 8), low16);
+        const __m128i b  = _mm_and_si128(_mm_slli_epi32(_mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(srcB + x), zero4), max4)), 8), low16);
+        const __m128i a  = srcA ? _mm_and_si128(_mm_slli_epi32(_mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(srcA + x), zero4), max4)), 8), low16)
+                                : opaq4;
+        const __m128i bg = _mm_or_si128(b, _mm_slli_epi32(g, 16));
+        const __m128i ra = _mm_or_si128(r, _mm_slli_epi32(a, 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * x),     _mm_unpacklo_epi32(bg, ra));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * x + 8), _mm_unpackhi_epi32(bg, ra));
+    }
+
+#endif
+
+    for ( ; x < n ; ++x)
+    {
+        unsigned short* const d = dst + 4 * x;
+        d[2]                    = float2ushortBounded(srcR[x]) * 256;
+        d[1]                    = float2ushortBounded(srcG[x]) * 256;
+        d[0]                    = float2ushortBounded(srcB[x]) * 256;
+        d[3]                    = srcA ? float2ushortBounded(srcA[x]) * 256 : 0xFFFF;
+    }
+}
+
+// --- Interleaved BGRA DImg rows -> planar float rows -------------------------------------------------
+
+#if defined(GMICQT_CONVERTER_AVX2)
+
+/**
+ * AVX2 part of rowFromBGRA8(), return the number of pixels converted.
+ */
+GMICQT_AVX2_TARGET
+int rowFromBGRA8AVX2(const unsigned char* src, float* dstR, float* dstG, float* dstB, float* dstA, int n)
+{
+    int x = 0;
+
+    const __m256i mask8 = _mm256_set1_epi32(0xFF);
+
+    for ( ; x + 8 <= n ; x += 8)
+    {
+        const __m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + 4 * x));
+        _mm256_storeu_ps(dstB + x, _mm256_cvtepi32_ps(_mm256_and_si256(p, mask8)));
+        _mm256_storeu_ps(dstG + x, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p, 8), mask8)));
+        _mm256_storeu_ps(dstR + x, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(p, 16), mask8)));
+
+        if (dstA)
+        {
+            _mm256_storeu_ps(dstA + x, _mm256_cvtepi32_ps(_mm256_srli_epi32(p, 24)));
         }
     }
-    else if (in.spectrum() == 2) // Gray levels + Alpha
+
+    return x;
+}
+
+#endif
+
+void rowFromBGRA8(const unsigned char* src, float* dstR, float* dstG, float* dstB, float* dstA, int n)
+{
+    int x = 0;
+
+#if defined(GMICQT_CONVERTER_AVX2)
+
+    if (s_hasAVX2)
     {
-        qCDebug(DIGIKAM_DPLUGIN_LOG) << "GMicQt: convert CImg to DImg: Gray+Alpha image"
-                                     << "(" << (sixteenBit+1) * 8 << "bits)";
+        x = rowFromBGRA8AVX2(src, dstR, dstG, dstB, dstA, n);
+    }
+
+#endif
+
+#if defined(GMICQT_CONVERTER_SSE2)
+
+    const __m128i mask4 = _mm_set1_epi32(0xFF);
 
-        const float* src  = in.data(0, 0, 0, 0);
-        const float* srcA = in.data(0, 0, 0, 1);
-        int height        = out.height();
+    for ( ; x + 4 <= n ; x += 4)
+    {
+        const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * x));
+        _mm_storeu_ps(dstB + x, _mm_cvtepi32_ps(_mm_and_si128(p, mask4)));
+        _mm_storeu_ps(dstG + x, _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 8), mask4)));
+        _mm_storeu_ps(dstR + x, _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(p, 16), mask4)));
 
-        for (int y = 0 ; y < height ; ++y)
+        if (dstA)
         {
-            int n = in.width();
+            _mm_storeu_ps(dstA + x, _mm_cvtepi32_ps(_mm_srli_epi32(p, 24)));
+        }
+    }
 
-            if (sixteenBit)
-            {
-                unsigned short* dst = reinterpret_cast<unsigned short*>(out.scanLine(y));
+#endif
 
-                while (n--)
-                {
-                    dst[2] = float2ushortBounded(*src) * 256;
-                    dst[1] = float2ushortBounded(*src) * 256;
-                    dst[0] = float2ushortBounded(*src) * 256;
-                    dst[3] = float2ushortBounded(*srcA++) * 256;
-                    src++;
-                    dst   += 4;
-                }
-            }
-            else
-            {
-                unsigned char* dst = out.scanLine(y);
+    for ( ; x < n ; ++x)
+    {
+        const unsigned char* const s = src + 4 * x;
+        dstB[x]                      = static_cast<float>(s[0]);
+        dstG[x]                      = static_cast<float>(s[1]);
+        dstR[x]                      = static_cast<float>(s[2]);
 
-                while (n--)
-                {
-                    dst[2] = float2ucharBounded(*src);
-                    dst[1] = float2ucharBounded(*src);
-                    dst[0] = float2ucharBounded(*src);
-                    dst[3] = float2ucharBounded(*srcA++);
-                    src++;
-                    dst   += 4;
-                }
-            }
+        if (dstA)
+        {
+            dstA[x] = static_cast<float>(s[3]);
         }
     }
-    else // Gray levels
+}
+
+/**
+ * 16-bit values are divided by 255 (the historical scaling of this converter).
+ * A single-precision division gives the same result as the former
+ * double-precision division rounded to float (double rounding is innocuous here).
+ */
+void rowFromBGRA16(const unsigned short* src, float* dstR, float* dstG, float* dstB, float* dstA, int n)
+{
+    int x = 0;
+
+#if defined(GMICQT_CONVERTER_SSE2)
+
+    const __m128  div4  = _mm_set1_ps(255.0F);
+    const __m128i zero  = _mm_setzero_si128();
+
+    for ( ; x + 4 <= n ; x += 4)
     {
-        qCDebug(DIGIKAM_DPLUGIN_LOG) << "GMicQt: convert CImg to DImg: Gray image"
-                                     << "(" << (sixteenBit+1) * 8 << "bits)";
+        const __m128i p01 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * x));
+        const __m128i p23 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * x + 8));
+        __m128 c0         = _mm_cvtepi32_ps(_mm_unpacklo_epi16(p01, zero));     // B0 G0 R0 A0
+        __m128 c1         = _mm_cvtepi32_ps(_mm_unpackhi_epi16(p01, zero));     // B1 G1 R1 A1
+        __m128 c2         = _mm_cvtepi32_ps(_mm_unpacklo_epi16(p23, zero));     // B2 G2 R2 A2
+        __m128 c3         = _mm_cvtepi32_ps(_mm_unpackhi_epi16(p23, zero));     // B3 G3 R3 A3
+        _MM_TRANSPOSE4_PS(c0, c1, c2, c3);                                      // B, G, R, A
+        _mm_storeu_ps(dstB + x, _mm_div_ps(c0, div4));
+        _mm_storeu_ps(dstG + x, _mm_div_ps(c1, div4));
+        _mm_storeu_ps(dstR + x, _mm_div_ps(c2, div4));
+
+        if (dstA)
+        {
+            _mm_storeu_ps(dstA + x, _mm_div_ps(c3, div4));
+        }
+    }
+
+#endif
 
-        const float* src  = in.data(0, 0, 0, 0);
-        int height        = out.height();
+    for ( ; x < n ; ++x)
+    {
+        const unsigned short* const s = src + 4 * x;
+        dstB[x]                       = static_cast<float>(s[0]) / 255.0F;
+        dstG[x]                       = static_cast<float>(s[1]) / 255.0F;
+        dstR[x]                       = static_cast<float>(s[2]) / 255.0F;
 
-        for (int y = 0 ; y < height ; ++y)
+        if (dstA)
         {
-            int n = in.width();
+            dstA[x] = static_cast<float>(s[3]) / 255.0F;
+        }
+    }
+}
+
+} // namespace
+
+namespace DigikamGmicQtPluginCommon
+{
+
+void GMicQtImageConverter::convertCImgtoDImg(const cimg_library::CImg<float>& in,
+                                             DImg& out, bool sixteenBit)
+{
+    Q_ASSERT_X(
+               (in.spectrum() <= 4),
+               "GMicQtImageConverter::convertCImgtoDImg()",
+               QString::fromLatin1("bad input spectrum (%1)").arg(in.spectrum()).toLatin1().data()
+              );
+
+    const bool alpha = ((in.spectrum() == 4) || (in.spectrum() == 2));
+    const bool color = (in.spectrum() >= 3);
+
+    if (
+        out.isNull()                             ||
+        ((int)out.width()  != in.width())        ||
+        ((int)out.height() != in.height())       ||
+        (out.sixteenBit()  != sixteenBit)        ||
+        (out.hasAlpha()    != alpha)
+       )
+    {
+        // Allocate without copying anything, and keep metadata.
+
+        out.putImageData(in.width(), in.height(), sixteenBit, alpha, nullptr);
+    }
+
+    qCDebug(DIGIKAM_DPLUGIN_LOG) << "GMicQt: convert CImg to DImg:"
+                                 << (color ? "RGB" : "Gray") << (alpha ? "+Alpha" : "") << "image"
+                                 << "(" << (sixteenBit+1) * 8 << "bits)";
+
+    const int width  = in.width();
+    const int height = out.height();
 
-            if (sixteenBit)
+    parallelRows(width, height, [&in, &out, sixteenBit, alpha, color, width](int y0, int y1)
+        {
+            for (int y = y0 ; y < y1 ; ++y)
             {
-                unsigned short* dst = reinterpret_cast<unsigned short*>(out.scanLine(y));
+                const float* srcR = in.data(0, y, 0, 0);
+                const float* srcG = color ? in.data(0, y, 0, 1) : srcR;
+                const float* srcB = color ? in.data(0, y, 0, 2) : srcR;
+                const float* srcA = alpha ? in.data(0, y, 0, in.spectrum() - 1) : nullptr;
 
-                while (n--)
+                if (sixteenBit)
                 {
-                    dst[2] = float2ushortBounded(*src) * 256;
-                    dst[1] = float2ushortBounded(*src) * 256;
-                    dst[0] = float2ushortBounded(*src) * 256;
-                    dst[3] = 0xFFFF;
-                    src++;
-                    dst   += 4;
+                    rowToBGRA16(srcR, srcG, srcB, srcA, reinterpret_cast<unsigned short*>(out.scanLine(y)), width);
                 }
-            }
-            else
-            {
-                unsigned char* dst = out.scanLine(y);
-
-                while (n--)
+                else
                 {
-                    dst[2] = float2ucharBounded(*src);
-                    dst[1] = float2ucharBounded(*src);
-                    dst[0] = float2ucharBounded(*src);
-                    dst[3] = 0xFF;
-                    src++;
-                    dst   += 4;
+                    rowToBGRA8(srcR, srcG, srcB, srcA, out.scanLine(y), width);
                 }
             }
         }
-    }
+    );
 }
 
 void GMicQtImageConverter::convertDImgtoCImg(const DImg& in,
-                                             cimg_library::CImg<float>& out)
+                                             cimg_library::CImg<float>& out,
+                                             const QRect& area)
 {
-    const int w      = in.width();
-    const int h      = in.height();
+    const QRect rect = area.isNull() ? QRect(0, 0, in.width(), in.height())
+                                     : area.intersected(QRect(0, 0, in.width(), in.height()));
+    const int w      = rect.width();
+    const int h      = rect.height();
+    const int offset = rect.x() * in.bytesDepth();
     const bool alpha = in.hasAlpha();
     out.assign(w, h, 1, alpha ? 4 : 3);
 
-    float* dstR = out.data(0, 0, 0, 0);
-    float* dstG = out.data(0, 0, 0, 1);
-    float* dstB = out.data(0, 0, 0, 2);
-    float* dstA = nullptr;
-
-    if (alpha)
-    {
-        dstA = out.data(0, 0, 0, 3);
-    }
-
     qCDebug(DIGIKAM_DPLUGIN_LOG) << "GMicQt: convert DImg to CImg:"
                                  << (in.sixteenBit() + 1) * 8 << "bits image"
                                  << "with alpha channel:" << alpha;
 
-    for (int y = 0 ; y < h ; ++y)
-    {
-        if (in.sixteenBit())
+    parallelRows(w, h, [&in, &out, &rect, offset, alpha, w](int y0, int y1)
         {
-            const unsigned short* src = reinterpret_cast<unsigned short*>(in.scanLine(y));
-            int n                     = in.width();
-
-            while (n--)
+            for (int y = y0 ; y < y1 ; ++y)
             {
-                *dstB++ = static_cast<float>(src[0] / 255.0);
-                *dstG++ = static_cast<float>(src[1] / 255.0);
-                *dstR++ = static_cast<float>(src[2] / 255.0);
+                float* dstR      = out.data(0, y, 0, 0);
+                float* dstG      = out.data(0, y, 0, 1);
+                float* dstB      = out.data(0, y, 0, 2);
+                float* dstA      = alpha ? out.data(0, y, 0, 3) : nullptr;
+                const uchar* src = in.scanLine(rect.y() + y) + offset;
 
-                if (alpha)
+                if (in.sixteenBit())
                 {
-                    *dstA++ = static_cast<float>(src[3] / 255.0);
+                    rowFromBGRA16(reinterpret_cast<const unsigned short*>(src), dstR, dstG, dstB, dstA, w);
                 }
-
-                src    += 4;
-            }
-        }
-        else
-        {
-            const unsigned char* src = in.scanLine(y);
-            int n                    = in.width();
-
-            while (n--)
-            {
-                *dstB++ = static_cast<float>(src[0]);
-                *dstG++ = static_cast<float>(src[1]);
-                *dstR++ = static_cast<float>(src[2]);
-
-                if (alpha)
+                else
                 {
-                    *dstA++ = static_cast<float>(src[3]);
+                    rowFromBGRA8(src, dstR, dstG, dstB, dstA, w);
                 }
-
-                src    += 4;
             }
         }
-    }
+    );
 }
 
 } // namespace DigikamGmicQtPluginCommon
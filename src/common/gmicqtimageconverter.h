@@ -14,6 +14,10 @@
 
 #pragma once
 
+// Qt includes
+
+#include <QRect>
+
 // digiKam includes
 
 #include "dimg.h"
@@ -29,22 +33,28 @@ namespace DigikamGmicQtPluginCommon
 
 /**
  * Helper methods for Digikam::DImg to CImg image data container conversions and vis-versa.
+ * Rows are converted with SSE2/AVX2 kernels when available (scalar code otherwise),
+ * AVX2 being selected at run time, and large images are split in bands of rows
+ * processed in parallel.
  */
 class GMicQtImageConverter
 {
 
 public:
 
+    /**
+     * Write the pixels in out, without touching its metadata. The data of out
+     * is reused when it already has the right geometry and depth.
+     */
     static void convertCImgtoDImg(const cimg_library::CImg<float>& in,
                                   DImg& out, bool sixteenBit);
 
+    /**
+     * Read the pixels of area (the whole image if null) directly from the scanlines of in.
+     */
     static void convertDImgtoCImg(const DImg& in,
-                                  cimg_library::CImg<float>& out);
-
-private:
-
-    static unsigned char  float2ucharBounded(const float& in);
-    static unsigned short float2ushortBounded(const float& in);
+                                  cimg_library::CImg<float>& out,
+                                  const QRect& area = QRect());
 
 private:
 
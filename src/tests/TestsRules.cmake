@@ -33,10 +33,41 @@ target_link_libraries(GmicQt_FilterSelector_test
 
 ###
 
+set(FiltersModelReader_test_SRCS
+    ${CMAKE_SOURCE_DIR}/src/tests/host_test.cpp
+    ${CMAKE_SOURCE_DIR}/src/tests/main_filtersmodelreader.cpp
+)
+
+foreach(_file ${FiltersModelReader_test_SRCS})
+    set_property(SOURCE ${_file} PROPERTY COMPILE_DEFINITIONS ${modern_qt_definitions})
+endforeach()
+
+add_executable(GmicQt_FiltersModelReader_test
+               ${gmic_qt_QRC}
+               ${gmic_qt_QM}
+               ${FiltersModelReader_test_SRCS}
+)
+
+target_link_libraries(GmicQt_FiltersModelReader_test
+                      PRIVATE
+
+                      gmic_qt_common
+
+                      Digikam::digikamcore
+
+                      ${gmic_qt_LIBRARIES}
+)
+
+###
+
 include_directories(${CMAKE_SOURCE_DIR}/src/bqm/)
 
 set(Processor_test_SRCS
     ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmprocessor.cpp
+    ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmresultcache.cpp
+    ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmscheduler.cpp
+    ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmworker.cpp
+    ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmworkerpool.cpp
 
     ${CMAKE_SOURCE_DIR}/src/tests/host_test.cpp
     ${CMAKE_SOURCE_DIR}/src/tests/main_processor.cpp
@@ -61,3 +92,139 @@ target_link_libraries(GmicQt_Processor_test
 
                       ${gmic_qt_LIBRARIES}
 )
+
+###
+
+set(BatchBenchmark_test_SRCS
+    ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmprocessor.cpp
+    ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmresultcache.cpp
+    ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmscheduler.cpp
+    ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmworker.cpp
+    ${CMAKE_SOURCE_DIR}/src/bqm/gmicbqmworkerpool.cpp
+
+    ${CMAKE_SOURCE_DIR}/src/tests/host_test.cpp
+    ${CMAKE_SOURCE_DIR}/src/tests/main_batchbenchmark.cpp
+)
+
+foreach(_file ${BatchBenchmark_test_SRCS})
+    set_property(SOURCE ${_file} PROPERTY COMPILE_DEFINITIONS ${modern_qt_definitions})
+endforeach()
+
+add_executable(GmicQt_BatchBenchmark_test
+               ${gmic_qt_QRC}
+               ${gmic_qt_QM}
+               ${BatchBenchmark_test_SRCS}
+)
+
+target_link_libraries(GmicQt_BatchBenchmark_test
+                      PRIVATE
+
+                      gmic_qt_common
+
+                      Digikam::digikamcore
+
+                      ${gmic_qt_LIBRARIES}
+)
+
+if(WIN32)
+
+    target_link_libraries(GmicQt_BatchBenchmark_test PRIVATE psapi)
+
+endif()
+
+###
+
+set(Fusion_test_SRCS
+    ${CMAKE_SOURCE_DIR}/src/tests/main_fusion.cpp
+)
+
+foreach(_file ${Fusion_test_SRCS})
+    set_property(SOURCE ${_file} PROPERTY COMPILE_DEFINITIONS ${modern_qt_definitions})
+endforeach()
+
+add_executable(GmicQt_Fusion_test
+               ${Fusion_test_SRCS}
+)
+
+target_link_libraries(GmicQt_Fusion_test
+                      PRIVATE
+
+                      gmic_qt_common
+
+                      Digikam::digikamcore
+
+                      ${gmic_qt_LIBRARIES}
+)
+
+###
+
+set(FilterStore_test_SRCS
+    ${CMAKE_SOURCE_DIR}/src/bqm/gmicfilternode.cpp
+    ${CMAKE_SOURCE_DIR}/src/bqm/gmicfilterstore.cpp
+
+    ${CMAKE_SOURCE_DIR}/src/tests/main_filterstore.cpp
+)
+
+foreach(_file ${FilterStore_test_SRCS})
+    set_property(SOURCE ${_file} PROPERTY COMPILE_DEFINITIONS ${modern_qt_definitions})
+endforeach()
+
+add_executable(GmicQt_FilterStore_test
+               ${FilterStore_test_SRCS}
+)
+
+target_link_libraries(GmicQt_FilterStore_test
+                      PRIVATE
+
+                      Digikam::digikamcore
+
+                      ${gmic_qt_LIBRARIES}
+)
+
+###
+
+set(MathParser_test_SRCS
+    ${CMAKE_SOURCE_DIR}/src/tests/main_mathparser.cpp
+)
+
+foreach(_file ${MathParser_test_SRCS})
+    set_property(SOURCE ${_file} PROPERTY COMPILE_DEFINITIONS ${modern_qt_definitions})
+endforeach()
+
+add_executable(GmicQt_MathParser_test
+               ${MathParser_test_SRCS}
+)
+
+target_link_libraries(GmicQt_MathParser_test
+                      PRIVATE
+
+                      gmic_qt_common
+
+                      Digikam::digikamcore
+
+                      ${gmic_qt_LIBRARIES}
+)
+
+###
+
+set(ImageConverter_test_SRCS
+    ${CMAKE_SOURCE_DIR}/src/tests/main_imageconverter.cpp
+)
+
+foreach(_file ${ImageConverter_test_SRCS})
+    set_property(SOURCE ${_file} PROPERTY COMPILE_DEFINITIONS ${modern_qt_definitions})
+endforeach()
+
+add_executable(GmicQt_ImageConverter_test
+               ${ImageConverter_test_SRCS}
+)
+
+target_link_libraries(GmicQt_ImageConverter_test
+                      PRIVATE
+
+                      gmic_qt_common
+
+                      Digikam::digikamcore
+
+                      ${gmic_qt_LIBRARIES}
+)
@@ -0,0 +1,452 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2026-10-17
+ * Description : digiKam GmicQt batch throughput benchmark of the BQM processor.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+// C++ includes
+
+#include <algorithm>
+#include <cmath>
+
+// Qt includes
+
+#include <QApplication>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRunnable>
+#include <QTextStream>
+#include <QThreadPool>
+#include <QVector>
+
+#ifdef Q_OS_WIN
+#   include <windows.h>
+#   include <psapi.h>
+#else
+#   include <sys/resource.h>
+#endif
+
+// digiKam includes
+
+#include "digikam_debug.h"
+#include "dpluginloader.h"
+#include "dimg.h"
+
+// local includes
+
+#include "gmicbqmprocessor.h"
+#include "gmicbqmresultcache.h"
+#include "gmicbqmscheduler.h"
+
+namespace DigikamBqmGmicQtPlugin
+{
+
+QString s_imagePath;
+
+} // namespace DigikamBqmGmicQtPlugin
+
+using namespace Digikam;
+using namespace DigikamBqmGmicQtPlugin;
+
+namespace
+{
+
+/**
+ * Chain used when none is given on the command line, as in GmicQt_Processor_test.
+ */
+const char* const s_defaultChain = "gcd_aurora 6,1,0 | gcd_auto_balance 30,0,0,1,0 | fx_old_photo 200,50,85";
+
+struct JobResult
+{
+    bool   loaded     = false;
+    bool   completed  = false;
+    double loadMs     = 0.0;
+    double processMs  = 0.0;
+};
+
+/**
+ * Run a command on an image with the processor, as the BQM tool does.
+ * Return the processing time in ms, or a negative value on failure.
+ */
+double runProcessor(DImg& image, const QStringList& stages, int threads, bool useWorkers)
+{
+    GmicBqmProcessor processor;
+    processor.setInputImage(image);
+    processor.setThreadCount(threads);
+    processor.setChainStages(stages);
+    processor.setUseWorkers(useWorkers);
+
+    if (!processor.setProcessingCommand(stages.join(QLatin1Char(' '))))
+    {
+        return -1.0;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QEventLoop loop;
+
+    QObject::connect(&processor, SIGNAL(signalDone(QString)),
+                     &loop, SLOT(quit()));
+
+    processor.startProcessing();
+    loop.exec();
+
+    const double elapsed = timer.nsecsElapsed() / 1.0e6;
+
+    if (!processor.processingComplete())
+    {
+        return -1.0;
+    }
+
+    processor.outputImage(image);
+
+    return elapsed;
+}
+
+class BenchmarkJob : public QRunnable
+{
+public:
+
+    BenchmarkJob(const QString& path, const QStringList& stages, int threads, bool useWorkers, JobResult* const result)
+        : m_path      (path),
+          m_stages    (stages),
+          m_threads   (threads),
+          m_useWorkers(useWorkers),
+          m_result    (result)
+    {
+    }
+
+    void run() override
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        DImg image;
+        m_result->loaded = image.load(m_path);
+        m_result->loadMs = timer.nsecsElapsed() / 1.0e6;
+
+        if (!m_result->loaded)
+        {
+            qCWarning(DIGIKAM_TESTS_LOG) << "Cannot load" << m_path;
+
+            return;
+        }
+
+        m_result->processMs = runProcessor(image, m_stages, m_threads, m_useWorkers);
+        m_result->completed = (m_result->processMs >= 0.0);
+    }
+
+private:
+
+    QString          m_path;
+    QStringList      m_stages;
+    int              m_threads;
+    bool             m_useWorkers;
+    JobResult* const m_result;
+};
+
+double percentile(QList<double> values, double p)
+{
+    if (values.isEmpty())
+    {
+        return 0.0;
+    }
+
+    // Nearest-rank method.
+
+    std::sort(values.begin(), values.end());
+    const int rank = (int)std::ceil(p / 100.0 * values.size());
+
+    return values[qBound(1, rank, (int)values.size()) - 1];
+}
+
+qint64 peakResidentMemory()
+{
+
+#ifdef Q_OS_WIN
+
+    PROCESS_MEMORY_COUNTERS counters;
+
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return (qint64)counters.PeakWorkingSetSize;
+    }
+
+    return 0;
+
+#else
+
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+
+#   ifdef Q_OS_MACOS
+
+    return (qint64)usage.ru_maxrss;             // In bytes.
+
+#   else
+
+    return (qint64)usage.ru_maxrss * 1024;      // In KB.
+
+#   endif
+
+#endif
+
+}
+
+QStringList parseChain(const QString& chain)
+{
+    QStringList stages;
+    const QStringList parts = chain.split(QLatin1Char('|'));
+
+    for (const QString& part : parts)
+    {
+        if (!part.trimmed().isEmpty())
+        {
+            stages << part.trimmed();
+        }
+    }
+
+    return stages;
+}
+
+/**
+ * Time each stage of a chain on one image, running the stages one after the other,
+ * without the result cache.
+ */
+QJsonArray stageTimings(const QString& path, const QStringList& stages, int threads, bool useWorkers, int cacheSize)
+{
+    QJsonArray timings;
+    DImg image;
+
+    if (!image.load(path))
+    {
+        return timings;
+    }
+
+    GmicBqmResultCache::setMaxSize(0);
+
+    for (const QString& stage : stages)
+    {
+        QJsonObject timing;
+        timing[QLatin1String("command")] = stage;
+        timing[QLatin1String("ms")]      = runProcessor(image, QStringList() << stage, threads, useWorkers);
+        timings.append(timing);
+    }
+
+    GmicBqmResultCache::setMaxSize(cacheSize);
+
+    return timings;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QApplication app(argc, argv);
+
+    DPluginLoader::instance()->init();
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QLatin1String("Batch throughput benchmark of the G'MIC BQM processor.\n"
+                                                   "Stages of a chain are separated with '|'."));
+    parser.addVersionOption();
+    parser.addHelpOption();
+    parser.addPositionalArgument(QLatin1String("directory"), QLatin1String("Directory of images to process"));
+
+    QCommandLineOption chainOption(QStringList() << QLatin1String("c") << QLatin1String("chain"),
+                                   QLatin1String("G'MIC chain to run, can be repeated"), QLatin1String("chain"));
+    QCommandLineOption chainsFileOption(QLatin1String("chains-file"),
+                                        QLatin1String("File with one G'MIC chain per line"), QLatin1String("file"));
+    QCommandLineOption jobsOption(QStringList() << QLatin1String("j") << QLatin1String("jobs"),
+                                  QLatin1String("Images processed at once (default: one per core)"), QLatin1String("count"), QLatin1String("0"));
+    QCommandLineOption cacheOption(QLatin1String("cache"),
+                                   QLatin1String("Size of the result cache in MB (default: disabled)"), QLatin1String("MB"), QLatin1String("0"));
+    QCommandLineOption workersOption(QLatin1String("workers"),
+                                     QLatin1String("Run G'MIC in worker processes"));
+    QCommandLineOption noStagesOption(QLatin1String("no-stages"),
+                                      QLatin1String("Skip the per-stage timings"));
+    QCommandLineOption outputOption(QStringList() << QLatin1String("o") << QLatin1String("output"),
+                                    QLatin1String("JSON report file (default: standard output)"), QLatin1String("file"));
+
+    parser.addOption(chainOption);
+    parser.addOption(chainsFileOption);
+    parser.addOption(jobsOption);
+    parser.addOption(cacheOption);
+    parser.addOption(workersOption);
+    parser.addOption(noStagesOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    if (parser.positionalArguments().isEmpty())
+    {
+        qCDebug(DIGIKAM_TESTS_LOG) << "Image directory is missing...";
+
+        return -1;
+    }
+
+    const QDir dir(parser.positionalArguments().constFirst());
+    QStringList paths;
+    const QStringList files = dir.entryList(QDir::Files | QDir::Readable, QDir::Name);
+
+    for (const QString& file : files)
+    {
+        paths << dir.absoluteFilePath(file);
+    }
+
+    QStringList chains = parser.values(chainOption);
+
+    if (parser.isSet(chainsFileOption))
+    {
+        QFile file(parser.value(chainsFileOption));
+
+        if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            QTextStream stream(&file);
+
+            while (!stream.atEnd())
+            {
+                const QString line = stream.readLine().trimmed();
+
+                if (!line.isEmpty() && !line.startsWith(QLatin1Char('#')))
+                {
+                    chains << line;
+                }
+            }
+        }
+    }
+
+    if (chains.isEmpty())
+    {
+        chains << QLatin1String(s_defaultChain);
+    }
+
+    // Same limits as the BQM tool.
+
+    const bool useWorkers = parser.isSet(workersOption);
+    GmicBqmScheduler::setLimits(parser.value(jobsOption).toInt(), 0);
+    GmicBqmResultCache::setMaxSize(parser.value(cacheOption).toInt());
+
+    const int jobs    = GmicBqmScheduler::maxJobs();
+    const int threads = GmicBqmScheduler::threadsPerJob();
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(jobs);
+
+    QJsonArray chainReports;
+
+    for (const QString& chain : qAsConst(chains))
+    {
+        const QStringList stages = parseChain(chain);
+
+        if (stages.isEmpty())
+        {
+            continue;
+        }
+
+        qCDebug(DIGIKAM_TESTS_LOG) << "Benchmarking" << stages << "on" << paths.size() << "images";
+
+        QVector<JobResult> results(paths.size());
+        QElapsedTimer timer;
+        timer.start();
+
+        for (int i = 0 ; i < paths.size() ; ++i)
+        {
+            pool.start(new BenchmarkJob(paths[i], stages, threads, useWorkers, &results[i]));
+        }
+
+        pool.waitForDone();
+
+        const double wallSeconds = timer.nsecsElapsed() / 1.0e9;
+
+        QList<double> latencies;
+        double loadMs = 0.0;
+        int failed    = 0;
+
+        for (const JobResult& result : qAsConst(results))
+        {
+            if (result.completed)
+            {
+                latencies << result.processMs;
+                loadMs    += result.loadMs;
+            }
+            else
+            {
+                ++failed;
+            }
+        }
+
+        QJsonObject latency;
+        latency[QLatin1String("p50")] = percentile(latencies, 50.0);
+        latency[QLatin1String("p95")] = percentile(latencies, 95.0);
+        latency[QLatin1String("p99")] = percentile(latencies, 99.0);
+        latency[QLatin1String("max")] = percentile(latencies, 100.0);
+
+        QJsonObject report;
+        report[QLatin1String("chain")]             = chain;
+        report[QLatin1String("images")]            = latencies.size();
+        report[QLatin1String("failed")]            = failed;
+        report[QLatin1String("wall_seconds")]      = wallSeconds;
+        report[QLatin1String("images_per_second")] = (wallSeconds > 0.0) ? (latencies.size() / wallSeconds) : 0.0;
+        report[QLatin1String("latency_ms")]        = latency;
+        report[QLatin1String("mean_load_ms")]      = latencies.isEmpty() ? 0.0 : (loadMs / latencies.size());
+
+        if (!parser.isSet(noStagesOption) && !paths.isEmpty())
+        {
+            report[QLatin1String("stages_ms")]     = stageTimings(paths.constFirst(), stages, threads, useWorkers,
+                                                                  parser.value(cacheOption).toInt());
+        }
+
+        chainReports.append(report);
+    }
+
+    QJsonObject root;
+    root[QLatin1String("directory")]       = dir.absolutePath();
+    root[QLatin1String("jobs")]            = jobs;
+    root[QLatin1String("threads_per_job")] = threads;
+    root[QLatin1String("workers")]         = useWorkers;
+    root[QLatin1String("result_cache_mb")] = parser.value(cacheOption).toInt();
+    root[QLatin1String("chains")]          = chainReports;
+    root[QLatin1String("peak_rss_bytes")]  = (double)peakResidentMemory();      // Worker processes not included.
+
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+
+    if (parser.isSet(outputOption))
+    {
+        QFile file(parser.value(outputOption));
+
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            qCWarning(DIGIKAM_TESTS_LOG) << "Cannot write" << file.fileName();
+
+            return -1;
+        }
+
+        file.write(json);
+    }
+    else
+    {
+        QTextStream(stdout) << QString::fromUtf8(json);
+    }
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2026-10-17
+ * Description : digiKam GmicQt tests for the parsing of the G'MIC filters definitions in sections.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+// C++ includes
+
+#include <limits>
+
+// Qt includes
+
+#include <QApplication>
+#include <QByteArray>
+#include <QMap>
+#include <QStringList>
+
+// digiKam includes
+
+#include "digikam_debug.h"
+
+// local includes
+
+#include "FilterSelector/FiltersModel.h"
+#include "FilterSelector/FiltersModelReader.h"
+#include "GmicStdlib.h"
+
+namespace DigikamBqmGmicQtPlugin
+{
+
+QString s_imagePath;
+
+} // namespace DigikamBqmGmicQtPlugin
+
+using namespace GmicQt;
+
+namespace
+{
+
+/**
+ * Folders closed with '_' prefixes right before filters (and beyond the top level), parameters
+ * continued on the next line with a '\', and a separator back to the top level.
+ * With small sections, the stdlib is split at each of these lines that can start a section.
+ */
+const char* const s_source =
+    "#@gui Top\n"
+    "#@gui Sub\n"
+    "#@gui Filter A : fa, fa_preview\n"
+    "#@gui : Size = int(2,0,10)\n"
+    "#@gui _Other\n"
+    "#@gui Filter B : fb, fb_preview(0)\n"
+    "#@gui : Text = text(\"a\\\n"
+    "#@gui Not a filter : b\")\n"
+    "#@gui __\n"
+    "#@gui Filter C : fc, fc\n"
+    "#@gui : Mode = choice(\"x\",\"y\")\n"
+    "fc :\n"
+    "  mirror x\n"
+    "#@gui ____\n"
+    "#@gui Root filter : fr, fr\n"
+    "#@gui Folder\n"
+    "#@gui _\n"
+    "#@gui __Other top\n"
+    "#@gui Filter D : fd, fd(2+)\n"
+    "#@gui ________________________________________________________________________________\n"
+    "#@gui Filter E : fe, fe\n"
+    "#@gui : Value = float(0.5,0,1)\n";
+
+/**
+ * The filters of a model, by hash, with everything read from their definition.
+ */
+QMap<QString, QString> parse(const QByteArray& stdlib, qint64 sectionSize)
+{
+    FiltersModel model;
+    FiltersModelReader(model).parseFiltersDefinitions(stdlib, sectionSize);
+
+    QMap<QString, QString> filters;
+
+    for (const FiltersModel::Filter& filter : model)
+    {
+        filters.insert(filter.hash(), QStringList({ filter.absolutePathNoTags(),
+                                                    filter.command(),
+                                                    filter.previewCommand(),
+                                                    filter.parameters(),
+                                                    QString::number(filter.previewFactor()),
+                                                    QString::number(filter.isAccurateIfZoomed()),
+                                                    QString::number(filter.previewFromFullImage()),
+                                                    QString::number(filter.tileHalo()),
+                                                    QString::number(filter.isWarning()),
+                                                    QString::number((int)filter.defaultInputMode()) }).join(QLatin1Char('\n')));
+    }
+
+    return filters;
+}
+
+/**
+ * Parsing in sections of any size gives the same filters as parsing the stdlib as a single section.
+ */
+bool testSections(const char* const name, const QByteArray& stdlib, int minimumFilters)
+{
+    const QMap<QString, QString> reference = parse(stdlib, std::numeric_limits<qint64>::max());
+    bool passed                            = (reference.size() >= minimumFilters);
+
+    for (const qint64 sectionSize : { (qint64)1, (qint64)4096, (qint64)0 })
+    {
+        const QMap<QString, QString> filters = parse(stdlib, sectionSize);
+
+        if (filters != reference)
+        {
+            qCDebug(DIGIKAM_TESTS_LOG) << "Sections of" << sectionSize << "bytes differ from a single section for" << name;
+
+            for (QMap<QString, QString>::const_iterator it = reference.constBegin() ; it != reference.constEnd() ; ++it)
+            {
+                if (filters.value(it.key()) != it.value())
+                {
+                    qCDebug(DIGIKAM_TESTS_LOG) << "Expected:" << it.value() << "got:" << filters.value(it.key());
+                    break;
+                }
+            }
+
+            passed = false;
+        }
+    }
+
+    qCDebug(DIGIKAM_TESTS_LOG) << (passed ? "PASS" : "FAIL") << name << "(" << reference.size() << "filters )";
+
+    return passed;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QApplication app(argc, argv);
+
+    GmicStdLib::loadStdLib();
+
+    int failures = 0;
+
+    failures += !testSections("test source", QByteArray(s_source), 6);
+    failures += !testSections("stdlib",      GmicStdLib::current(), 100);
+
+    return (failures ? 1 : 0);
+}
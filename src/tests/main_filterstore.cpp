@@ -0,0 +1,420 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2026-10-17
+ * Description : digiKam GmicQt tests for the journaled storage of the G'MIC filters tree.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+// Qt includes
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTemporaryDir>
+
+// digiKam includes
+
+#include "digikam_debug.h"
+
+// local includes
+
+#include "gmicfilternode.h"
+#include "gmicfilterstore.h"
+
+using namespace DigikamBqmGmicQtPlugin;
+
+namespace
+{
+
+GmicFilterNode* addNode(GmicFilterNode* const parent,
+                        GmicFilterNode::Type type,
+                        const QString& title,
+                        int commandSize = 16)
+{
+    GmicFilterNode* const node = new GmicFilterNode(type, parent);
+    node->title                = title;
+    node->dateAdded            = QDateTime::currentDateTime();
+
+    if (type == GmicFilterNode::Item)
+    {
+        node->commands.insert(title, QString(commandSize, QLatin1Char('x')));
+    }
+
+    return node;
+}
+
+GmicFilterNode* rootFolder(GmicFilterNode* const root)
+{
+    return root->children().first();
+}
+
+/**
+ * Create the children of a folder as GmicFilterManager::fetchChildren() does.
+ */
+void fetchChildren(GmicFilterStore& store, GmicFilterNode* const node)
+{
+    const QList<GmicFilterNode*> children = store.readChildren(node);
+
+    for (GmicFilterNode* const child : children)
+    {
+        node->add(child);
+    }
+}
+
+void fetchAll(GmicFilterStore& store, GmicFilterNode* const node)
+{
+    fetchChildren(store, node);
+
+    const QList<GmicFilterNode*> children = node->children();
+
+    for (GmicFilterNode* const child : children)
+    {
+        fetchAll(store, child);
+    }
+}
+
+/**
+ * Save a large node until the journal is compacted, which is when its size decreases.
+ */
+bool compactByWrites(GmicFilterStore& store, GmicFilterNode* const root, GmicFilterNode* const item)
+{
+    qint64 previous = 0;
+
+    for (int i = 0 ; i < 20 ; ++i)
+    {
+        item->desc = QString::number(i);
+
+        if (!store.write(root, QString()))
+        {
+            return false;
+        }
+
+        const qint64 size = QFileInfo(store.fileName()).size();
+
+        if (size < previous)
+        {
+            return true;
+        }
+
+        previous = size;
+    }
+
+    return false;
+}
+
+QStringList titles(const GmicFilterNode* const node)
+{
+    QStringList list;
+    const QList<GmicFilterNode*> children = node->children();
+
+    for (GmicFilterNode* const child : children)
+    {
+        list << child->title;
+    }
+
+    return list;
+}
+
+/**
+ * The children of a folder are only created when requested.
+ */
+bool testLazyFetch(const QString& fileName)
+{
+    QString path;
+
+    {
+        GmicFilterStore store(fileName);
+        GmicFilterNode* const root   = store.read(path);
+        GmicFilterNode* const folder = addNode(rootFolder(root), GmicFilterNode::Folder, QLatin1String("Folder"));
+        addNode(folder, GmicFilterNode::Item, QLatin1String("Item 1"));
+        addNode(folder, GmicFilterNode::Item, QLatin1String("Item 2"));
+        addNode(folder, GmicFilterNode::Item, QLatin1String("Item 3"));
+
+        const bool written = store.write(root, QLatin1String("/Folder/Item 2"));
+        delete root;
+
+        if (!written)
+        {
+            return false;
+        }
+    }
+
+    GmicFilterStore store(fileName);
+    GmicFilterNode* const root = store.read(path);
+    GmicFilterNode* const top  = rootFolder(root);
+    bool passed                = (path == QLatin1String("/Folder/Item 2")) &&
+                                 top->children().isEmpty() && (store.pendingChildren(top) == 1);
+
+    fetchChildren(store, top);
+    GmicFilterNode* const folder = top->children().value(0);
+    passed                      &= folder && (folder->title == QLatin1String("Folder")) &&
+                                   folder->children().isEmpty() && (store.pendingChildren(folder) == 3);
+
+    if (folder)
+    {
+        fetchChildren(store, folder);
+        passed &= (store.pendingChildren(folder) == 0) &&
+                  (titles(folder) == (QStringList() << QLatin1String("Item 1")
+                                                    << QLatin1String("Item 2")
+                                                    << QLatin1String("Item 3")));
+    }
+
+    delete root;
+
+    return passed;
+}
+
+/**
+ * Records following the last commit, left by an interrupted save, are ignored and overwritten.
+ */
+bool testCrashRecovery(const QString& fileName)
+{
+    QString path;
+
+    {
+        GmicFilterStore store(fileName);
+        GmicFilterNode* const root = store.read(path);
+        addNode(rootFolder(root), GmicFilterNode::Item, QLatin1String("Committed"));
+
+        const bool written = store.write(root, path);
+        delete root;
+
+        if (!written)
+        {
+            return false;
+        }
+    }
+
+    // A node record and a partial folder record, without commit record.
+
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::Append))
+    {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream << (quint8)'N' << (quint32)1000 << (quint32)4;
+    stream.writeRawData("abcd", 4);
+    stream << (quint8)'O' << (quint32)0 << (quint32)64;
+    file.close();
+
+    bool passed = true;
+
+    {
+        GmicFilterStore store(fileName);
+        GmicFilterNode* const root = store.read(path);
+        fetchAll(store, root);
+        passed                    &= store.errorString().isEmpty() &&
+                                     (titles(rootFolder(root)) == QStringList(QLatin1String("Committed")));
+
+        addNode(rootFolder(root), GmicFilterNode::Item, QLatin1String("Added"));
+        passed &= store.write(root, path);
+        delete root;
+    }
+
+    GmicFilterStore store(fileName);
+    GmicFilterNode* const root = store.read(path);
+    fetchAll(store, root);
+    passed                    &= store.errorString().isEmpty() &&
+                                 (titles(rootFolder(root)) == (QStringList() << QLatin1String("Committed")
+                                                                             << QLatin1String("Added")));
+    delete root;
+
+    return passed;
+}
+
+/**
+ * Saving the same large node many times compacts the journal, without changing the tree.
+ */
+bool testCompaction(const QString& fileName)
+{
+    QString path;
+    bool passed = true;
+
+    {
+        GmicFilterStore store(fileName);
+        GmicFilterNode* const root   = store.read(path);
+        GmicFilterNode* const folder = addNode(rootFolder(root), GmicFilterNode::Folder, QLatin1String("Folder"));
+        addNode(folder, GmicFilterNode::Item, QLatin1String("Small"));
+        GmicFilterNode* const item   = addNode(rootFolder(root), GmicFilterNode::Item, QLatin1String("Large"), 200000);
+        qint64 largest               = 0;
+
+        for (int i = 0 ; i < 20 ; ++i)
+        {
+            item->desc = QString::number(i);
+            passed    &= store.write(root, path);
+            largest    = qMax(largest, QFileInfo(fileName).size());
+        }
+
+        // 20 versions of a node of 400 KB, which can only fit once compacted.
+
+        passed &= (largest < 4 * 1024 * 1024);
+        delete root;
+    }
+
+    GmicFilterStore store(fileName);
+    GmicFilterNode* const root = store.read(path);
+    fetchAll(store, root);
+
+    const QList<GmicFilterNode*> children = rootFolder(root)->children();
+    passed                               &= (children.size() == 2) &&
+                                            (children.at(0)->title == QLatin1String("Folder")) &&
+                                            (titles(children.at(0)) == QStringList(QLatin1String("Small"))) &&
+                                            (children.at(1)->desc == QLatin1String("19"));
+    delete root;
+
+    return passed;
+}
+
+/**
+ * A folder removed then restored by the undo stack after a compaction is written again.
+ */
+bool testUndoRemovalAfterCompaction(const QString& fileName)
+{
+    QString path;
+    bool passed = true;
+
+    {
+        GmicFilterStore store(fileName);
+        GmicFilterNode* const root   = store.read(path);
+        GmicFilterNode* const top    = rootFolder(root);
+        GmicFilterNode* const folder = addNode(top, GmicFilterNode::Folder, QLatin1String("Removed"));
+        addNode(folder, GmicFilterNode::Item, QLatin1String("Child 1"));
+        addNode(folder, GmicFilterNode::Item, QLatin1String("Child 2"));
+        GmicFilterNode* const item   = addNode(top, GmicFilterNode::Item, QLatin1String("Large"), 200000);
+        passed                      &= store.write(root, path);
+
+        // Removal as done by RemoveGmicFilter: the node is kept for undo.
+
+        top->remove(folder);
+        passed &= store.write(root, path);
+        passed &= compactByWrites(store, root, item);
+
+        top->add(folder, 0);
+        passed &= store.write(root, path);
+        delete root;
+    }
+
+    GmicFilterStore store(fileName);
+    GmicFilterNode* const root = store.read(path);
+    fetchAll(store, root);
+
+    const GmicFilterNode* const folder = rootFolder(root)->children().value(0);
+    passed                            &= folder && (folder->title == QLatin1String("Removed")) &&
+                                         (titles(folder) == (QStringList() << QLatin1String("Child 1")
+                                                                           << QLatin1String("Child 2")));
+    delete root;
+
+    return passed;
+}
+
+/**
+ * Two stores sharing a journal keep the changes of each other, including after a compaction.
+ */
+bool testSharedJournal(const QString& fileName)
+{
+    QString path;
+    bool passed = true;
+
+    {
+        GmicFilterStore store(fileName);
+        GmicFilterNode* const root   = store.read(path);
+        GmicFilterNode* const folder = addNode(rootFolder(root), GmicFilterNode::Folder, QLatin1String("Shared"));
+        addNode(folder, GmicFilterNode::Item, QLatin1String("Shared item"));
+        passed                      &= store.write(root, path);
+        delete root;
+    }
+
+    GmicFilterStore first(fileName);
+    GmicFilterStore second(fileName);
+    GmicFilterNode* const firstRoot  = first.read(path);
+    GmicFilterNode* const secondRoot = second.read(path);
+    fetchChildren(first,  rootFolder(firstRoot));
+    fetchChildren(second, rootFolder(secondRoot));
+
+    addNode(rootFolder(firstRoot),  GmicFilterNode::Item, QLatin1String("First"));
+    passed &= first.write(firstRoot, path);
+    addNode(rootFolder(secondRoot), GmicFilterNode::Item, QLatin1String("Second"));
+    passed &= second.write(secondRoot, path);
+
+    // Compact the journal from the first store, then read the folder not created yet in the second one.
+
+    GmicFilterNode* const item   = addNode(rootFolder(firstRoot), GmicFilterNode::Item, QLatin1String("Large"), 200000);
+    passed                      &= compactByWrites(first, firstRoot, item);
+    GmicFilterNode* const shared = rootFolder(secondRoot)->children().value(0);
+    passed                      &= shared && (second.pendingChildren(shared) == 1) && titles(shared).isEmpty();
+
+    if (shared)
+    {
+        fetchChildren(second, shared);
+        passed &= (titles(shared) == QStringList(QLatin1String("Shared item")));
+    }
+
+    delete firstRoot;
+    delete secondRoot;
+
+    GmicFilterStore store(fileName);
+    GmicFilterNode* const root = store.read(path);
+    fetchAll(store, root);
+    passed                    &= (titles(rootFolder(root)) == (QStringList() << QLatin1String("Shared")
+                                                                             << QLatin1String("First")
+                                                                             << QLatin1String("Large")
+                                                                             << QLatin1String("Second")));
+    delete root;
+
+    return passed;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QTemporaryDir dir;
+
+    if (!dir.isValid())
+    {
+        qCDebug(DIGIKAM_TESTS_LOG) << "Cannot create a temporary directory";
+
+        return 1;
+    }
+
+    typedef bool (*Test)(const QString&);
+
+    const QList<QPair<const char*, Test> > tests =
+    {
+        { "Lazy fetch",                         testLazyFetch                  },
+        { "Crash recovery",                     testCrashRecovery              },
+        { "Compaction",                         testCompaction                 },
+        { "Undo of a removal after compaction", testUndoRemovalAfterCompaction },
+        { "Shared journal",                     testSharedJournal              },
+    };
+
+    int failures = 0;
+
+    for (int i = 0 ; i < tests.size() ; ++i)
+    {
+        const QString fileName = dir.filePath(QString::fromLatin1("test%1.journal").arg(i));
+        const bool passed      = tests.at(i).second(fileName);
+        qCDebug(DIGIKAM_TESTS_LOG) << (passed ? "PASS" : "FAIL") << tests.at(i).first;
+
+        if (!passed)
+        {
+            ++failures;
+        }
+    }
+
+    return failures;
+}
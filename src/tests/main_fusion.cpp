@@ -0,0 +1,190 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2026-10-17
+ * Description : digiKam GmicQt tests for the fusion of pointwise G'MIC commands.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+// C++ includes
+
+#include <cstring>
+
+// Qt includes
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+// digiKam includes
+
+#include "digikam_debug.h"
+
+// local includes
+
+#include "gmic.h"
+
+namespace
+{
+
+size_t imageSize(const gmic_image<float>& img)
+{
+    return ((size_t)img._width * img._height * img._depth * img._spectrum);
+}
+
+/**
+ * Pipelines run with and without fusion of pointwise commands.
+ * They mix fusable runs with commands that must break a run
+ * (image or formula arguments, percentages, 'get' variants, selection changes).
+ */
+const char* const s_pipelines[] =
+{
+    "+ 10 * 1.2 cut 0,255 round",
+    "+ 10 * 1.2 c 0,255 round 0.5,1 - 3",
+    "-add 3 -mul 0.7 -sub 1 -div 3 -pow 2 -pow 0.5 -pow 3 -pow -1 -pow 1.7 -pow 0",
+    "/ 77 ^ -2 ^ -0.5 ^ 4 ^ -3 ^ -4 ^ 1 abs sign",
+    "% 7 min 3 max 1 sqr sqrt exp log log2 log10",
+    "cos sin tan * 100 round 1,-1 round 3 round 0",
+    "+[0] 3 *[0] 2 +[1] 5 *. 3 +.. 1 *.. 4",
+    "+ 1 round + 2",
+    "+ 1 + [0] * 3 / 2",
+    "+ 1 * 2 + '{1+1}' * 3 abs",
+    "+ 1 * 2% + 3",
+    "+ 1 abs +abs +abs * 3",
+    "c 255,0 * 2 cut 100,50 + 1",
+    "min 10 max 20 round",
+    "add 1 sub 2 mul 3 div 4 mod 5 pow 2",
+    "+ 1 * 2 round 2,5",
+};
+
+/**
+ * Return false if the pipeline fails: all the pipelines are valid,
+ * an error in both modes would otherwise compare equal.
+ */
+bool runPipeline(const char* const pipeline,
+                 gmic_list<float>& images,
+                 bool allowFusion)
+{
+    gmic_list<char> names;
+    gmic interpreter;
+    interpreter.allow_fusion = allowFusion;
+
+    images.assign(2);
+    images[0].assign(63, 41, 1, 3);
+    images[1].assign(17, 9, 2, 1);
+
+    for (unsigned int l = 0 ; l < images._width ; ++l)
+    {
+        for (size_t off = 0 ; off < imageSize(images[l]) ; ++off)
+        {
+            images[l]._data[off] = (float)((off * 7919) % 1000) / 7.3F - 40.0F;
+        }
+    }
+
+    try
+    {
+        interpreter.run(pipeline, images, names);
+    }
+    catch (gmic_exception& e)
+    {
+        qCDebug(DIGIKAM_TESTS_LOG) << "G'MIC error" << (allowFusion ? "with fusion:" : "without fusion:") << e.what();
+
+        return false;
+    }
+
+    return true;
+}
+
+bool isBitIdentical(const gmic_list<float>& a, const gmic_list<float>& b)
+{
+    if (a._width != b._width)
+    {
+        return false;
+    }
+
+    for (unsigned int l = 0 ; l < a._width ; ++l)
+    {
+        if ((a[l]._width  != b[l]._width) || (a[l]._height   != b[l]._height) ||
+            (a[l]._depth  != b[l]._depth) || (a[l]._spectrum != b[l]._spectrum))
+        {
+            return false;
+        }
+
+        if (std::memcmp(a[l]._data, b[l]._data, imageSize(a[l]) * sizeof(float)))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int failures = 0;
+
+    for (const char* const pipeline : s_pipelines)
+    {
+        gmic_list<float> reference, fused;
+        const bool referenceDone = runPipeline(pipeline, reference, false);
+        const bool fusedDone     = runPipeline(pipeline, fused,     true);
+
+        const bool passed        = referenceDone && fusedDone && isBitIdentical(reference, fused);
+        qCDebug(DIGIKAM_TESTS_LOG) << (passed ? "PASS" : "FAIL") << pipeline;
+
+        if (!passed)
+        {
+            ++failures;
+        }
+    }
+
+    // Timings on a 12 MP RGB image, for a memory-bound chain of pointwise commands.
+
+    for (int fusion = 0 ; fusion < 2 ; ++fusion)
+    {
+        gmic_list<float> images;
+        gmic_list<char> names;
+        images.assign(1);
+        images[0].assign(4000, 3000, 1, 3);
+
+        for (size_t off = 0 ; off < imageSize(images[0]) ; ++off)
+        {
+            images[0]._data[off] = (float)(off % 511);
+        }
+
+        gmic interpreter;
+        interpreter.allow_fusion = (fusion == 1);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        try
+        {
+            interpreter.run("+ 10 * 1.2 cut 0,255 round - 3 abs", images, names);
+        }
+        catch (gmic_exception& e)
+        {
+            qCDebug(DIGIKAM_TESTS_LOG) << "FAIL timing run:" << e.what();
+            ++failures;
+
+            continue;
+        }
+
+        qCDebug(DIGIKAM_TESTS_LOG) << "Fusion" << (fusion ? "enabled:" : "disabled:") << timer.elapsed() << "ms";
+    }
+
+    qCDebug(DIGIKAM_TESTS_LOG) << failures << "failure(s)";
+
+    // Non-zero exit code on any mismatch or error.
+
+    return (failures ? 1 : 0);
+}
@@ -0,0 +1,290 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2026-10-17
+ * Description : digiKam GmicQt micro-benchmark of DImg <-> CImg conversions,
+ *               checked against the former scalar conversions.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+// C++ includes
+
+#include <cmath>
+#include <cstring>
+
+// Qt includes
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+// digiKam includes
+
+#include "digikam_debug.h"
+#include "dimg.h"
+
+// local includes
+
+#include "gmicqtimageconverter.h"
+
+using namespace Digikam;
+using namespace DigikamGmicQtPluginCommon;
+
+namespace
+{
+
+/**
+ * Default benchmark image size (60 MP), can be changed with the first command line argument (in MP).
+ */
+const int s_defaultMegaPixels = 60;
+const int s_iterations        = 3;
+
+DImg createImage(int width, int height, bool sixteenBit, bool alpha)
+{
+    DImg img(width, height, sixteenBit, alpha);
+    uchar* const bits = img.bits();
+    const size_t size = img.numBytes();
+
+    if (sixteenBit)
+    {
+        // With an alpha channel, the channels together hold all the 16-bit values.
+
+        unsigned short* const values = reinterpret_cast<unsigned short*>(bits);
+
+        for (size_t i = 0 ; i < size / 2 ; ++i)
+        {
+            values[i] = (unsigned short)(i * 7919);
+        }
+    }
+    else
+    {
+        for (size_t i = 0 ; i < size ; ++i)
+        {
+            bits[i] = (uchar)((i * 7919) >> 3);
+        }
+    }
+
+    // Without alpha channel, the converters write opaque pixels.
+
+    if (!alpha)
+    {
+        const int depth = sixteenBit ? 2 : 1;
+
+        for (size_t i = 3 * depth ; i < size ; i += 4 * depth)
+        {
+            std::memset(bits + i, 0xFF, depth);
+        }
+    }
+
+    return img;
+}
+
+bool sameBits(const DImg& a, const DImg& b)
+{
+    return ((a.numBytes() == b.numBytes()) && !std::memcmp(a.bits(), b.bits(), a.numBytes()));
+}
+
+bool sameBits(const cimg_library::CImg<float>& a, const cimg_library::CImg<float>& b)
+{
+    return (a.is_sameXYZC(b) && !std::memcmp(a.data(), b.data(), a.size() * sizeof(float)));
+}
+
+// --- Scalar conversions as done before the vectorized converters, used as references ----------------
+
+inline unsigned char legacyFloat2uchar(float in)
+{
+    return ((in < 0.0f) ? 0 : (in > 255.0f) ? 255 : static_cast<unsigned char>(in));
+}
+
+inline unsigned short legacyFloat2ushort(float in)
+{
+    return ((in < 0.0f) ? 0 : (in > 65535.0f) ? 65535 : static_cast<unsigned short>(in));
+}
+
+DImg legacyCImgtoDImg(const cimg_library::CImg<float>& in, bool sixteenBit)
+{
+    const bool alpha  = ((in.spectrum() == 4) || (in.spectrum() == 2));
+    const bool color  = (in.spectrum() >= 3);
+    DImg out(in.width(), in.height(), sixteenBit, alpha);
+
+    const float* srcR = in.data(0, 0, 0, 0);
+    const float* srcG = color ? in.data(0, 0, 0, 1) : srcR;
+    const float* srcB = color ? in.data(0, 0, 0, 2) : srcR;
+    const float* srcA = alpha ? in.data(0, 0, 0, in.spectrum() - 1) : nullptr;
+
+    for (int y = 0 ; y < (int)out.height() ; ++y)
+    {
+        for (int x = 0 ; x < in.width() ; ++x)
+        {
+            const size_t off = (size_t)y * in.width() + x;
+
+            if (sixteenBit)
+            {
+                unsigned short* const dst = reinterpret_cast<unsigned short*>(out.scanLine(y)) + 4 * x;
+                dst[2]                    = legacyFloat2ushort(srcR[off]) * 256;
+                dst[1]                    = legacyFloat2ushort(srcG[off]) * 256;
+                dst[0]                    = legacyFloat2ushort(srcB[off]) * 256;
+                dst[3]                    = alpha ? legacyFloat2ushort(srcA[off]) * 256 : 0xFFFF;
+            }
+            else
+            {
+                unsigned char* const dst  = out.scanLine(y) + 4 * x;
+                dst[2]                    = legacyFloat2uchar(srcR[off]);
+                dst[1]                    = legacyFloat2uchar(srcG[off]);
+                dst[0]                    = legacyFloat2uchar(srcB[off]);
+                dst[3]                    = alpha ? legacyFloat2uchar(srcA[off]) : 0xFF;
+            }
+        }
+    }
+
+    return out;
+}
+
+void legacyDImgtoCImg(const DImg& in, cimg_library::CImg<float>& out)
+{
+    const int w      = in.width();
+    const int h      = in.height();
+    const bool alpha = in.hasAlpha();
+    out.assign(w, h, 1, alpha ? 4 : 3);
+
+    float* dstR      = out.data(0, 0, 0, 0);
+    float* dstG      = out.data(0, 0, 0, 1);
+    float* dstB      = out.data(0, 0, 0, 2);
+    float* dstA      = alpha ? out.data(0, 0, 0, 3) : nullptr;
+
+    for (int y = 0 ; y < h ; ++y)
+    {
+        for (int x = 0 ; x < w ; ++x)
+        {
+            if (in.sixteenBit())
+            {
+                const unsigned short* const src = reinterpret_cast<const unsigned short*>(in.scanLine(y)) + 4 * x;
+                *dstB++                         = static_cast<float>(src[0] / 255.0);
+                *dstG++                         = static_cast<float>(src[1] / 255.0);
+                *dstR++                         = static_cast<float>(src[2] / 255.0);
+
+                if (alpha)
+                {
+                    *dstA++ = static_cast<float>(src[3] / 255.0);
+                }
+            }
+            else
+            {
+                const unsigned char* const src  = in.scanLine(y) + 4 * x;
+                *dstB++                         = static_cast<float>(src[0]);
+                *dstG++                         = static_cast<float>(src[1]);
+                *dstR++                         = static_cast<float>(src[2]);
+
+                if (alpha)
+                {
+                    *dstA++ = static_cast<float>(src[3]);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Float images as returned by filters: out of range and fractional values, 1 to 4 channels,
+ * converted to 8 and 16-bit DImg. The odd width exercises the scalar tails of the kernels.
+ */
+int checkFloatInputs()
+{
+    int failures = 0;
+
+    for (int spectrum = 1 ; spectrum <= 4 ; ++spectrum)
+    {
+        cimg_library::CImg<float> input(1001, 333, 1, spectrum);
+
+        for (size_t off = 0 ; off < input.size() ; ++off)
+        {
+            input[off] = (float)((off * 7919) % 140000) / 1.7F - 3000.0F;
+        }
+
+        for (int sixteenBit = 0 ; sixteenBit < 2 ; ++sixteenBit)
+        {
+            DImg output;
+            GMicQtImageConverter::convertCImgtoDImg(input, output, sixteenBit);
+
+            if (!sameBits(output, legacyCImgtoDImg(input, sixteenBit)))
+            {
+                qCDebug(DIGIKAM_TESTS_LOG) << "FAIL: float CImg with" << spectrum << "channels to"
+                                           << (sixteenBit ? "16-bit" : "8-bit") << "DImg differs from the former conversion";
+                ++failures;
+            }
+        }
+    }
+
+    return failures;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const int megaPixels = (argc > 1) ? qMax(1, QString::fromLatin1(argv[1]).toInt()) : s_defaultMegaPixels;
+    const int width      = 3 * (int)std::sqrt(megaPixels * 1000000.0 / 6.0);
+    const int height     = (megaPixels * 1000000) / width;
+    int failures         = checkFloatInputs();
+
+    for (int sixteenBit = 0 ; sixteenBit < 2 ; ++sixteenBit)
+    {
+        for (int alpha = 0 ; alpha < 2 ; ++alpha)
+        {
+            const DImg input    = createImage(width, height, sixteenBit, alpha);
+            cimg_library::CImg<float> cimg, legacyCImg;
+            DImg output, legacyOutput;
+            qint64 toCImg       = 0;
+            qint64 toDImg       = 0;
+            qint64 legacyToCImg = 0;
+            qint64 legacyToDImg = 0;
+
+            for (int i = 0 ; i < s_iterations ; ++i)
+            {
+                QElapsedTimer timer;
+                timer.start();
+                GMicQtImageConverter::convertDImgtoCImg(input, cimg);
+                toCImg       += timer.restart();
+                GMicQtImageConverter::convertCImgtoDImg(cimg, output, sixteenBit);
+                toDImg       += timer.restart();
+                legacyDImgtoCImg(input, legacyCImg);
+                legacyToCImg += timer.restart();
+                legacyOutput  = legacyCImgtoDImg(legacyCImg, sixteenBit);
+                legacyToDImg += timer.elapsed();
+            }
+
+            // Both directions are bit-identical to the former conversions, and 8-bit round trips are lossless.
+
+            if (!sameBits(cimg, legacyCImg) || !sameBits(output, legacyOutput))
+            {
+                qCDebug(DIGIKAM_TESTS_LOG) << "FAIL: conversions differ from the former ones";
+                ++failures;
+            }
+
+            if (!sixteenBit && !sameBits(output, input))
+            {
+                qCDebug(DIGIKAM_TESTS_LOG) << "FAIL: 8-bit round trip is not lossless";
+                ++failures;
+            }
+
+            qCDebug(DIGIKAM_TESTS_LOG) << width << "x" << height
+                                       << (sixteenBit ? "16-bit" : "8-bit")
+                                       << (alpha ? "RGBA" : "RGB")
+                                       << ": DImg->CImg" << toCImg / s_iterations << "ms"
+                                       << "(former:" << legacyToCImg / s_iterations << "ms),"
+                                       << "CImg->DImg" << toDImg / s_iterations << "ms"
+                                       << "(former:" << legacyToDImg / s_iterations << "ms)";
+        }
+    }
+
+    qCDebug(DIGIKAM_TESTS_LOG) << failures << "failure(s)";
+
+    return (failures ? 1 : 0);
+}
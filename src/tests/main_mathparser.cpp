@@ -0,0 +1,121 @@
+/* ============================================================
+ *
+ * This file is a part of digiKam project
+ * https://www.digikam.org
+ *
+ * Date        : 2026-10-17
+ * Description : digiKam GmicQt tests for the optimization of G'MIC math expressions.
+ *
+ * SPDX-FileCopyrightText: 2019-2025 by Gilles Caulier <caulier dot gilles at gmail dot com>
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * ============================================================ */
+
+// C++ includes
+
+#include <cmath>
+#include <string>
+
+// Qt includes
+
+#include <QCoreApplication>
+
+// digiKam includes
+
+#include "digikam_debug.h"
+
+// local includes
+
+#include "gmic.h"
+
+namespace
+{
+
+/**
+ * Expressions evaluated with 'fill', with the value expected at each pixel (x,y).
+ * They reuse a vector component after an operator which rewrites the whole vector
+ * without referring to its components, so that a common subexpression must not be
+ * shared across this operator.
+ */
+struct Expression
+{
+    const char* expression;
+    double      (*expected)(double x, double y);
+};
+
+const Expression s_expressions[] =
+{
+    {
+        "V=[x,y,3];a=sqrt(V[0]+1);V=V*2;b=sqrt(V[0]+1);a+b",
+        [](double x, double) { return (std::sqrt(x + 1.0) + std::sqrt(2.0 * x + 1.0)); }
+    },
+    {
+        "V=[1,2,3,4];a=V[0]+x;V=sort(V,0);b=V[0]+x;a*100+b",
+        [](double x, double) { return ((1.0 + x) * 100.0 + 4.0 + x); }
+    },
+    {
+        "V=[x,y];a=V[1]+1;V+=5;b=V[1]+1;a*1000+b",
+        [](double, double y) { return ((y + 1.0) * 1000.0 + y + 6.0); }
+    },
+    {
+        "A=[x,1];B=[y,2];a=A[0]*3;swap(A,B);b=A[0]*3;a+b*1000",
+        [](double x, double y) { return (3.0 * x + 3000.0 * y); }
+    },
+    {
+        "V=[x,y];a=V[0]*2;V=[y,x];b=V[0]*2;a+b*100",
+        [](double x, double y) { return (2.0 * x + 200.0 * y); }
+    },
+    {
+        "V=[x,y];V[0]=7;s=sum(V);s+x",
+        [](double x, double y) { return (7.0 + y + x); }
+    },
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    int failures = 0;
+
+    for (const Expression& expression : s_expressions)
+    {
+        gmic_list<float> images;
+        gmic_list<char> names;
+        images.assign(1);
+        images[0].assign(16, 16, 1, 1, 0.0F);
+
+        bool passed = true;
+
+        try
+        {
+            gmic interpreter;
+            interpreter.run((std::string("fill \"") + expression.expression + "\"").c_str(), images, names);
+
+            for (unsigned int y = 0 ; (y < images[0]._height) && passed ; ++y)
+            {
+                for (unsigned int x = 0 ; (x < images[0]._width) && passed ; ++x)
+                {
+                    const float expected = (float)expression.expected(x, y);
+                    passed               = (std::fabs(images[0](x, y) - expected) <= 1e-4F * std::fabs(expected) + 1e-4F);
+                }
+            }
+        }
+        catch (gmic_exception& e)
+        {
+            qCDebug(DIGIKAM_TESTS_LOG) << "G'MIC error:" << e.what();
+            passed = false;
+        }
+
+        qCDebug(DIGIKAM_TESTS_LOG) << (passed ? "PASS" : "FAIL") << expression.expression;
+
+        if (!passed)
+        {
+            ++failures;
+        }
+    }
+
+    return failures;
+}
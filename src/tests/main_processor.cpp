@@ -90,7 +90,8 @@ int main(int argc, char* argv[])
 
         qCDebug(DIGIKAM_DPLUGIN_BQM_LOG) << "GmicBqmTool: G'MIC filter completed:" << b;
 
-        gmicProcessor->outputImage().save(path + QLatin1String("_gmic.jpg"), "JPG");
+        gmicProcessor->outputImage(img);
+        img.save(path + QLatin1String("_gmic.jpg"), "JPG");
 
         delete gmicProcessor;
     }